@@ -1,12 +1,20 @@
 #include "controller/dataset.hpp"
+#include "util/atomic_file.hpp"
+#include <QDebug>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QStandardPaths>
 
-static const char* kAppDir = ".atlabelmaster";
-static const char* kCfg    = "config.json";
+static const char* kAppDir   = ".atlabelmaster";
+static const char* kCfg      = "config.json";
+static const char* kJournal  = "session.journal";
+static const char* kProgress = "progress.json";
+
+// 日志行格式：<op>\t<value>\n
+//   S 保存目录  I 图片目录  L 最后图片  P 当前图片目录的进度（相对 imageDir 的图片路径）
 namespace controller {
 
 DatasetManager& DatasetManager::instance() {
@@ -21,123 +29,182 @@ DatasetManager::DatasetManager() {
         auto doc = QJsonDocument::fromJson(f.readAll());
         f.close();
         if (doc.isObject()) {
-            auto o    = doc.object();
-            saveDir_  = o.value("save_dir").toString();
-            imageDir_ = o.value("image_dir").toString();
+            auto o     = doc.object();
+            saveDir_   = o.value("save_dir").toString();
+            imageDir_  = o.value("image_dir").toString();
+            lastImage_ = o.value("last_image").toString();
         }
     }
+    loadProgressFile();
+    replayJournal();
+
+    journal_.setFileName(journalPath());
+    if (!journal_.open(QIODevice::WriteOnly | QIODevice::Append))
+        qWarning() << "session journal unavailable:" << journal_.fileName();
 }
 
-QString DatasetManager::cfgPath() const {
+DatasetManager::~DatasetManager() { flush(); }
+
+QString DatasetManager::appDir() const {
     QString home = QDir::homePath();
     QDir d(home + "/" + kAppDir);
     if (!d.exists())
         d.mkpath(".");
-    return d.filePath(kCfg);
+    return d.absolutePath();
+}
+
+QString DatasetManager::cfgPath() const { return appDir() + "/" + kCfg; }
+QString DatasetManager::journalPath() const { return appDir() + "/" + kJournal; }
+// 未设置保存目录时进度落在 ~/.atlabelmaster/progress.json
+QString DatasetManager::progressPath() const {
+    return QDir(saveDir_.isEmpty() ? appDir() : saveDir_).filePath(kProgress);
+}
+
+void DatasetManager::loadProgressFile() {
+    progress_.clear();
+    QFile f(progressPath());
+    if (!f.exists() || !f.open(QIODevice::ReadOnly))
+        return;
+    auto doc = QJsonDocument::fromJson(f.readAll());
+    f.close();
+    if (!doc.isObject())
+        return;
+    const auto o = doc.object();
+    for (auto it = o.begin(); it != o.end(); ++it)
+        if (it.value().isString()) // 旧版本存的是目录树行号，没法换算，丢弃
+            progress_.insert(it.key(), it.value().toString());
+}
+
+void DatasetManager::replayJournal() {
+    QFile f(journalPath());
+    if (!f.exists() || !f.open(QIODevice::ReadOnly))
+        return;
+    const QList<QByteArray> lines = f.readAll().split('\n');
+    f.close();
+    for (const QByteArray& line : lines) {
+        if (line.size() < 2 || line.at(1) != '\t')
+            continue; // 末尾半行（崩溃时写了一半）直接忽略
+        const QString v = QString::fromUtf8(line.mid(2));
+        switch (line.at(0)) {
+        case 'S':
+            if (saveDir_ != v) {
+                saveDir_ = v;
+                loadProgressFile();
+            }
+            cfgDirty_ = true;
+            break;
+        case 'I':
+            imageDir_ = v;
+            cfgDirty_ = true;
+            break;
+        case 'L':
+            lastImage_ = v;
+            cfgDirty_  = true;
+            break;
+        case 'P':
+            if (!imageDir_.isEmpty()) {
+                progress_.insert(imageDir_, v);
+                progressDirty_ = true;
+            }
+            break;
+        default: break;
+        }
+    }
+}
+
+void DatasetManager::append(char op, const QString& value) {
+    if (!journal_.isOpen())
+        return;
+    QByteArray line = value.toUtf8();
+    line.prepend('\t').prepend(op).append('\n');
+    journal_.write(line);
+    journal_.flush(); // 只交给内核，不 fsync：进程崩溃可恢复，断电最多丢最后几行
 }
 
 void DatasetManager::setSaveDir(const QString& path) {
+    if (path == saveDir_)
+        return;
+    flush(); // 旧保存目录的进度先落盘
     saveDir_ = path;
-    // 写回配置（不改 progress）
-    QFile f(cfgPath());
-    QJsonObject o;
-    if (f.exists() && f.open(QIODevice::ReadOnly)) {
-        auto doc = QJsonDocument::fromJson(f.readAll());
-        f.close();
-        if (doc.isObject())
-            o = doc.object();
-    }
-    o.insert("save_dir", saveDir_);
-    if (!imageDir_.isEmpty())
-        o.insert("image_dir", imageDir_);
-    QFile f2(cfgPath());
-    if (f2.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        f2.write(QJsonDocument(o).toJson(QJsonDocument::Indented));
-        f2.close();
-    }
+    loadProgressFile();
+    cfgDirty_ = true;
+    append('S', path);
 }
 
 QString DatasetManager::saveDir() const { return saveDir_; }
 
 void DatasetManager::setImageDir(const QString& imageDir) {
+    if (imageDir == imageDir_)
+        return;
     imageDir_ = imageDir;
-    QFile f(cfgPath());
-    QJsonObject o;
-    if (f.exists() && f.open(QIODevice::ReadOnly)) {
-        auto doc = QJsonDocument::fromJson(f.readAll());
-        f.close();
-        if (doc.isObject())
-            o = doc.object();
-    }
-    o.insert("image_dir", imageDir_);
-    QFile f2(cfgPath());
-    if (f2.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        f2.write(QJsonDocument(o).toJson(QJsonDocument::Indented));
-        f2.close();
-    }
+    cfgDirty_ = true;
+    append('I', imageDir);
 }
 
 QString DatasetManager::imageDir() const { return imageDir_; }
 
-void DatasetManager::saveProgress(int currentIndex) {
-    if (saveDir_.isEmpty() || imageDir_.isEmpty())
+void DatasetManager::saveProgress(const QString& imagePath) {
+    if (imageDir_.isEmpty() || imagePath.isEmpty())
         return;
+    const QString rel = QDir(imageDir_).relativeFilePath(imagePath);
+    auto it           = progress_.find(imageDir_);
+    if (it != progress_.end() && it.value() == rel)
+        return;
+    progress_.insert(imageDir_, rel);
+    progressDirty_ = true;
+    append('P', rel);
+}
 
-    // 写进 saveDir/progress.json（按 imageDir 记 key）
-    QDir d(saveDir_);
-    if (!d.exists())
-        d.mkpath(".");
-    QString p = d.filePath("progress.json");
+QString DatasetManager::loadProgress() const {
+    const QString rel = imageDir_.isEmpty() ? QString() : progress_.value(imageDir_);
+    return rel.isEmpty() ? QString() : QDir(imageDir_).absoluteFilePath(rel);
+}
 
-    QJsonObject o;
-    QFile f(p);
-    if (f.exists() && f.open(QIODevice::ReadOnly)) {
-        auto doc = QJsonDocument::fromJson(f.readAll());
-        f.close();
-        if (doc.isObject())
-            o = doc.object();
-    }
-    o.insert(imageDir_, currentIndex);
+void DatasetManager::setLastImage(const QString& imagePath) {
+    if (imagePath == lastImage_)
+        return;
+    lastImage_ = imagePath;
+    cfgDirty_  = true;
+    append('L', imagePath);
+}
 
-    QFile f2(p);
-    if (f2.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        f2.write(QJsonDocument(o).toJson(QJsonDocument::Indented));
-        f2.close();
-    }
+QString DatasetManager::lastImage() const { return lastImage_; }
+
+void DatasetManager::flush() {
+    if (!cfgDirty_ && !progressDirty_)
+        return;
 
-    // 同步到全局 config.json（冗余：方便下次直接恢复环境）
-    QFile fc(cfgPath());
-    QJsonObject oc;
-    if (fc.exists() && fc.open(QIODevice::ReadOnly)) {
-        auto doc = QJsonDocument::fromJson(fc.readAll());
-        fc.close();
-        if (doc.isObject())
-            oc = doc.object();
+    bool ok = true;
+    if (progressDirty_) {
+        // 写进 saveDir/progress.json（按 imageDir 记 key）
+        QDir().mkpath(QFileInfo(progressPath()).absolutePath());
+        QJsonObject o;
+        for (auto it = progress_.cbegin(); it != progress_.cend(); ++it)
+            o.insert(it.key(), it.value());
+        progressDirty_ = !util::writeFileAtomic(
+            progressPath(), QJsonDocument(o).toJson(QJsonDocument::Indented));
+        ok &= !progressDirty_;
     }
-    oc.insert("save_dir", saveDir_);
-    oc.insert("image_dir", imageDir_);
-    QFile fc2(cfgPath());
-    if (fc2.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        fc2.write(QJsonDocument(oc).toJson(QJsonDocument::Indented));
-        fc2.close();
+
+    if (cfgDirty_) {
+        QJsonObject oc;
+        QFile fc(cfgPath());
+        if (fc.exists() && fc.open(QIODevice::ReadOnly)) { // 保留其他工具写入的字段
+            auto doc = QJsonDocument::fromJson(fc.readAll());
+            fc.close();
+            if (doc.isObject())
+                oc = doc.object();
+        }
+        oc.insert("save_dir", saveDir_);
+        oc.insert("image_dir", imageDir_);
+        oc.insert("last_image", lastImage_);
+        cfgDirty_ = !util::writeFileAtomic(
+            cfgPath(), QJsonDocument(oc).toJson(QJsonDocument::Indented));
+        ok &= !cfgDirty_;
     }
-}
 
-int DatasetManager::loadProgress() const {
-    if (saveDir_.isEmpty() || imageDir_.isEmpty())
-        return -1;
-    QDir d(saveDir_);
-    QString p = d.filePath("progress.json");
-    QFile f(p);
-    if (!f.exists() || !f.open(QIODevice::ReadOnly))
-        return -1;
-    auto doc = QJsonDocument::fromJson(f.readAll());
-    f.close();
-    if (!doc.isObject())
-        return -1;
-    auto o = doc.object();
-    if (!o.contains(imageDir_))
-        return -1;
-    return o.value(imageDir_).toInt(-1);
+    // JSON 已包含全部状态，日志可以清空
+    if (ok && journal_.isOpen())
+        journal_.resize(0);
 }
-} // namespace controller
\ No newline at end of file
+} // namespace controller
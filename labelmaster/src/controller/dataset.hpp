@@ -1,9 +1,14 @@
 #pragma once
+#include <QFile>
 #include <QFileSystemModel>
+#include <QHash>
 // dataset_manager.hpp
 #include <QString>
 
 namespace controller {
+// 会话状态全部驻留内存：修改只追加一行到 session.journal，
+// 由 flush() 周期性地合并写回 config.json / progress.json 并截断日志；
+// 启动时先读 JSON 再重放日志，崩溃后仍能恢复到最后一张图片
 class DatasetManager {
 public:
     static DatasetManager& instance();
@@ -16,16 +21,37 @@ public:
     void setImageDir(const QString& imageDir);
     QString imageDir() const;
 
-    // 进度：记忆当前索引（与 imageDir 绑定）
-    void saveProgress(int currentIndex);
-    int loadProgress() const; // 若无记录则返回 -1
+    // 进度：记忆当前图片（与 imageDir 绑定，按相对 imageDir 的路径存，
+    // 目录树里的行号在嵌套目录下不唯一，不能用）
+    void saveProgress(const QString& imagePath);
+    QString loadProgress() const; // 绝对路径；若无记录则返回空串
+
+    // 最后打开的图片（崩溃恢复）
+    void setLastImage(const QString& imagePath);
+    QString lastImage() const;
+
+    // 把内存状态合并写回 JSON 并截断日志；无改动时什么都不做
+    void flush();
 
 private:
     DatasetManager();
-    QString cfgPath() const;  // ~/.atlabelmaster/config.json
+    ~DatasetManager();
+    QString appDir() const;  // ~/.atlabelmaster
+    QString cfgPath() const; // ~/.atlabelmaster/config.json
+    QString journalPath() const;
+    QString progressPath() const;
+
+    void loadProgressFile();
+    void replayJournal();
+    void append(char op, const QString& value);
 
     // 内部状态缓存
     QString saveDir_;
     QString imageDir_;
+    QString lastImage_;
+    QHash<QString, QString> progress_; // imageDir → 相对路径（progress.json 的内存镜像）
+    bool cfgDirty_      = false;
+    bool progressDirty_ = false;
+    QFile journal_;
 };
-} // namespace controller
\ No newline at end of file
+} // namespace controller
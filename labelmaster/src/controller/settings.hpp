@@ -40,11 +40,25 @@ public:
     APP_SETTING_RW_STR (saveDir,      Keys::kSaveDir,      ""               )
     APP_SETTING_RW_STR (lastImageDir, Keys::kLastImageDir, ""               )
     APP_SETTING_RW_BOOL(autoSave,     Keys::kAutoSave,     Def::kAutoSave   )
+    APP_SETTING_RW_INT (autoSaveDelayMs, Keys::kAutoSaveDelayMs, Def::kAutoSaveDelayMs)
     APP_SETTING_RW_BOOL(fixedRoi,     Keys::kFixedRoi,     Def::kFixedRoi   )
     APP_SETTING_RW_INT (roiW,         Keys::kRoiW,         Def::kRoiW       )
     APP_SETTING_RW_INT (roiH,         Keys::kRoiH,         Def::kRoiH       )
     APP_SETTING_RW_STR (assetsDir,    Keys::kAssetsDir,    Def::kAssetsDir  )
     APP_SETTING_RW_FLOAT (numberClassifierThreshold, Keys::kNumberClassifierThreshold, Def::kNumberClassifierThreshold)
+    APP_SETTING_RW_INT (labelFsync,   Keys::kLabelFsync,   Def::kLabelFsync )
+    APP_SETTING_RW_BOOL(skipDuplicates, Keys::kSkipDuplicates, Def::kSkipDuplicates)
+    APP_SETTING_RW_INT (dupHammingRadius, Keys::kDupHammingRadius, Def::kDupHammingRadius)
+    APP_SETTING_RW_FLOAT(adjustGamma,    Keys::kAdjustGamma,    Def::kAdjustGamma   )
+    APP_SETTING_RW_FLOAT(adjustExposure, Keys::kAdjustExposure, Def::kAdjustExposure)
+    APP_SETTING_RW_FLOAT(adjustGainR,    Keys::kAdjustGainR,    1.f                 )
+    APP_SETTING_RW_FLOAT(adjustGainG,    Keys::kAdjustGainG,    1.f                 )
+    APP_SETTING_RW_FLOAT(adjustGainB,    Keys::kAdjustGainB,    1.f                 )
+    APP_SETTING_RW_FLOAT(adjustClahe,    Keys::kAdjustClahe,    Def::kAdjustClahe   )
+    APP_SETTING_RW_INT  (preAnnotateWorkers,  Keys::kPreAnnotateWorkers,  Def::kPreAnnotateWorkers )
+    APP_SETTING_RW_FLOAT(preAnnotateMinScore, Keys::kPreAnnotateMinScore, Def::kPreAnnotateMinScore)
+    APP_SETTING_RW_INT  (preAnnotateIdleMs,   Keys::kPreAnnotateIdleMs,   Def::kPreAnnotateIdleMs  )
+    APP_SETTING_RW_BOOL (perfLog,             Keys::kPerfLog,             Def::kPerfLog            )
 
 #undef APP_SETTING_RW_STR
 #undef APP_SETTING_RW_INT
@@ -63,19 +77,44 @@ private:
         static constexpr const char* kSaveDir                   = "dataset/saveDir";
         static constexpr const char* kLastImageDir              = "dataset/lastImageDir";
         static constexpr const char* kAutoSave                  = "behavior/autoSave";
+        static constexpr const char* kAutoSaveDelayMs           = "behavior/autoSaveDelayMs";
         static constexpr const char* kFixedRoi                  = "roi/fixed";
         static constexpr const char* kRoiW                      = "roi/w";
         static constexpr const char* kRoiH                      = "roi/h";
         static constexpr const char* kAssetsDir                 = "assets/directory";
         static constexpr const char* kNumberClassifierThreshold = "detector/tradition/threshold";
+        static constexpr const char* kLabelFsync                = "io/labelFsync";
+        static constexpr const char* kSkipDuplicates            = "behavior/skipDuplicates";
+        static constexpr const char* kDupHammingRadius          = "dataset/dupHammingRadius";
+        static constexpr const char* kAdjustGamma               = "view/adjust/gamma";
+        static constexpr const char* kAdjustExposure            = "view/adjust/exposure";
+        static constexpr const char* kAdjustGainR               = "view/adjust/gainR";
+        static constexpr const char* kAdjustGainG               = "view/adjust/gainG";
+        static constexpr const char* kAdjustGainB               = "view/adjust/gainB";
+        static constexpr const char* kAdjustClahe               = "view/adjust/claheClip";
+        static constexpr const char* kPreAnnotateWorkers        = "preannotate/workers";
+        static constexpr const char* kPreAnnotateMinScore       = "preannotate/minScore";
+        static constexpr const char* kPreAnnotateIdleMs         = "preannotate/idleMs";
+        static constexpr const char* kPerfLog                   = "debug/perfLog";
     };
     struct Def {
         static constexpr const char* kAssetsDir         = "/home/developer/ws/assets";
         static constexpr bool kAutoSave                 = false;
+        static constexpr int  kAutoSaveDelayMs          = 800; // 防抖窗口
         static constexpr bool kFixedRoi                 = false;
         static constexpr int  kRoiW                     = 640;
         static constexpr int  kRoiH                     = 480;
         static constexpr float  kNumberClassifierThreshold= 80.f;
+        static constexpr int  kLabelFsync               = 0; // 0:不 fsync 1:文件 2:文件+目录
+        static constexpr bool kSkipDuplicates           = false;
+        static constexpr int  kDupHammingRadius         = 6; // dHash 64 位中允许不同的位数
+        static constexpr float kAdjustGamma             = 0.4f; // H 键增强：默认与原先的伽马一致
+        static constexpr float kAdjustExposure          = 0.f;  // EV
+        static constexpr float kAdjustClahe             = 0.f;  // 0 关闭 CLAHE
+        static constexpr int  kPreAnnotateWorkers       = 0;    // 0：推理插件建议的并发数
+        static constexpr float kPreAnnotateMinScore     = 0.f;
+        static constexpr int  kPreAnnotateIdleMs        = 2000; // 用户停止操作多久后恢复全速
+        static constexpr bool kPerfLog                  = false; // 热路径上的性能统计日志（启动时读取）
     };
 
     QSettings settings_;
@@ -1,5 +1,9 @@
+#pragma once
 
 enum class DataSet : unsigned char { //数据集格式
     LabelMaster = 0, // 默认格式
-    SJTU //交龙
-};
\ No newline at end of file
+    SJTU,            //交龙
+    YOLOPose,        // 导出：YOLO-pose（4 关键点）
+    COCO,            // 导出：COCO keypoints JSON
+    TrainPack        // 导出：.atlpack 训练分片（dataset/pack_format.hpp）
+};
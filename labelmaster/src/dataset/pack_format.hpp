@@ -0,0 +1,56 @@
+#pragma once
+// 训练分片包（.atlpack）的磁盘格式；只依赖标准库，训练侧可以直接拷走使用
+//
+// 布局（小端，所有偏移为文件内绝对偏移，各段 8 字节对齐）：
+//   PackHeader                        64 B
+//   图片原始编码字节（jpg/png…）        逐样本紧密排列
+//   PackSample[sampleCount]           样本表
+//   标注列：color  u8[armorCount]      （补齐到 8）
+//           label  u8[armorCount]      （补齐到 8）
+//           points f32[armorCount][8]  归一化 TL BL BR TR 的 x,y
+//   名字表：相对路径 UTF-8，无结尾 '\0'
+// fileSize 最后写入且必须等于实际文件大小，否则视为未写完的分片
+#include <cstddef>
+#include <cstdint>
+
+namespace pack {
+
+inline constexpr char kMagic[8]          = {'A', 'T', 'L', 'P', 'A', 'C', 'K', '\0'};
+inline constexpr std::uint32_t kVersion  = 1;
+inline constexpr const char* kShardExt   = ".atlpack";
+inline constexpr int kPointsPerArmor     = 8; // 4 个角点 × (x, y)
+
+struct PackHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint64_t sampleCount;
+    std::uint64_t armorCount;
+    std::uint64_t sampleTableOffset;
+    std::uint64_t armorTableOffset;
+    std::uint64_t nameTableOffset;
+    std::uint64_t fileSize;
+};
+static_assert(sizeof(PackHeader) == 64);
+
+struct PackSample {
+    std::uint64_t imageOffset;
+    std::uint64_t imageSize;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t armorBegin; // 在标注列中的起始下标
+    std::uint32_t armorCount;
+    std::uint32_t nameOffset; // 相对名字表
+    std::uint32_t nameSize;
+};
+static_assert(sizeof(PackSample) == 40);
+
+constexpr std::uint64_t align8(std::uint64_t v) { return (v + 7) & ~std::uint64_t(7); }
+
+// 标注列的三个子段偏移（相对 armorTableOffset）
+constexpr std::uint64_t labelColumnOffset(std::uint64_t armorCount) { return align8(armorCount); }
+constexpr std::uint64_t pointColumnOffset(std::uint64_t armorCount) {
+    return 2 * align8(armorCount);
+}
+
+} // namespace pack
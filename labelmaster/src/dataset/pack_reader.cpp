@@ -0,0 +1,122 @@
+#include "dataset/pack_reader.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pack {
+
+ShardReader::~ShardReader() { close(); }
+
+ShardReader::ShardReader(ShardReader&& o) noexcept
+    : base_(o.base_)
+    , length_(o.length_) {
+    o.base_   = nullptr;
+    o.length_ = 0;
+}
+
+ShardReader& ShardReader::operator=(ShardReader&& o) noexcept {
+    if (this != &o) {
+        close();
+        base_     = o.base_;
+        length_   = o.length_;
+        o.base_   = nullptr;
+        o.length_ = 0;
+    }
+    return *this;
+}
+
+void ShardReader::close() {
+    if (base_)
+        ::munmap(const_cast<std::byte*>(base_), length_);
+    base_   = nullptr;
+    length_ = 0;
+}
+
+bool ShardReader::open(const std::string& path, std::string* err) {
+    close();
+    auto fail = [&](const char* why) {
+        if (err)
+            *err = path + ": " + why;
+        close();
+        return false;
+    };
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return fail("cannot open");
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || std::size_t(st.st_size) < sizeof(PackHeader)) {
+        ::close(fd);
+        return fail("truncated header");
+    }
+    void* p = ::mmap(nullptr, std::size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // 映射建立后即可关闭描述符
+    if (p == MAP_FAILED)
+        return fail("mmap failed");
+    base_   = static_cast<const std::byte*>(p);
+    length_ = std::size_t(st.st_size);
+
+    const PackHeader* h = header();
+    if (std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0)
+        return fail("bad magic");
+    if (h->version != kVersion || h->headerSize != sizeof(PackHeader))
+        return fail("unsupported version");
+    if (h->fileSize != length_)
+        return fail("incomplete shard");
+
+    // 各段必须落在文件内，且顺序为 样本表 → 标注列 → 名字表
+    const std::uint64_t n = h->sampleCount, m = h->armorCount;
+    if (h->sampleTableOffset % 8 || h->armorTableOffset % 8
+        || h->sampleTableOffset + n * sizeof(PackSample) > h->armorTableOffset
+        || h->armorTableOffset + pointColumnOffset(m) + m * kPointsPerArmor * sizeof(float)
+               > h->nameTableOffset
+        || h->nameTableOffset > length_)
+        return fail("corrupt section table");
+
+    const PackSample* s = samples();
+    for (std::uint64_t i = 0; i < n; ++i) {
+        if (s[i].imageOffset + s[i].imageSize > h->sampleTableOffset
+            || std::uint64_t(s[i].armorBegin) + s[i].armorCount > m
+            || h->nameTableOffset + s[i].nameOffset + s[i].nameSize > length_)
+            return fail("corrupt sample table");
+    }
+
+    ::madvise(const_cast<std::byte*>(base_), length_, MADV_RANDOM);
+    return true;
+}
+
+SampleView ShardReader::sample(std::size_t i) const {
+    const PackHeader* h = header();
+    const PackSample& s = samples()[i];
+    const auto* cols    = reinterpret_cast<const std::uint8_t*>(base_ + h->armorTableOffset);
+    const auto* pts     = reinterpret_cast<const float*>(
+        base_ + h->armorTableOffset + pointColumnOffset(h->armorCount));
+
+    SampleView v;
+    v.image  = {base_ + s.imageOffset, std::size_t(s.imageSize)};
+    v.width  = s.width;
+    v.height = s.height;
+    v.colors = {cols + s.armorBegin, s.armorCount};
+    v.labels = {cols + labelColumnOffset(h->armorCount) + s.armorBegin, s.armorCount};
+    v.points = {pts + std::size_t(s.armorBegin) * kPointsPerArmor,
+                std::size_t(s.armorCount) * kPointsPerArmor};
+    v.name   = {reinterpret_cast<const char*>(base_ + h->nameTableOffset + s.nameOffset),
+                s.nameSize};
+    return v;
+}
+
+void ShardReader::prefetch(std::size_t i) const {
+    if (i >= size())
+        return;
+    const PackSample& s       = samples()[i];
+    const long page           = ::sysconf(_SC_PAGESIZE);
+    const std::uint64_t begin = s.imageOffset & ~std::uint64_t(page - 1);
+    ::madvise(
+        const_cast<std::byte*>(base_ + begin), std::size_t(s.imageOffset + s.imageSize - begin),
+        MADV_WILLNEED);
+}
+
+} // namespace pack
@@ -0,0 +1,56 @@
+#pragma once
+// .atlpack 分片的 mmap 读取器：打开后样本访问不再有任何系统调用与拷贝
+#include "dataset/pack_format.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace pack {
+
+// 一个样本的零拷贝视图；生命周期不超过所属 ShardReader
+struct SampleView {
+    std::span<const std::byte> image; // 原始编码字节
+    std::uint32_t width  = 0;
+    std::uint32_t height = 0;
+    std::span<const std::uint8_t> colors; // 每个装甲板一个
+    std::span<const std::uint8_t> labels;
+    std::span<const float> points; // armorCount * 8，归一化
+    std::string_view name;         // 导出时相对数据集根目录的路径
+
+    std::size_t armorCount() const { return colors.size(); }
+};
+
+class ShardReader {
+public:
+    ShardReader() = default;
+    ~ShardReader();
+    ShardReader(ShardReader&& o) noexcept;
+    ShardReader& operator=(ShardReader&& o) noexcept;
+    ShardReader(const ShardReader&)            = delete;
+    ShardReader& operator=(const ShardReader&) = delete;
+
+    // 校验头与各段边界；失败时 err 给出原因
+    bool open(const std::string& path, std::string* err = nullptr);
+    void close();
+
+    bool isOpen() const { return base_ != nullptr; }
+    std::size_t size() const { return isOpen() ? std::size_t(header()->sampleCount) : 0; }
+    SampleView sample(std::size_t i) const; // 不检查越界
+
+    // 预读提示：随机访问的训练读取可提前告知内核后续样本
+    void prefetch(std::size_t i) const;
+
+private:
+    const PackHeader* header() const { return reinterpret_cast<const PackHeader*>(base_); }
+    const PackSample* samples() const {
+        return reinterpret_cast<const PackSample*>(base_ + header()->sampleTableOffset);
+    }
+
+    const std::byte* base_ = nullptr;
+    std::size_t length_    = 0;
+};
+
+} // namespace pack
@@ -8,6 +8,7 @@
 #include <cstring>
 #include <opencv2/imgproc.hpp>
 #include <openvino/openvino.hpp>
+#include "util/bridge.hpp"
 #include <types.hpp>                                             // Armor 定义
 
 namespace ai {
@@ -17,7 +18,8 @@ struct Detector {
 
     enum class Mode { OV_INT8_CPU, OV_FP32_CPU };
 
-    void setupModel(const QString& assets_path) {
+    // throughput：按吞吐编译（多个 InferRequest 并发时用，批量预标注），默认按延迟
+    void setupModel(const QString& assets_path, bool throughput = false) {
         label_map_[0] = "0";
         label_map_[1] = "1";
         label_map_[2] = "2";
@@ -34,11 +36,13 @@ struct Detector {
         label_map_[12] = "13";
 
         const QString dir = assets_path + "/models/";
+        const ov::AnyMap config{ov::hint::performance_mode(
+            throughput ? ov::hint::PerformanceMode::THROUGHPUT : ov::hint::PerformanceMode::LATENCY)};
         try {
             const QString xml = dir + "model-opt-int8.xml";
             if (QFile::exists(xml)) {
                 model_    = core_.read_model(xml.toStdString()); // 自动加载同名 .bin
-                compiled_ = core_.compile_model(model_, "CPU");
+                compiled_ = core_.compile_model(model_, "CPU", config);
                 request_  = compiled_.create_infer_request();
                 mode_     = Mode::OV_INT8_CPU;
                 return;
@@ -53,7 +57,7 @@ struct Detector {
                 return;
             }
             model_    = core_.read_model(onnx.toStdString());
-            compiled_ = core_.compile_model(model_, "CPU");
+            compiled_ = core_.compile_model(model_, "CPU", config);
             request_  = compiled_.create_infer_request();
             mode_     = Mode::OV_FP32_CPU;
         } catch (const std::exception& e) {
@@ -61,47 +65,75 @@ struct Detector {
         }
     }
 
-    QVector<Armor> detect(cv::Mat& img) {
-        QVector<Armor> results;
+    bool isReady() const { return bool(compiled_); }
+    // 额外的推理请求：共享已编译的模型，每个工作线程各持一个（可并发）
+    ov::InferRequest createRequest() { return compiled_.create_infer_request(); }
+    // 按吞吐编译时插件建议的并发请求数
+    int optimalRequests() const {
+        try {
+            return int(compiled_.get_property(ov::optimal_number_of_infer_requests));
+        } catch (const std::exception&) {
+            return 1;
+        }
+    }
+
+    // 预处理结果：输入张量 + 原图到网络输入的缩放
+    struct Prepared {
+        ov::Tensor tensor;
+        float scale = 1.f;
+    };
+
+    // img 可以是 QImage 的零拷贝视图（任意通道顺序，见 order）；只读
+    QVector<Armor> detect(const cv::Mat& img, util::PixelOrder order = util::PixelOrder::BGR) {
         if (!compiled_) {
             qWarning() << "SmartDetector not initialized.";
-            return results;
+            return {};
         }
+        const Prepared in = prepare(img, order);
+        request_.set_input_tensor(in.tensor);
+        request_.infer();
+        return parse(request_.get_output_tensor(), in.scale);
+    }
 
-        // —— 1) 预处理（与 SmartModel 一致：640、左上角贴入、灰底=127）——
+    // —— 预处理（与 SmartModel 一致：640、左上角贴入、灰底=127）——
+    Prepared prepare(const cv::Mat& img, util::PixelOrder order) const {
         constexpr int IN  = 640;
-        const float scale = IN / float(std::max(img.cols, img.rows));
+        Prepared out;
+        out.scale         = IN / float(std::max(img.cols, img.rows));
+        const float scale = out.scale;
+        // 先缩放再换通道：重排只发生在 640 尺度上，原图一个字节都不复制
         cv::Mat resized;
         cv::resize(
             img, resized, {int(std::round(img.cols * scale)), int(std::round(img.rows * scale))});
         cv::Mat input(IN, IN, CV_8UC3, cv::Scalar(127, 127, 127));
-        resized.copyTo(input(cv::Rect(0, 0, resized.cols, resized.rows)));
-
+        cv::Mat dst = input(cv::Rect(0, 0, resized.cols, resized.rows));
         // INT8：BGR、[0..255]；FP32：RGB、/255
-        if (mode_ == Mode::OV_FP32_CPU)
-            cv::cvtColor(input, input, cv::COLOR_BGR2RGB);
+        const int code = util::cvtCodeTo3(order, mode_ == Mode::OV_FP32_CPU);
+        if (code < 0)
+            resized.copyTo(dst);
+        else
+            cv::cvtColor(resized, dst, code); // dst 尺寸类型都对，直接写进 ROI
 
-        // —— 2) 打包 NCHW float32 Tensor（INT8 也走 float32 但不 /255）——
+        // 打包 NCHW float32 Tensor（INT8 也走 float32 但不 /255）
         cv::Mat f32;
         const double sf = (mode_ == Mode::OV_INT8_CPU) ? 1.0 : (1.0 / 255.0);
         input.convertTo(f32, CV_32F, sf);
-        ov::Tensor in_tensor(ov::element::f32, {1, 3, IN, IN});
+        out.tensor = ov::Tensor(ov::element::f32, {1, 3, IN, IN});
         {
             std::vector<cv::Mat> ch(3);
             cv::split(f32, ch);
-            float* dst         = in_tensor.data<float>();
+            float* dst         = out.tensor.data<float>();
             const size_t plane = size_t(IN) * IN;
             std::memcpy(dst + 0 * plane, ch[0].ptr<float>(), plane * sizeof(float));
             std::memcpy(dst + 1 * plane, ch[1].ptr<float>(), plane * sizeof(float));
             std::memcpy(dst + 2 * plane, ch[2].ptr<float>(), plane * sizeof(float));
         }
+        return out;
+    }
 
-        // —— 3) 推理 ——
-        request_.set_input_tensor(in_tensor);
-        request_.infer();
-
-        // —— 4) 读取输出（假设 [1, N, D]，兼容 {N,D}）——
-        ov::Tensor out    = request_.get_output_tensor();
+    // —— 读取输出（假设 [1, N, D]，兼容 {N,D}）并解码 + NMS ——
+    QVector<Armor> parse(const ov::Tensor& out, float scale) const {
+        QVector<Armor> results;
         const auto shp    = out.get_shape();
         const float* data = out.data<float>();
         int N = 0, D = 0;
@@ -124,7 +156,7 @@ struct Detector {
         auto inv_sigmoid = [](float x) { return -std::log(1 / x - 1); };
         const float th   = inv_sigmoid(0.5f);
 
-        // —— 5) 解析行，与 SmartModel 完全一致 ——
+        // 解析行，与 SmartModel 完全一致
         QVector<Armor> cand;
         cand.reserve(N);
         for (int i = 0; i < N; ++i) {
@@ -148,12 +180,12 @@ struct Detector {
                  : color_id == 1 ? "R"
                  : color_id == 2 ? "G"
                                  : "P");
-            a.cls = label_map_[tag_id];
+            a.cls = label_map_.value(tag_id);
 
             cand.push_back(a);
         }
 
-        // —— 6) NMS：按四角点外接矩形重叠即抑制（thres=0 等价）——
+        // NMS：按四角点外接矩形重叠即抑制（thres=0 等价）
         std::sort(cand.begin(), cand.end(), [](const Armor& A, const Armor& B) {
             return A.score > B.score;
         });
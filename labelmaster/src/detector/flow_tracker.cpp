@@ -0,0 +1,86 @@
+#include "detector/flow_tracker.hpp"
+
+#include <QPolygonF>
+#include <QRectF>
+
+#include <algorithm>
+#include <cmath>
+#include <opencv2/video/tracking.hpp>
+#include <vector>
+
+namespace {
+constexpr int kWin            = 21;  // LK 窗口（跟踪图像素）
+constexpr int kLevels         = 3;   // 金字塔层数：窗口内最多容忍约 kWin * 2^kLevels 的位移
+constexpr double kMinMargin   = 32;  // 包围盒至少外扩这么多跟踪图像素
+constexpr double kMaxFbError  = 1.5; // 前向-后向误差达到此值（像素）置信度归零
+
+// 把原图坐标下的 roi 从显示图中裁出并转灰度，缩放到跟踪尺度 s（原图像素 → 跟踪像素）
+cv::Mat grayCrop(const QImage& img, double imgScale, const QRectF& roi, double s) {
+    const QRect src = QRectF(roi.x() * imgScale, roi.y() * imgScale, roi.width() * imgScale,
+                             roi.height() * imgScale)
+                          .toAlignedRect()
+                          .intersected(img.rect());
+    QImage g = img.copy(src).convertToFormat(QImage::Format_Grayscale8);
+    const QSize want(int(std::lround(roi.width() * s)), int(std::lround(roi.height() * s)));
+    if (g.size() != want)
+        g = g.scaled(want, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    return cv::Mat(g.height(), g.width(), CV_8UC1, g.bits(), g.bytesPerLine()).clone();
+}
+} // namespace
+
+FlowTracker::Result FlowTracker::track(
+    const QImage& prev, const QSize& prevSize, const QImage& next, const QSize& nextSize,
+    const QVector<Armor>& armors) {
+    Result r;
+    if (prev.isNull() || next.isNull() || prevSize.isEmpty() || nextSize.isEmpty())
+        return r;
+
+    // 两边可能一张是预览一张是原图：统一到较小的那个尺度上跟踪
+    const double ps = double(prev.width()) / prevSize.width();
+    const double ns = double(next.width()) / nextSize.width();
+    const double s  = std::min({ps, ns, 1.0});
+    const QRectF bounds =
+        QRectF(QPointF(0, 0), QSizeF(prevSize)).intersected(QRectF(QPointF(0, 0), QSizeF(nextSize)));
+    const cv::TermCriteria crit(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 30, 0.01);
+
+    r.armors.reserve(armors.size());
+    r.confidence.reserve(armors.size());
+    for (const Armor& a : armors) {
+        const std::array<QPointF, 4> corners{a.p0, a.p1, a.p2, a.p3};
+        QRectF box = QPolygonF({a.p0, a.p1, a.p2, a.p3}).boundingRect();
+        const double margin = std::max(kMinMargin / s, 0.5 * std::max(box.width(), box.height()));
+        box = QRectF(box.adjusted(-margin, -margin, margin, margin).intersected(bounds).toAlignedRect());
+
+        Armor out = a;
+        std::array<float, 4> conf{0, 0, 0, 0};
+        if (box.width() * s >= kWin && box.height() * s >= kWin) {
+            const cv::Mat p = grayCrop(prev, ps, box, s);
+            const cv::Mat n = grayCrop(next, ns, box, s);
+            std::vector<cv::Point2f> pts, fwd, back;
+            for (const QPointF& c : corners)
+                pts.emplace_back(float((c.x() - box.x()) * s), float((c.y() - box.y()) * s));
+            std::vector<uchar> st1, st2;
+            std::vector<float> err;
+            cv::calcOpticalFlowPyrLK(p, n, pts, fwd, st1, err, {kWin, kWin}, kLevels, crit);
+            cv::calcOpticalFlowPyrLK(n, p, fwd, back, st2, err, {kWin, kWin}, kLevels, crit);
+
+            QPointF* dst[4] = {&out.p0, &out.p1, &out.p2, &out.p3};
+            for (int i = 0; i < 4; ++i) {
+                if (!st1[i] || !st2[i])
+                    continue; // 跟丢：保留上一帧位置，置信度 0
+                const double fb = std::hypot(pts[i].x - back[i].x, pts[i].y - back[i].y);
+                conf[i]         = float(std::max(0.0, 1.0 - fb / kMaxFbError));
+                const QPointF q(box.x() + fwd[i].x / s, box.y() + fwd[i].y / s);
+                *dst[i]         = QPointF(
+                    std::clamp(q.x(), 0.0, double(nextSize.width() - 1)),
+                    std::clamp(q.y(), 0.0, double(nextSize.height() - 1)));
+            }
+        }
+        out.score = *std::min_element(conf.begin(), conf.end());
+        if (out.score < kLowConfidence)
+            r.flagged.push_back(int(r.armors.size()));
+        r.armors.push_back(out);
+        r.confidence.push_back(conf);
+    }
+    return r;
+}
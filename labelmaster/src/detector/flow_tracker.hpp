@@ -0,0 +1,26 @@
+#pragma once
+#include "types.hpp"
+#include <QImage>
+#include <QSize>
+#include <QVector>
+
+#include <array>
+
+// 帧间标注传播：用金字塔 LK 光流把上一帧装甲板的四个角点跟到下一帧。
+// 每个装甲板只在角点包围盒外扩一圈的小窗口里建金字塔，比整帧跑检测便宜得多；
+// 每个角点做前向-后向一致性检查，给出 [0,1] 的置信度
+class FlowTracker {
+public:
+    static constexpr float kLowConfidence = 0.5f; // 低于此值的角点视为跟丢，需要人工确认
+
+    struct Result {
+        QVector<Armor> armors;                     // 原图坐标；score = 四角最低置信度
+        QVector<std::array<float, 4>> confidence;  // 与 armors 一一对应，顺序同 p0..p3
+        QVector<int> flagged;                      // 含低置信度角点的装甲板下标
+    };
+
+    // prev/next 可以是预览（分辨率低于原图），prevSize/nextSize 是各自的原图尺寸（标注坐标系）
+    static Result track(
+        const QImage& prev, const QSize& prevSize, const QImage& next, const QSize& nextSize,
+        const QVector<Armor>& armors);
+};
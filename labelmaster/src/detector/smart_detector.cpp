@@ -21,13 +21,15 @@ SmartDetector::SmartDetector(
     qRegisterMetaType<std::vector<rm_auto_aim::Armor>>("std::vector<rm_auto_aim::Armor>");
     traditional_detector_ = std::make_unique<Detector>(bin_thres, lp, ap);
     mode                  = Mode::Traditional;
+    perfLog_              = controller::AppSettings::instance().perfLog();
 }
 
 SmartDetector::SmartDetector(QObject* parent)
     : QObject(parent) {
     ai_detector_ = std::make_unique<ai::Detector>();
     ai_detector_->setupModel(controller::AppSettings::instance().assetsDir());
-    mode = Mode::AI;
+    mode     = Mode::AI;
+    perfLog_ = controller::AppSettings::instance().perfLog();
 }
 
 void SmartDetector::setBinaryThreshold(int thres) {
@@ -35,55 +37,57 @@ void SmartDetector::setBinaryThreshold(int thres) {
         traditional_detector_->binary_thres = thres;
 }
 
-void SmartDetector::detect(const QImage& image) {
+void SmartDetector::detect(const Frame& frame) { detectImage(frame.image(), frame.path()); }
+
+void SmartDetector::detectImage(const QImage& image, const QString& imagePath) {
     try {
-        cv::Mat mat = qimageToMat(image);
-        detectMat(mat);
+        const std::uint64_t before = util::bridgeBytesCopied;
+        const util::ImageView view = util::viewOf(image); // 常见格式零拷贝
+        runDetection(view.mat, view.order, imagePath);
+        if (perfLog_)
+            qDebug() << "detect: 整帧拷贝" << (util::bridgeBytesCopied - before) << "字节";
     } catch (const std::exception& e) {
         emit error(QString("SmartDetector::detect(QImage) error: %1").arg(e.what()));
     }
 }
 
 void SmartDetector::detectMat(const cv::Mat& mat) {
-    qInfo() << "detect once";
     try {
-        cv::Mat input;
-        // 统一转为 BGR 8UC3（取决于你 detector 的预期，这里假定 BGR）
-        if (mat.empty()) {
-            emit error("Input Mat is empty.");
-            return;
-        }
-        if (mat.type() == CV_8UC3) {
-            input = mat.clone();
-            // 如果是 RGB，可在这里 swap：cv::cvtColor(mat, input, cv::COLOR_RGB2BGR);
-        } else if (mat.type() == CV_8UC4) {
-            cv::cvtColor(mat, input, cv::COLOR_BGRA2BGR);
-        } else if (mat.type() == CV_8UC1) {
-            cv::cvtColor(mat, input, cv::COLOR_GRAY2BGR);
-        } else {
+        // 8UC3 按 BGR、8UC4 按 BGRA 解释，不复制；其余深度才转换
+        switch (mat.type()) {
+        case CV_8UC3: runDetection(mat, util::PixelOrder::BGR); break;
+        case CV_8UC4: runDetection(mat, util::PixelOrder::BGRA); break;
+        case CV_8UC1: runDetection(mat, util::PixelOrder::Gray); break;
+        default: {
+            cv::Mat input;
             mat.convertTo(input, CV_8UC3);
+            runDetection(input, util::PixelOrder::BGR);
         }
-
-        // --- 同步版本 ---
-        QVector<::Armor> sigArmors;
-        if (ai_detector_) {
-            sigArmors = ai_detector_->detect(input);
-        } else {
-            qWarning() << "ai detector not initialized.";
         }
-
-        // 调试图像（可选）
-        // cv::Mat draw = input.clone();
-        // QImage anno  = matToQImage(draw);
-
-        qDebug() << "emit detected";
-        emit detected(sigArmors);
-
     } catch (const std::exception& e) {
         emit error(QString("SmartDetector::detectMat error: %1").arg(e.what()));
     }
 }
 
+void SmartDetector::runDetection(const cv::Mat& input, util::PixelOrder order, const QString& imagePath) {
+    qInfo() << "detect once";
+    if (input.empty()) {
+        emit error("Input Mat is empty.");
+        return;
+    }
+
+    // --- 同步版本 ---
+    QVector<::Armor> sigArmors;
+    if (ai_detector_) {
+        sigArmors = ai_detector_->detect(input, order);
+    } else {
+        qWarning() << "ai detector not initialized.";
+    }
+
+    qDebug() << "emit detected";
+    emit detected(sigArmors, imagePath);
+}
+
 void SmartDetector::resetNumberClassifier(
     const QString& model_path, const QString& label_path, float threshold) {
     if (traditional_detector_) {
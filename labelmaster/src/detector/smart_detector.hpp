@@ -1,5 +1,6 @@
 #pragma once
 #include "ai/detector.hpp"
+#include "frame.hpp"
 #include <QImage>
 #include <QObject>
 #include <QVector>
@@ -8,6 +9,7 @@
 #include "armor.hpp"                // rm_auto_aim::Armor
 #include "traditional/detector.hpp" // 你给的头
 #include "types.hpp"
+#include "util/bridge.hpp"
 #include <opencv2/core.hpp>
 
 // 声明给 Qt 的元类型（用于跨线程信号）
@@ -25,16 +27,19 @@ public:
     void setBinaryThreshold(int thres);
 
 signals:
-    // 主结果：一帧检测出的装甲板
-    void detected(const QVector<Armor>& armors);
+    // 主结果：一帧检测出的装甲板；imagePath 为请求帧的路径（QImage/Mat 入口为空），
+    // 接收方据此丢弃用户翻页后才到达的旧结果
+    void detected(const QVector<Armor>& armors, const QString& imagePath);
     // 可选调试输出：二值图与标注图（若不用可删）
     void debugImages(const QImage& bin, const QImage& annotated);
     // 出错时
     void error(const QString& message);
 
 public slots:
+    // 传入帧句柄（跨线程只传引用计数，像素零拷贝）
+    void detect(const Frame& frame);
     // 传入 QImage
-    void detect(const QImage& image);
+    void detectImage(const QImage& image, const QString& imagePath = {});
     // 传入 cv::Mat（BGR/RGB 都可，见实现）
     void detectMat(const cv::Mat& mat);
     // 重置分类器
@@ -42,7 +47,11 @@ public slots:
         const QString& model_path, const QString& label_path, float threshold);
 
 private:
+    // input 只读，可以是 QImage 的零拷贝视图
+    void runDetection(const cv::Mat& input, util::PixelOrder order, const QString& imagePath = {});
+
     Mode mode = Mode::AI;
     std::unique_ptr<rm_auto_aim::Detector> traditional_detector_;
     std::unique_ptr<ai::Detector> ai_detector_;
+    bool perfLog_ = false; // AppSettings::perfLog：每次检测输出整帧拷贝量
 };
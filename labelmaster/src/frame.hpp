@@ -0,0 +1,74 @@
+#pragma once
+#include "util/bridge.hpp"
+#include <QDateTime>
+#include <QImage>
+#include <QMetaType>
+#include <QRect>
+#include <QSize>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+
+// 一帧解码后的像素与元数据。像素只存一份，image() / mat() 都是它的视图；
+// Frame 按值传递只是拷一个句柄（引用计数），跨线程传递也不复制像素，内容创建后不可变
+class Frame {
+public:
+    Frame() = default;
+    // fullSize：标注坐标系的原图尺寸；预览帧的像素小于它，缺省等于像素尺寸
+    explicit Frame(const QImage& pixels, const QString& path = {}, const QSize& fullSize = {})
+        : d_(std::make_shared<const Data>(Data{
+              nextId(), path, fullSize.isValid() ? fullSize : pixels.size(),
+              QDateTime::currentMSecsSinceEpoch(), pixels})) {}
+
+    bool isNull() const { return !d_ || d_->image.isNull(); }
+    quint64 id() const { return d_ ? d_->id : 0; } // 进程内唯一，不随拷贝变化
+    QString path() const { return d_ ? d_->path : QString(); }
+    QSize size() const { return d_ ? d_->image.size() : QSize(); }
+    QSize fullSize() const { return d_ ? d_->fullSize : QSize(); }
+    qint64 timestamp() const { return d_ ? d_->timestamp : 0; } // 解码完成时刻（ms）
+    bool isPreview() const { return size() != fullSize(); }
+
+    const QImage& image() const {
+        static const QImage null;
+        return d_ ? d_->image : null;
+    }
+    util::ImageView mat() const { return util::viewOf(image()); } // 只读，不复制
+
+    // 子区域（像素坐标）：共享父帧缓冲区，不复制；得到的是新帧（新 id，路径沿用）
+    Frame cropped(const QRect& rect) const {
+        const QImage& img = image();
+        const QRect r     = rect.intersected(img.rect());
+        if (r.isEmpty())
+            return {};
+        QImage sub;
+        if (img.depth() >= 8) {
+            auto* keep        = new QImage(img); // 子图存活期间父缓冲区不释放
+            const uchar* bits = keep->constBits() + qsizetype(r.y()) * keep->bytesPerLine()
+                              + qsizetype(r.x()) * (keep->depth() / 8);
+            sub = QImage(
+                bits, r.width(), r.height(), keep->bytesPerLine(), keep->format(),
+                [](void* p) { delete static_cast<QImage*>(p); }, keep);
+            sub.setColorTable(img.colorTable()); // Indexed8 的像素是调色板下标，少了色表就是花屏
+        } else {
+            sub = img.copy(r); // 位图等亚字节格式无法按字节偏移
+        }
+        return Frame(sub, path(), r.size());
+    }
+
+private:
+    struct Data {
+        quint64 id;
+        QString path;
+        QSize fullSize;
+        qint64 timestamp;
+        QImage image;
+    };
+    static quint64 nextId() {
+        static std::atomic<quint64> counter{0};
+        return ++counter;
+    }
+    std::shared_ptr<const Data> d_;
+};
+
+Q_DECLARE_METATYPE(Frame)
@@ -1,12 +1,24 @@
 #include "controller/settings.hpp"
 #include "detector/smart_detector.hpp"
 #include "logger/core.hpp"
+#include "service/dataset_stats.hpp"
+#include "service/dataset_watcher.hpp"
 #include "service/file.hpp"
+#include "service/job_journal.hpp"
+#include "service/pre_annotator.hpp"
+#include "ui/filmstrip.hpp"
 #include "ui/image_canvas.hpp"
 #include "ui/info_dialog.h"
 #include "ui/mainwindow.hpp"
+#include "ui/stats_dialog.hpp"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
 #include <QFile>
+#include <QTextStream>
+#include <atomic>
+#include <csignal>
+#include <cstring>
 #include <pthread.h>
 #include <qglobal.h>
 #include <qobject.h>
@@ -14,7 +26,110 @@
 
 #define ASSETS_PATH "/home/developer/ws/assets"
 
+// 命令行模式：不创建窗口（可在无显示环境运行）
+static bool isCliMode(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        for (const char* opt : {"--stats", "--headless"}) {
+            const size_t n = std::strlen(opt);
+            if (std::strncmp(argv[i], opt, n) == 0 && (argv[i][n] == '\0' || argv[i][n] == '='))
+                return true;
+        }
+    }
+    return false;
+}
+
+static std::atomic_bool g_cliCancel{false}; // Ctrl-C：让批处理在当前图片处停下
+
+static int runCli(QCoreApplication& app) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription("ATLabelMaster command line");
+    parser.addHelpOption();
+    const QCommandLineOption statsOpt(
+        "stats", "Print class/color/size statistics of the dataset under <dir>.", "dir");
+    const QCommandLineOption headlessOpt(
+        "headless", "Pre-annotate every unlabeled image under <dir> with the AI detector.", "dir");
+    const QCommandLineOption workersOpt(
+        "workers", "Concurrent inference requests for --headless (default: plugin optimum).", "n");
+    const QCommandLineOption minScoreOpt(
+        "min-score", "Drop detections below this confidence for --headless.", "score");
+    const QCommandLineOption assetsOpt(
+        "assets", "Model directory for --headless (default: settings assetsDir).", "dir");
+    const QCommandLineOption restartOpt(
+        "restart", "Ignore the --headless job journal and start over.");
+    parser.addOptions({statsOpt, headlessOpt, workersOpt, minScoreOpt, assetsOpt, restartOpt});
+    parser.process(app);
+
+    QTextStream out(stdout), err(stderr);
+    if (parser.isSet(statsOpt)) {
+        const QString root = QDir(parser.value(statsOpt)).absolutePath();
+        if (!QDir(root).exists()) {
+            err << "no such directory: " << root << Qt::endl;
+            return 1;
+        }
+        QThreadPool pool;
+        out << root << "\n\n" << DatasetStats::compute(root, pool).toText() << Qt::flush;
+        return 0;
+    }
+    if (parser.isSet(headlessOpt)) {
+        const QString root = QDir(parser.value(headlessOpt)).absolutePath();
+        if (!QDir(root).exists()) {
+            err << "no such directory: " << root << Qt::endl;
+            return 1;
+        }
+        PreAnnotator::Options opt;
+        opt.assetsDir = parser.isSet(assetsOpt) ? parser.value(assetsOpt)
+                                                : controller::AppSettings::instance().assetsDir();
+        opt.workers   = parser.value(workersOpt).toInt();
+        opt.minScore  = parser.value(minScoreOpt).toFloat();
+
+        // 已处理的图片记在任务日志里：Ctrl-C 或崩溃后再次运行从断点继续
+        JobJournal journal(root, PreAnnotator::kJournalName);
+        if (journal.open(parser.isSet(restartOpt)))
+            opt.journal = &journal;
+
+        std::signal(SIGINT, [](int) { g_cliCancel.store(true); });
+        qint64 resumed           = 0;
+        const QStringList images = PreAnnotator::pendingImages(root, opt.journal, &resumed, &g_cliCancel);
+        out << root << ": " << images.size() << " unlabeled images";
+        if (resumed > 0)
+            out << " (" << resumed << " already processed, resuming)";
+        out << Qt::endl;
+        const auto res = PreAnnotator::run(images, opt, &g_cliCancel, [&](const PreAnnotator::Result& r) {
+            const double eta = r.eta();
+            err << QString("\r%1/%2  %3 img/s  ETA %4")
+                       .arg(r.done)
+                       .arg(r.total)
+                       .arg(r.recent, 0, 'f', 1)
+                       .arg(eta < 0 ? QString("--") : QString("%1 s").arg(qRound(eta)))
+                << Qt::flush;
+        });
+        if (res.complete())
+            journal.discard(); // 跑完了：下次运行（比如换了模型）重新检测所有未标注图片
+        else
+            journal.close();
+        err << Qt::endl;
+        if (res.cancelled)
+            out << "cancelled; run again to resume" << Qt::endl;
+        out << QString("processed %1/%2 in %3 s (%4 img/s), wrote %5 label files, %6 plates, %7 failed")
+                   .arg(res.done)
+                   .arg(res.total)
+                   .arg(res.seconds, 0, 'f', 1)
+                   .arg(res.rate(), 0, 'f', 2)
+                   .arg(res.written)
+                   .arg(res.plates)
+                   .arg(res.failed)
+            << Qt::endl;
+        return res.failed == res.total && res.total > 0 ? 1 : 0;
+    }
+    parser.showHelp(1);
+}
+
 int main(int argc, char* argv[]) {
+    if (isCliMode(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return runCli(app);
+    }
+
     // 1) 先安装 Qt 的全局消息处理器，尽早捕获日志
 
     QApplication app(argc, argv);
@@ -40,33 +155,97 @@ int main(int argc, char* argv[]) {
     QObject::connect(&w, &ui::MainWindow::sigOpenFolderRequested, &files, [&]() {
         files.openFolderDialog(DataSet::LabelMaster);
     });
+    QObject::connect(
+        &w, &ui::MainWindow::sigOpenVideoRequested, &files, &FileService::openVideoDialog);
     QObject::connect(
         &w, &ui::MainWindow::sigImportFolderRequested, &files, &FileService::importFrom);
+    QObject::connect(&w, &ui::MainWindow::sigExportRequested, &files, &FileService::exportTo);
+    QObject::connect(
+        &w, &ui::MainWindow::sigTaskCancelRequested, &files, &FileService::cancelTasks);
     QObject::connect(&w, &ui::MainWindow::sigFileActivated, &files, &FileService::openIndex);
     QObject::connect(&w, &ui::MainWindow::sigDroppedPaths, &files, &FileService::openPaths);
     QObject::connect(&w, &ui::MainWindow::sigNextRequested, &files, &FileService::next);
     QObject::connect(&w, &ui::MainWindow::sigPrevRequested, &files, &FileService::prev);
     QObject::connect(&w, &ui::MainWindow::sigDeleteRequested, &files, &FileService::deleteCurrent);
+    QObject::connect(
+        &w, &ui::MainWindow::sigFindDuplicatesRequested, &files, &FileService::findDuplicates);
+    QObject::connect(
+        &w, &ui::MainWindow::sigQueryLabelsRequested, &files, &FileService::queryLabelsDialog);
+    QObject::connect(
+        &w, &ui::MainWindow::sigPreAnnotateRequested, &files, &FileService::preAnnotate);
+    w.ui()->actionSkipDuplicates->setChecked(controller::AppSettings::instance().skipDuplicates());
+    QObject::connect(
+        &w, &ui::MainWindow::sigSkipDuplicatesToggled, &files, &FileService::setSkipDuplicates);
 
     QObject::connect(&files, &FileService::modelReady, &w, &ui::MainWindow::setFileModel);
     QObject::connect(&files, &FileService::rootChanged, &w, &ui::MainWindow::setRoot); // ★ 新增
     QObject::connect(
         &files, &FileService::currentIndexChanged, &w, &ui::MainWindow::setCurrentIndex);
     QObject::connect(&files, &FileService::imageReady, &w, &ui::MainWindow::showImage);
+    QObject::connect(&files, &FileService::previewReady, &w, &ui::MainWindow::showPreview);
+    QObject::connect(&files, &FileService::imageUpgraded, &w, &ui::MainWindow::upgradeImage);
+    QObject::connect(&files, &FileService::tiledImageReady, &w, &ui::MainWindow::showTiled);
+    QObject::connect(
+        w.ui()->label, &ImageCanvas::viewportResized, &files, &FileService::setViewportSize);
     QObject::connect(&files, &FileService::status, &w, &ui::MainWindow::setStatus);
+    QObject::connect(w.ui()->label, &ImageCanvas::status, &w, &ui::MainWindow::setStatus);
     QObject::connect(&files, &FileService::busy, &w, &ui::MainWindow::setBusy);
+    QObject::connect(
+        &files, &FileService::taskProgress, &w, &ui::MainWindow::setTaskProgress);
     QObject::connect(
         &w, &ui::MainWindow::sigHistEqRequested, w.ui()->label, &ImageCanvas::histEqualize);
     // ImageCanvas <-> SmartDetector 连接 检测和检测结果
     QObject::connect(
         w.ui()->label, &ImageCanvas::detectRequested, &detector, &SmartDetector::detect);
     QObject::connect(
-        &detector, &SmartDetector::detected, w.ui()->label, &ImageCanvas::setDetections);
+        &detector, &SmartDetector::detected, w.ui()->label, &ImageCanvas::applyDetectionsFor);
     //
     QObject::connect(
         &files, &FileService::labelsLoaded, w.ui()->label, &ImageCanvas::setDetections);
     QObject::connect(
         w.ui()->label, &ImageCanvas::annotationsPublished, &files, &FileService::saveLabels);
+    QObject::connect(
+        w.ui()->label, &ImageCanvas::annotationsEdited, &files, &FileService::markDirty);
+    // 光流传播：用未处理的像素跟踪，结果作为一次编辑预填，并选中第一个需确认的装甲板
+    QObject::connect(&w, &ui::MainWindow::sigPropagateRequested, &files, [&] {
+        auto* canvas = w.ui()->label;
+        files.propagateToNext(canvas->frame(), canvas->detections());
+    });
+    QObject::connect(
+        &files, &FileService::labelsPropagated, w.ui()->label,
+        [&](const QVector<Armor>& armors, const QVector<int>& flagged) {
+            w.ui()->label->applyDetections(armors);
+            if (!flagged.isEmpty())
+                w.ui()->label->setSelectedIndex(flagged.first());
+        });
+    // 数据集统计面板：快照由 DatasetStats 推送（全量完成 / 每次保存的增量）
+    ui::StatsDialog statsDialog(&w);
+    QObject::connect(&w, &ui::MainWindow::sigStatsRequested, &statsDialog, [&] {
+        statsDialog.setRoot(files.stats()->root());
+        statsDialog.setSnapshot(files.stats()->snapshot());
+        statsDialog.show();
+        statsDialog.raise();
+    });
+    QObject::connect(
+        files.stats(), &DatasetStats::changed, &statsDialog, [&](const DatasetStatsSnapshot& s) {
+            statsDialog.setRoot(files.stats()->root());
+            statsDialog.setSnapshot(s);
+        });
+    // 胶片条：行随增量索引变化，缩略图按可见项从 pack 读取/后台生成
+    ui::FilmstripModel filmModel(files.thumbnails());
+    w.filmstrip()->setFilmstripModel(&filmModel);
+    QObject::connect(files.watcher(), &DatasetWatcher::ready, &filmModel, [&] {
+        filmModel.resetFrom(files.watcher()->index());
+    });
+    QObject::connect(
+        files.watcher(), &DatasetWatcher::indexChanged, &filmModel,
+        &ui::FilmstripModel::applyChanges);
+    QObject::connect(
+        &files, &FileService::labelsWritten, &filmModel, &ui::FilmstripModel::setLabelStatus);
+    QObject::connect(
+        &files, &FileService::currentImageChanged, w.filmstrip(), &ui::Filmstrip::setCurrentPath);
+    QObject::connect(
+        w.filmstrip(), &ui::Filmstrip::imageActivated, &files, &FileService::openImagePath);
     files.exposeModel();
     w.enableDragDrop(true);
     w.show();
@@ -0,0 +1,123 @@
+#include "service/dataset_index.hpp"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QSet>
+
+#include <algorithm>
+
+const QStringList& DatasetIndex::imageFilters() {
+    static const QStringList kImgExt = {"*.png", "*.jpg", "*.jpeg", "*.bmp",
+                                        "*.gif", "*.tif", "*.tiff", "*.webp"};
+    return kImgExt;
+}
+
+bool DatasetIndex::isImageFile(const QString& path) {
+    for (const auto& ext : imageFilters())
+        if (path.endsWith(QStringView(ext).mid(1), Qt::CaseInsensitive))
+            return true;
+    return false;
+}
+
+QSize DatasetIndex::imageSize(const QString& imagePath) {
+    QImageReader reader(imagePath);
+    reader.setAutoTransform(true);
+    QSize size = reader.size(); // size() 是存储尺寸，不含旋转
+    if (reader.transformation() & QImageIOHandler::TransformationRotate90)
+        size.transpose();
+    return size;
+}
+
+bool DatasetIndex::build(const QString& root, const std::atomic_bool* cancel) {
+    clear();
+    root_ = QDir(root).absolutePath();
+
+    QDirIterator it(
+        root_, imageFilters(), QDir::Files | QDir::NoDotAndDotDot,
+        QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            clear();
+            return false;
+        }
+        entries_.push_back({it.next()});
+    }
+    std::sort(entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b) {
+        return a.imagePath < b.imagePath;
+    });
+    return true;
+}
+
+void DatasetIndex::clear() { entries_.clear(); }
+
+qsizetype DatasetIndex::lowerBound(const QString& imagePath) const {
+    return std::lower_bound(
+               entries_.begin(), entries_.end(), imagePath,
+               [](const Entry& e, const QString& p) { return e.imagePath < p; })
+         - entries_.begin();
+}
+
+int DatasetIndex::indexOf(const QString& imagePath) const {
+    const qsizetype i = lowerBound(imagePath);
+    return i < entries_.size() && entries_[i].imagePath == imagePath ? int(i) : -1;
+}
+
+bool DatasetIndex::insert(const QString& imagePath) {
+    const qsizetype i = lowerBound(imagePath);
+    if (i < entries_.size() && entries_[i].imagePath == imagePath)
+        return false;
+    entries_.insert(i, {imagePath});
+    return true;
+}
+
+bool DatasetIndex::remove(const QString& imagePath) {
+    const int i = indexOf(imagePath);
+    if (i < 0)
+        return false;
+    entries_.removeAt(i);
+    return true;
+}
+
+QStringList DatasetIndex::removeUnder(const QString& dir) {
+    const QStringList removed = listUnder(dir);
+    entries_.remove(lowerBound(dir.endsWith('/') ? dir : dir + '/'), removed.size());
+    return removed;
+}
+
+QStringList DatasetIndex::listUnder(const QString& dir) const {
+    // 有序列表中同一目录前缀的条目是连续的一段
+    const QString prefix = dir.endsWith('/') ? dir : dir + '/';
+    QStringList out;
+    for (qsizetype i = lowerBound(prefix); i < entries_.size() && entries_[i].imagePath.startsWith(prefix); ++i)
+        out.push_back(entries_[i].imagePath);
+    return out;
+}
+
+void DatasetIndex::applyBatch(QStringList added, const QStringList& removed) {
+    if (!removed.isEmpty()) {
+        const QSet<QString> gone(removed.begin(), removed.end());
+        entries_.removeIf([&](const Entry& e) { return gone.contains(e.imagePath); });
+    }
+    if (added.isEmpty())
+        return;
+    std::sort(added.begin(), added.end());
+
+    // 两路归并：已有条目与新增路径都有序，整体只搬一次
+    QVector<Entry> merged;
+    merged.reserve(entries_.size() + added.size());
+    auto a = entries_.cbegin();
+    auto b = added.cbegin();
+    while (a != entries_.cend() || b != added.cend()) {
+        if (b == added.cend() || (a != entries_.cend() && a->imagePath < *b)) {
+            merged.push_back(*a++);
+            continue;
+        }
+        if (a != entries_.cend() && a->imagePath == *b)
+            ++a; // 被覆盖写的已有图片
+        if (merged.isEmpty() || merged.last().imagePath != *b)
+            merged.push_back({*b});
+        ++b;
+    }
+    entries_ = std::move(merged);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+
+// 数据集索引：root 下全部图片的扁平列表（按路径排序），供导入/导出/统计等批量操作遍历；
+// 也可以由 DatasetWatcher 按文件系统事件增量维护（insert/remove 不触发重扫）
+class DatasetIndex {
+public:
+    struct Entry {
+        QString imagePath; // 绝对路径
+    };
+
+    static const QStringList& imageFilters(); // "*.png" 等
+    static bool isImageFile(const QString& path);
+    // 只读文件头的图片尺寸，按 EXIF 旋转后（与打开图片时的标注坐标系一致）
+    static QSize imageSize(const QString& imagePath);
+
+    // 递归扫描（跳过隐藏目录），cancel 置位时提前返回 false
+    bool build(const QString& root, const std::atomic_bool* cancel = nullptr);
+    void clear();
+
+    // 增量维护：保持有序，重复插入/删除不存在的路径返回 false（单条 O(n)，突发事件请用 applyBatch）
+    bool insert(const QString& imagePath);
+    bool remove(const QString& imagePath);
+    QStringList removeUnder(const QString& dir); // 整个子目录被删除/移出，返回被移除的图片
+    QStringList listUnder(const QString& dir) const; // 子目录下的全部图片（有序）
+    // 一批增删一次合并：O(n + k log k)；added 中已存在的路径保持一份
+    void applyBatch(QStringList added, const QStringList& removed);
+
+    const QString& root() const { return root_; }
+    qsizetype size() const { return entries_.size(); }
+    bool isEmpty() const { return entries_.isEmpty(); }
+    const Entry& at(qsizetype i) const { return entries_.at(i); }
+    const QVector<Entry>& entries() const { return entries_; }
+    int indexOf(const QString& imagePath) const; // 二分查找，不存在返回 -1
+    qsizetype lowerBound(const QString& imagePath) const; // 第一个 >= imagePath 的位置
+
+private:
+    QString root_;
+    QVector<Entry> entries_;
+};
@@ -0,0 +1,184 @@
+#include "service/dataset_stats.hpp"
+#include "logger/core.hpp"
+#include "service/file.hpp"
+#include "service/label_store.hpp"
+
+#include <cmath>
+#include <utility>
+
+namespace {
+int areaBin(const Plate& p) {
+    const float area = p.area();
+    if (area < 2)
+        return 0;
+    return std::min(DatasetStatsSnapshot::kAreaBins - 1, int(std::log2(area)));
+}
+} // namespace
+
+// ---------- DatasetStatsSnapshot ----------
+void DatasetStatsSnapshot::add(const ImageStats& s, int sign) {
+    images += sign;
+    if (!s.labeled)
+        unlabeled += sign;
+    plates += sign * s.plates.size();
+    platesPerImage[std::min<qsizetype>(kPlateBins - 1, s.plates.size())] += sign;
+    for (quint16 p : s.plates) {
+        perClass[p >> 8] += sign;
+        areaLog2[p & 0xff] += sign;
+    }
+}
+
+void DatasetStatsSnapshot::merge(const DatasetStatsSnapshot& o) {
+    images += o.images;
+    unlabeled += o.unlabeled;
+    plates += o.plates;
+    for (int i = 0; i < kClasses; ++i)
+        perClass[i] += o.perClass[i];
+    for (int i = 0; i < kPlateBins; ++i)
+        platesPerImage[i] += o.platesPerImage[i];
+    for (int i = 0; i < kAreaBins; ++i)
+        areaLog2[i] += o.areaLog2[i];
+}
+
+qint64 DatasetStatsSnapshot::perColor(int color) const {
+    qint64 n = 0;
+    for (int l = 0; l < kLabels; ++l)
+        n += perClass[color * kLabels + l];
+    return n;
+}
+
+qint64 DatasetStatsSnapshot::perLabel(int label) const {
+    qint64 n = 0;
+    for (int c = 0; c < kColors; ++c)
+        n += perClass[c * kLabels + label];
+    return n;
+}
+
+QString DatasetStatsSnapshot::toText() const {
+    QString out;
+    auto pct = [](qint64 a, qint64 b) { return b ? 100.0 * double(a) / double(b) : 0.0; };
+
+    out += QString("图片总数  %1\n").arg(images);
+    out += QString("已标注    %1\n").arg(images - unlabeled);
+    out += QString("未标注    %1 (%2%)\n").arg(unlabeled).arg(pct(unlabeled, images), 0, 'f', 1);
+    out += QString("装甲板    %1\n\n").arg(plates);
+
+    // 颜色 × 类别交叉表
+    out += QString("%1").arg("", 6);
+    for (int l = 0; l < kLabels; ++l)
+        out += QString("%1").arg(FileService::classId2Token(l), 8);
+    out += QString("%1\n").arg("合计", 9);
+    for (int c = 0; c < kColors; ++c) {
+        out += QString("%1").arg(FileService::colorId2Letter(c), -6);
+        for (int l = 0; l < kLabels; ++l)
+            out += QString("%1").arg(perClass[c * kLabels + l], 8);
+        out += QString("%1\n").arg(perColor(c), 10);
+    }
+    out += QString("%1").arg("合计", -5);
+    for (int l = 0; l < kLabels; ++l)
+        out += QString("%1").arg(perLabel(l), 8);
+    out += QString("%1\n\n").arg(plates, 10);
+
+    out += "每图装甲板数\n";
+    for (int i = 0; i < kPlateBins; ++i) {
+        if (!platesPerImage[i])
+            continue;
+        out += QString("  %1%2  %3 (%4%)\n")
+                   .arg(i, 2)
+                   .arg(i == kPlateBins - 1 ? "+" : " ")
+                   .arg(platesPerImage[i], 8)
+                   .arg(pct(platesPerImage[i], images), 5, 'f', 1);
+    }
+
+    out += "\n角点四边形面积 (px²)\n";
+    for (int i = 0; i < kAreaBins; ++i) {
+        if (!areaLog2[i])
+            continue;
+        out += QString("  [%1, %2)  %3 (%4%)\n")
+                   .arg(i ? (qint64(1) << i) : 0, 8)
+                   .arg(qint64(1) << (i + 1), -8)
+                   .arg(areaLog2[i], 8)
+                   .arg(pct(areaLog2[i], plates), 5, 'f', 1);
+    }
+    return out;
+}
+
+// ---------- DatasetStats ----------
+DatasetStats::DatasetStats(const LabelStore* labels, QObject* parent)
+    : QObject(parent)
+    , labels_(labels) {
+    qRegisterMetaType<DatasetStatsSnapshot>("DatasetStatsSnapshot");
+    connect(labels_, &LabelStore::ready, this, &DatasetStats::rebuild);
+    connect(labels_, &LabelStore::imagesChanged, this, &DatasetStats::refresh);
+}
+
+ImageStats DatasetStats::statsFor(const std::vector<Plate>& plates, bool labeled) {
+    ImageStats s;
+    s.labeled = labeled;
+    s.plates.reserve(qsizetype(plates.size()));
+    for (const auto& p : plates)
+        s.plates.push_back(quint16((p.classIndex() << 8) | areaBin(p)));
+    return s;
+}
+
+DatasetStatsSnapshot DatasetStats::fromTable(const LabelTable& table, QHash<QString, ImageStats>* perImage) {
+    DatasetStatsSnapshot total;
+    if (perImage) {
+        perImage->clear();
+        perImage->reserve(table.imageCount());
+    }
+    for (quint32 id = 0; id < quint32(table.imageCount()); ++id) {
+        const LabelTable::Image& im = table.image(id);
+        if (!im.alive)
+            continue;
+        ImageStats s = statsFor(table.plates(id), im.labeled);
+        total.add(s);
+        if (perImage)
+            perImage->insert(im.path, std::move(s));
+    }
+    return total;
+}
+
+DatasetStatsSnapshot DatasetStats::compute(const QString& root, QThreadPool& pool, const std::atomic_bool* cancel) {
+    const LabelStore::Built built = LabelStore::build(root, pool, cancel);
+    if (cancel && cancel->load())
+        return {};
+    return fromTable(built.table);
+}
+
+void DatasetStats::rebuild() {
+    root_  = labels_->root();
+    total_ = fromTable(labels_->table(), &perImage_);
+    LOGI(QString("数据集统计完成：%1 张图片，%2 个装甲板").arg(total_.images).arg(total_.plates));
+    emit changed(total_);
+}
+
+void DatasetStats::refresh(const QStringList& imagePaths) {
+    LabelStore::ImageLabels labels;
+    for (const QString& p : imagePaths) {
+        if (labels_->lookup(p, labels)) {
+            const ImageStats next = statsFor(labels.plates, labels.labeled);
+            apply(p, &next);
+        } else {
+            apply(p, nullptr);
+        }
+    }
+    emit changed(total_);
+}
+
+void DatasetStats::apply(const QString& imagePath, const ImageStats* next) {
+    auto it = perImage_.find(imagePath);
+    if (it != perImage_.end()) {
+        total_.add(*it, -1);
+        if (!next) {
+            perImage_.erase(it);
+            return;
+        }
+        *it = *next;
+    } else if (next) {
+        it = perImage_.insert(imagePath, *next);
+    } else {
+        return;
+    }
+    total_.add(*it);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "types.hpp"
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+class LabelStore;
+class LabelTable;
+
+// 单张图片对统计的贡献；增量更新时先减旧值再加新值
+struct ImageStats {
+    bool labeled = false;     // 存在标注文件
+    QVector<quint16> plates;  // 每个装甲板：(类别 << 8) | 面积分桶
+};
+
+// 全数据集统计结果（纯值类型，可跨线程拷贝）
+struct DatasetStatsSnapshot {
+    static constexpr int kColors    = kColorCount; // B R G P
+    static constexpr int kLabels    = kClassCount; // G 1 2 3 4 O Bs Bb
+    static constexpr int kClasses   = kColors * kLabels;
+    static constexpr int kPlateBins = 17; // 0..15，最后一格为 16+
+    static constexpr int kAreaBins  = 24; // 第 k 格：[2^k, 2^(k+1)) px²
+
+    qint64 images    = 0;
+    qint64 unlabeled = 0;
+    qint64 plates    = 0;
+    std::array<qint64, kClasses> perClass{};
+    std::array<qint64, kPlateBins> platesPerImage{};
+    std::array<qint64, kAreaBins> areaLog2{};
+
+    void add(const ImageStats& s, int sign = 1);
+    void merge(const DatasetStatsSnapshot& o);
+    qint64 perColor(int color) const;
+    qint64 perLabel(int label) const;
+    QString toText() const; // 面板与 CLI 共用的纯文本报表
+};
+Q_DECLARE_METATYPE(DatasetStatsSnapshot)
+
+// 统计引擎：不自己扫描，从 LabelStore 的标注表派生——建表就绪时全量重算，之后跟随表的增量
+class DatasetStats : public QObject {
+    Q_OBJECT
+public:
+    explicit DatasetStats(const LabelStore* labels, QObject* parent = nullptr);
+
+    static ImageStats statsFor(const std::vector<Plate>& plates, bool labeled);
+    // perImage 非空时同时返回逐图贡献
+    static DatasetStatsSnapshot fromTable(const LabelTable& table, QHash<QString, ImageStats>* perImage = nullptr);
+    // 同步全量计算（CLI 直接调用）：与 GUI 共用 LabelStore::build 的扫描
+    static DatasetStatsSnapshot compute(
+        const QString& root, QThreadPool& pool, const std::atomic_bool* cancel = nullptr);
+
+    const DatasetStatsSnapshot& snapshot() const { return total_; }
+    const QString& root() const { return root_; }
+
+signals:
+    void changed(const DatasetStatsSnapshot& snapshot);
+
+private:
+    void rebuild();                                // 标注表已就绪
+    void refresh(const QStringList& imagePaths);   // 标注表中这些图片已更新/删除
+    void apply(const QString& imagePath, const ImageStats* next); // next 为空表示移除
+
+    const LabelStore* labels_;
+    QString root_;
+    DatasetStatsSnapshot total_;
+    QHash<QString, ImageStats> perImage_;
+};
@@ -0,0 +1,214 @@
+#include "service/dataset_watcher.hpp"
+#include "logger/core.hpp"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <cerrno>
+#include <memory>
+#include <utility>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace {
+constexpr int kBatchMs = 200; // 批次窗口：从第一条事件起算，不随后续事件顺延
+
+// IN_CREATE 只用于发现子目录；文件以写完关闭或移入为准，避免索引到写了一半的图片
+constexpr quint32 kWatchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM
+                             | IN_MOVED_TO | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+} // namespace
+
+DatasetWatcher::DatasetWatcher(QObject* parent)
+    : QObject(parent) {
+    batchTimer_ = new QTimer(this);
+    batchTimer_->setSingleShot(true);
+    batchTimer_->setInterval(kBatchMs);
+    connect(batchTimer_, &QTimer::timeout, this, &DatasetWatcher::flushBatch);
+}
+
+DatasetWatcher::~DatasetWatcher() { stop(); }
+
+void DatasetWatcher::stop() {
+    cancel_.store(true);
+    if (driver_.joinable())
+        driver_.join();
+    ++generation_; // 丢弃已投递但尚未安装的扫描结果
+    delete notifier_;
+    notifier_ = nullptr;
+    if (fd_ >= 0)
+        ::close(fd_); // 关闭即注销全部监视
+    fd_ = -1;
+    batchTimer_->stop();
+    root_.clear();
+    index_.clear();
+    dirs_.clear();
+    movedFrom_.clear();
+    renamed_.clear();
+    added_.clear();
+    removed_.clear();
+    ready_ = false;
+}
+
+void DatasetWatcher::start(const QString& root) {
+    stop();
+    root_ = QDir(root).absolutePath();
+    fd_   = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) {
+        LOGW(QString("inotify 不可用，目录变更不会自动同步：%1").arg(qt_error_string(errno)));
+        return;
+    }
+    // 索引安装前不读事件：内核队列会先替我们攒着
+    notifier_ = new QSocketNotifier(fd_, QSocketNotifier::Read, this);
+    notifier_->setEnabled(false);
+    connect(notifier_, &QSocketNotifier::activated, this, &DatasetWatcher::readEvents);
+
+    cancel_.store(false);
+    const quint64 gen = generation_;
+    driver_           = std::thread([this, fd = fd_, root = root_, gen] {
+        // 先注册监视再列文件：两者之间新落盘的文件会同时出现在扫描结果和事件里（幂等）
+        auto scan = std::make_shared<Scan>();
+        watchTree(fd, root, scan->dirs);
+        if (!scan->index.build(root, &cancel_) || cancel_.load())
+            return;
+        QMetaObject::invokeMethod(this, [this, gen, scan] { install(gen, scan.get()); });
+    });
+}
+
+void DatasetWatcher::watchTree(int fd, const QString& dir, QHash<int, QString>& dirs) {
+    auto add = [&](const QString& d) {
+        const int wd = ::inotify_add_watch(fd, QFile::encodeName(d).constData(), kWatchMask);
+        if (wd >= 0)
+            dirs.insert(wd, d);
+        else if (errno == ENOSPC)
+            LOGW("inotify 监视数已达上限（fs.inotify.max_user_watches），部分子目录不会自动同步");
+    };
+    add(dir);
+    QDirIterator it(dir, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext())
+        add(it.next());
+}
+
+void DatasetWatcher::install(quint64 gen, Scan* scan) {
+    if (gen != generation_)
+        return;
+    dirs_  = std::move(scan->dirs);
+    index_ = std::move(scan->index);
+    ready_ = true;
+    LOGI(QString("目录监视就绪：%1 个目录，%2 张图片").arg(dirs_.size()).arg(index_.size()));
+    emit ready(int(index_.size()));
+    notifier_->setEnabled(true);
+    readEvents(); // 处理扫描期间积压的事件
+}
+
+void DatasetWatcher::readEvents() {
+    alignas(inotify_event) char buf[64 * 1024];
+    for (;;) {
+        const ssize_t n = ::read(fd_, buf, sizeof(buf));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR)
+                continue;
+            break; // EAGAIN：读空了
+        }
+        for (ssize_t off = 0; off < n;) {
+            const auto* ev = reinterpret_cast<const inotify_event*>(buf + off);
+            off += ssize_t(sizeof(inotify_event) + ev->len);
+
+            if (ev->mask & IN_Q_OVERFLOW) {
+                // 内核队列溢出，事件已丢失：只有这种情况才整树重建
+                LOGW("inotify 事件队列溢出，重新建立索引");
+                QMetaObject::invokeMethod(
+                    this, [this, root = root_] { start(root); }, Qt::QueuedConnection);
+                return;
+            }
+            if (ev->mask & IN_IGNORED) {
+                dirs_.remove(ev->wd);
+                continue;
+            }
+            const auto dirIt = dirs_.constFind(ev->wd);
+            if (dirIt == dirs_.constEnd() || ev->len == 0 || ev->name[0] == '.')
+                continue; // 已注销的目录 / 目录自身事件 / 隐藏文件
+            const QString path = *dirIt + '/' + QFile::decodeName(ev->name);
+
+            if (ev->mask & IN_ISDIR) {
+                if (ev->mask & (IN_CREATE | IN_MOVED_TO))
+                    dirAppeared(path);
+                else if (ev->mask & (IN_DELETE | IN_MOVED_FROM))
+                    dirDisappeared(path);
+                continue;
+            }
+            if (!DatasetIndex::isImageFile(path))
+                continue;
+            if (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                fileAppeared(path);
+                if ((ev->mask & IN_MOVED_TO) && movedFrom_.contains(ev->cookie))
+                    renamed_.insert(movedFrom_.take(ev->cookie), path);
+            } else if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                fileDisappeared(path);
+                if (ev->mask & IN_MOVED_FROM)
+                    movedFrom_.insert(ev->cookie, path);
+            }
+        }
+    }
+}
+
+void DatasetWatcher::dirAppeared(const QString& dir) {
+    watchTree(fd_, dir, dirs_);
+    QDirIterator it(
+        dir, DatasetIndex::imageFilters(), QDir::Files | QDir::NoDotAndDotDot,
+        QDirIterator::Subdirectories);
+    while (it.hasNext())
+        fileAppeared(it.next());
+}
+
+void DatasetWatcher::dirDisappeared(const QString& dir) {
+    const QString prefix = dir + '/';
+    for (auto it = dirs_.begin(); it != dirs_.end();) {
+        if (it.value() == dir || it.value().startsWith(prefix)) {
+            ::inotify_rm_watch(fd_, it.key()); // 移出的目录仍然存在，需要手动注销
+            it = dirs_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (const QString& p : index_.listUnder(dir))
+        removed_.insert(p);
+    added_.removeIf([&](const QString& p) { return p.startsWith(prefix); }); // 本批次刚出现又被移走
+    if (!batchTimer_->isActive())
+        batchTimer_->start();
+}
+
+// 事件只记进 added_/removed_，索引在 flushBatch() 一次归并：
+// 成千上万个文件的批量拷贝/移动不会逐条在有序数组中间插删
+void DatasetWatcher::fileAppeared(const QString& path) {
+    removed_.remove(path); // 已存在（被覆盖写）同样上报，让下游刷新
+    added_.insert(path);
+    if (!batchTimer_->isActive())
+        batchTimer_->start();
+}
+
+void DatasetWatcher::fileDisappeared(const QString& path) {
+    const bool pending = added_.remove(path);
+    if (index_.indexOf(path) >= 0)
+        removed_.insert(path);
+    else if (!pending)
+        return; // 从未入索引
+    if (!batchTimer_->isActive())
+        batchTimer_->start();
+}
+
+void DatasetWatcher::flushBatch() {
+    movedFrom_.clear(); // 跨批次仍未配对的移出视为删除
+    const QStringList added(added_.begin(), added_.end());
+    const QStringList removed(removed_.begin(), removed_.end());
+    const auto renamed = std::exchange(renamed_, {});
+    added_.clear();
+    removed_.clear();
+    index_.applyBatch(added, removed);
+    if (!added.isEmpty() || !removed.isEmpty())
+        emit indexChanged(added, removed);
+    for (auto it = renamed.begin(); it != renamed.end(); ++it)
+        emit fileRenamed(it.key(), it.value());
+}
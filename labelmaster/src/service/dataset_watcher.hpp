@@ -0,0 +1,65 @@
+#pragma once
+#include "service/dataset_index.hpp"
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+#include <thread>
+
+class QSocketNotifier;
+class QTimer;
+
+// 基于 inotify 的数据集变更源：初次建立索引后只按事件增量维护 DatasetIndex，
+// 突发事件合并成批（kBatchMs 内最多一次 indexChanged），从不重扫整棵目录树
+class DatasetWatcher : public QObject {
+    Q_OBJECT
+public:
+    explicit DatasetWatcher(QObject* parent = nullptr);
+    ~DatasetWatcher() override;
+
+    const DatasetIndex& index() const { return index_; }
+    const QString& root() const { return root_; }
+    bool isReady() const { return ready_; }
+
+public slots:
+    void start(const QString& root); // 后台注册监视 + 建索引，完成后发 ready()
+    void stop();
+
+signals:
+    void ready(int images);
+    void indexChanged(const QStringList& added, const QStringList& removed); // added 含被覆盖写的图片
+    void fileRenamed(const QString& from, const QString& to); // 在同批 indexChanged 之后发出
+
+private:
+    struct Scan {
+        QHash<int, QString> dirs; // wd → 目录
+        DatasetIndex index;
+    };
+    static void watchTree(int fd, const QString& dir, QHash<int, QString>& dirs); // 含子目录
+    void install(quint64 gen, Scan* scan);
+    void readEvents();
+    void dirAppeared(const QString& dir);    // 新建或移入的子目录：只扫这一棵
+    void dirDisappeared(const QString& dir); // 删除或移出的子目录
+    void fileAppeared(const QString& path);
+    void fileDisappeared(const QString& path);
+    void flushBatch();
+
+    int fd_                     = -1;
+    QSocketNotifier* notifier_  = nullptr;
+    QTimer* batchTimer_         = nullptr;
+    QString root_;
+    DatasetIndex index_;
+    QHash<int, QString> dirs_;
+    QHash<quint32, QString> movedFrom_; // cookie → 路径（等待配对的 IN_MOVED_FROM）
+    QHash<QString, QString> renamed_;   // 本批次内的重命名 旧 → 新
+    QSet<QString> added_;
+    QSet<QString> removed_;
+    bool ready_ = false;
+
+    quint64 generation_ = 0;
+    std::thread driver_;
+    std::atomic_bool cancel_{false};
+};
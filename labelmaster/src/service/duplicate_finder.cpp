@@ -0,0 +1,218 @@
+#include "service/duplicate_finder.hpp"
+#include "logger/core.hpp"
+#include "service/dataset_index.hpp"
+#include "util/atomic_file.hpp"
+#include "util/bk_tree.hpp"
+#include "util/parallel.hpp"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QThread>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace {
+constexpr quint32 kCacheMagic   = 0x41444831; // "ADH1"
+constexpr int kProgressStep     = 128;
+constexpr int kDecodeW          = 72; // 缩小解码的目标尺寸（JPEG 走 DCT 降采样，远快于全尺寸）
+constexpr int kDecodeH          = 64;
+} // namespace
+
+DuplicateFinder::DuplicateFinder(QObject* parent)
+    : QObject(parent) {
+    pool_.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+}
+
+DuplicateFinder::~DuplicateFinder() {
+    cancel();
+    if (driver_.joinable())
+        driver_.join();
+}
+
+void DuplicateFinder::cancel() { cancel_.store(true); }
+
+bool DuplicateFinder::dHash(const QString& imagePath, quint64& out) {
+    QImageReader reader(imagePath);
+    const QSize full = reader.size();
+    if (full.isValid() && full.width() > kDecodeW && full.height() > kDecodeH)
+        reader.setScaledSize(full.scaled(kDecodeW, kDecodeH, Qt::KeepAspectRatioByExpanding));
+    QImage img = reader.read();
+    if (img.isNull())
+        return false;
+    img = img.convertToFormat(QImage::Format_Grayscale8)
+              .scaled(9, 8, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    quint64 h = 0;
+    for (int y = 0; y < 8; ++y) {
+        const uchar* row = img.constScanLine(y);
+        for (int x = 0; x < 8; ++x)
+            h = (h << 1) | quint64(row[x] < row[x + 1]);
+    }
+    out = h;
+    return true;
+}
+
+// ---------- 哈希缓存：相对路径 → (大小, mtime, dHash) ----------
+QHash<QString, DuplicateFinder::CacheRecord> DuplicateFinder::loadCache(const QString& root) {
+    QHash<QString, CacheRecord> cache;
+    QFile f(root + "/" + kCacheName);
+    if (!f.open(QIODevice::ReadOnly))
+        return cache;
+    QDataStream in(&f);
+    quint32 magic = 0, count = 0;
+    in >> magic >> count;
+    if (magic != kCacheMagic)
+        return cache;
+    cache.reserve(count);
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString rel;
+        CacheRecord r;
+        in >> rel >> r.size >> r.mtime >> r.hash;
+        cache.insert(rel, r);
+    }
+    if (in.status() != QDataStream::Ok)
+        cache.clear(); // 截断/损坏：整体作废，重新计算
+    return cache;
+}
+
+bool DuplicateFinder::saveCache(const QString& root, const QHash<QString, CacheRecord>& cache) {
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out << kCacheMagic << quint32(cache.size());
+    for (auto it = cache.begin(); it != cache.end(); ++it)
+        out << it.key() << it->size << it->mtime << it->hash;
+    return util::writeFileAtomic(root + "/" + kCacheName, bytes);
+}
+
+bool DuplicateFinder::start(const QString& root, int radius) {
+    if (running_.exchange(true))
+        return false;
+    if (driver_.joinable())
+        driver_.join();
+    cancel_.store(false);
+    driver_ = std::thread([this, root = QDir(root).absolutePath(), radius] { run(root, radius); });
+    return true;
+}
+
+void DuplicateFinder::run(const QString& root, int radius) {
+    if (!QDir(root).isReadable()) {
+        running_.store(false);
+        emit failed(QString("无法读取目录：%1").arg(root));
+        return;
+    }
+    DatasetIndex index;
+    if (!index.build(root, &cancel_)) {
+        running_.store(false);
+        emit finished(0, 0, 0, true);
+        return;
+    }
+    const qsizetype n = index.size();
+    const QDir rootDir(root);
+    const auto cache = loadCache(root);
+
+    std::vector<quint64> hashes(n);
+    std::vector<CacheRecord> records(n);
+    std::vector<char> ok(n, 0);
+    std::atomic_int done{0}, computed{0};
+    emit progress(0, int(n));
+
+    util::parallelFor(
+        pool_, n, 16,
+        [&](qsizetype i) {
+            const QFileInfo fi(index.at(i).imagePath);
+            CacheRecord r{fi.size(), fi.lastModified().toMSecsSinceEpoch(), 0};
+            const auto hit = cache.constFind(rootDir.relativeFilePath(fi.filePath()));
+            if (hit != cache.constEnd() && hit->size == r.size && hit->mtime == r.mtime) {
+                r.hash = hit->hash;
+                ok[i]  = 1;
+            } else if (dHash(fi.filePath(), r.hash)) {
+                ok[i] = 1;
+                computed.fetch_add(1, std::memory_order_relaxed);
+            }
+            records[i] = r;
+            hashes[i]  = r.hash;
+            const int d = done.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (d % kProgressStep == 0 || d == n)
+                emit progress(d, int(n));
+        },
+        &cancel_);
+
+    if (cancel_.load()) {
+        running_.store(false);
+        emit finished(0, 0, 0, true);
+        return;
+    }
+    const int unreadable = int(std::count(ok.begin(), ok.end(), 0));
+    if (unreadable > 0 && unreadable == n) {
+        running_.store(false);
+        emit failed(QString("%1 张图片都无法计算哈希").arg(n));
+        return;
+    }
+    if (unreadable > 0)
+        LOGW(QString("近重复查找：%1 张图片无法计算哈希，未参与聚类").arg(unreadable));
+
+    // 只保留当前仍存在的图片：缓存随数据集自然收缩
+    QHash<QString, CacheRecord> fresh;
+    fresh.reserve(n);
+    for (qsizetype i = 0; i < n; ++i)
+        if (ok[i])
+            fresh.insert(rootDir.relativeFilePath(index.at(i).imagePath), records[i]);
+    if (computed.load() > 0 && !saveCache(root, fresh))
+        LOGW(QString("哈希缓存写入失败：%1/%2").arg(root, kCacheName));
+
+    // 领头聚类：按路径顺序（录像帧即时间顺序），每张图加入半径内最近的代表，否则自成代表。
+    // 只和代表比较，簇直径不超过 2r，缓慢平移的长镜头不会被串成一整簇
+    util::BkTree leaders;
+    auto clusters = std::make_shared<QVector<QStringList>>();
+    for (qsizetype i = 0; i < n; ++i) {
+        if (!ok[i])
+            continue;
+        const auto [c, dist] = leaders.nearest(hashes[i], radius);
+        if (c >= 0) {
+            (*clusters)[c].push_back(index.at(i).imagePath);
+        } else {
+            leaders.insert(hashes[i], int(clusters->size()));
+            clusters->push_back({index.at(i).imagePath});
+        }
+    }
+    clusters->removeIf([](const QStringList& c) { return c.size() < 2; });
+
+    LOGI(QString("近重复查找完成：%1 张，新算哈希 %2，%3 个重复簇")
+             .arg(n)
+             .arg(computed.load())
+             .arg(clusters->size()));
+
+    QMetaObject::invokeMethod(this, [this, root, clusters, unreadable] {
+        root_     = root;
+        clusters_ = std::move(*clusters);
+        redundant_.clear();
+        for (const auto& c : clusters_)
+            for (qsizetype k = 1; k < c.size(); ++k)
+                redundant_.insert(c[k]);
+        running_.store(false);
+        emit finished(int(clusters_.size()), int(redundant_.size()), unreadable, false);
+    });
+}
+
+void DuplicateFinder::forget(const QString& imagePath) { redundant_.remove(imagePath); }
+
+QString DuplicateFinder::reportText() const {
+    QString out = QString("# %1\n# %2 个近重复簇，%3 张冗余图片\n")
+                      .arg(root_)
+                      .arg(clusters_.size())
+                      .arg(redundant_.size());
+    const QDir rootDir(root_);
+    for (qsizetype i = 0; i < clusters_.size(); ++i) {
+        out += QString("\n[%1] %2 张\n").arg(i + 1).arg(clusters_[i].size());
+        for (qsizetype k = 0; k < clusters_[i].size(); ++k)
+            out += QString(k ? "  %1\n" : "* %1\n").arg(rootDir.relativeFilePath(clusters_[i][k]));
+    }
+    return out;
+}
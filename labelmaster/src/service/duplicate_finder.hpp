@@ -0,0 +1,61 @@
+#pragma once
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+#include <atomic>
+#include <thread>
+
+// 近重复图片查找：并行计算 dHash（缩小尺寸解码），BK 树按顺序做领头聚类。
+// 哈希按 (大小, mtime) 缓存在数据集根目录的 kCacheName 里，再次运行只算新增/改动的图片
+class DuplicateFinder : public QObject {
+    Q_OBJECT
+public:
+    static constexpr const char* kCacheName = ".atlm_dhash"; // 隐藏文件：索引与监视都会忽略
+
+    explicit DuplicateFinder(QObject* parent = nullptr);
+    ~DuplicateFinder() override;
+
+    // 64 位 dHash：灰度 9×8，相邻像素比较；失败返回 false
+    static bool dHash(const QString& imagePath, quint64& out);
+
+    bool isRunning() const { return running_.load(); }
+    const QString& root() const { return root_; }
+    // 每簇第一张是代表（路径序最靠前），其余视为冗余
+    const QVector<QStringList>& clusters() const { return clusters_; }
+    bool isRedundant(const QString& imagePath) const { return redundant_.contains(imagePath); }
+    QString reportText() const;
+
+public slots:
+    bool start(const QString& root, int radius); // 已在运行时返回 false
+    void cancel();
+    void forget(const QString& imagePath);       // 图片已被删除
+
+signals:
+    void progress(int done, int total);
+    void finished(int clusters, int redundant, int unreadable, bool cancelled); // unreadable：算不出哈希、未参与聚类
+    void failed(const QString& why); // 根目录不可读或没有一张图能算出哈希（与取消区分）
+
+private:
+    struct CacheRecord {
+        qint64 size  = 0;
+        qint64 mtime = 0;
+        quint64 hash = 0;
+    };
+    static QHash<QString, CacheRecord> loadCache(const QString& root);
+    static bool saveCache(const QString& root, const QHash<QString, CacheRecord>& cache);
+    void run(const QString& root, int radius);
+
+    QString root_;
+    QVector<QStringList> clusters_;
+    QSet<QString> redundant_;
+
+    QThreadPool pool_;
+    std::thread driver_;
+    std::atomic_bool running_{false};
+    std::atomic_bool cancel_{false};
+};
@@ -0,0 +1,598 @@
+#include "service/exporter.hpp"
+#include "logger/core.hpp"
+#include "service/dataset_index.hpp"
+#include "service/file.hpp"
+#include "dataset/pack_format.hpp"
+#include "util/atomic_file.hpp"
+#include "util/file_copy.hpp"
+#include "util/parallel.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+// 每批并行转换的图片数。chunk 只含标注文本与元数据（每张几百字节），
+// 图片字节不进批次：分片包由 append() 从源文件流式拷贝
+constexpr qsizetype kBatch = 1024;
+constexpr int kNumLabels   = kClassCount; // G 1 2 3 4 O Bs Bb
+constexpr int kNumColors   = kColorCount; // B R G P
+
+void appendInt(QByteArray& out, long long v) {
+    char buf[24];
+    auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, r.ptr - buf);
+}
+void appendReal(QByteArray& out, double v, int precision) {
+    char buf[48];
+    auto r = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::fixed, precision);
+    if (r.ec != std::errc())
+        out.append('0');
+    else
+        out.append(buf, r.ptr - buf);
+}
+void appendJsonString(QByteArray& out, const QString& s) {
+    out.append('"');
+    for (char c : s.toUtf8()) {
+        switch (c) {
+        case '"': out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\n': out.append("\\n"); break;
+        case '\t': out.append("\\t"); break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                out.append(' ');
+            else
+                out.append(c);
+        }
+    }
+    out.append('"');
+}
+
+struct Bounds {
+    double x0, y0, x1, y1;
+};
+Bounds boundsOf(const Plate& a) {
+    Bounds b{a.pts[0], a.pts[1], a.pts[0], a.pts[1]};
+    for (int k = 2; k < 8; k += 2) {
+        b.x0 = std::min<double>(b.x0, a.pts[k]);
+        b.y0 = std::min<double>(b.y0, a.pts[k + 1]);
+        b.x1 = std::max<double>(b.x1, a.pts[k]);
+        b.y1 = std::max<double>(b.y1, a.pts[k + 1]);
+    }
+    return b;
+}
+
+// ---------- YOLO-pose：images/<rel>，labels/<rel>.txt，data.yaml ----------
+// 每行：cls cx cy w h x1 y1 v1 … x4 y4 v4（全部归一化，v=2 可见）
+class YoloPoseExporter final : public DatasetExporter {
+public:
+    QString imageSubdir() const override { return "images"; }
+
+    bool begin(const QString& outDir, qsizetype, QString& err) override {
+        outDir_ = outDir;
+        if (!QDir().mkpath(outDir_ + "/labels")) {
+            err = "cannot create " + outDir_ + "/labels";
+            return false;
+        }
+        return true;
+    }
+
+    bool convert(const ExportItem& item, ExportChunk&, QString& err) const override {
+        const double W = item.size.width(), H = item.size.height();
+        QByteArray text;
+        text.reserve(qsizetype(item.plates.size()) * 160);
+        for (const auto& a : item.plates) {
+            const Bounds b = boundsOf(a);
+            const double x0 = std::clamp(b.x0 / W, 0.0, 1.0), x1 = std::clamp(b.x1 / W, 0.0, 1.0);
+            const double y0 = std::clamp(b.y0 / H, 0.0, 1.0), y1 = std::clamp(b.y1 / H, 0.0, 1.0);
+            appendInt(text, a.classIndex());
+            for (double v : {(x0 + x1) / 2, (y0 + y1) / 2, x1 - x0, y1 - y0}) {
+                text.append(' ');
+                appendReal(text, v, 6);
+            }
+            for (int k = 0; k < 8; k += 2) {
+                text.append(' ');
+                appendReal(text, a.pts[k] / W, 6);
+                text.append(' ');
+                appendReal(text, a.pts[k + 1] / H, 6);
+                text.append(" 2");
+            }
+            text.append('\n');
+        }
+
+        const QFileInfo rel(item.relPath);
+        const QString dir = QDir::cleanPath(outDir_ + "/labels/" + rel.path());
+        QDir().mkpath(dir);
+        return util::writeFileAtomic(
+            dir + "/" + rel.completeBaseName() + ".txt", text, util::FsyncPolicy::None, &err);
+    }
+
+    bool append(const ExportChunk&, QString&) override { return true; }
+
+    bool finish(bool ok, QString& err) override {
+        if (!ok)
+            return true;
+        QByteArray yaml;
+        yaml.append("path: ").append(QFile::encodeName(outDir_)).append('\n');
+        yaml.append("train: images\nval: images\n");
+        yaml.append("kpt_shape: [4, 3]\n");
+        yaml.append("flip_idx: [3, 2, 1, 0]\n"); // TL↔TR，BL↔BR
+        yaml.append("names:\n");
+        for (int c = 0; c < kNumColors * kNumLabels; ++c) {
+            yaml.append("  ");
+            appendInt(yaml, c);
+            yaml.append(": ").append(className(c).toUtf8()).append('\n');
+        }
+        return util::writeFileAtomic(outDir_ + "/data.yaml", yaml, util::FsyncPolicy::None, &err);
+    }
+
+private:
+    QString outDir_;
+};
+
+// ---------- COCO keypoints：annotations.json（流式写出，不构建 DOM） ----------
+// images 直接写主文件；annotations 先写临时文件，finish() 时拼接。
+// convert() 并行产出不带 id 的标注（每个一行），append() 串行时按全局计数补上 id
+class CocoExporter final : public DatasetExporter {
+public:
+    QString imageSubdir() const override { return "images"; }
+
+    bool begin(const QString& outDir, qsizetype, QString& err) override {
+        finalPath_ = outDir + "/annotations.json";
+        main_.setFileName(finalPath_ + ".tmp");
+        anns_.setFileName(finalPath_ + ".anns.tmp");
+        if (!main_.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || !anns_.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+            err = main_.isOpen() ? anns_.errorString() : main_.errorString();
+            return false;
+        }
+        main_.write("{\"info\":{\"description\":\"ATLabelMaster export\"},\"images\":[");
+        return true;
+    }
+
+    bool convert(const ExportItem& item, ExportChunk& out, QString&) const override {
+        QByteArray& img = out.primary;
+        img.append("{\"id\":");
+        appendInt(img, item.id);
+        img.append(",\"file_name\":");
+        appendJsonString(img, item.relPath);
+        img.append(",\"width\":");
+        appendInt(img, item.size.width());
+        img.append(",\"height\":");
+        appendInt(img, item.size.height());
+        img.append('}');
+
+        QByteArray& anns = out.secondary;
+        for (const auto& a : item.plates) {
+            const Bounds b = boundsOf(a);
+            anns.append("\"image_id\":");
+            appendInt(anns, item.id);
+            anns.append(",\"category_id\":");
+            appendInt(anns, a.classIndex());
+            anns.append(",\"iscrowd\":0,\"num_keypoints\":4,\"area\":");
+            appendReal(anns, a.area(), 2);
+            anns.append(",\"bbox\":[");
+            appendReal(anns, b.x0, 2);
+            anns.append(',');
+            appendReal(anns, b.y0, 2);
+            anns.append(',');
+            appendReal(anns, b.x1 - b.x0, 2);
+            anns.append(',');
+            appendReal(anns, b.y1 - b.y0, 2);
+            anns.append("],\"keypoints\":[");
+            for (int i = 0; i < 4; ++i) {
+                if (i)
+                    anns.append(',');
+                appendReal(anns, a.pts[2 * i], 2);
+                anns.append(',');
+                appendReal(anns, a.pts[2 * i + 1], 2);
+                anns.append(",2");
+            }
+            anns.append("]}\n");
+        }
+        return true;
+    }
+
+    bool append(const ExportChunk& chunk, QString& err) override {
+        if (nImages_++)
+            main_.write(",");
+        main_.write(chunk.primary);
+        QByteArray buf;
+        buf.reserve(chunk.secondary.size() + chunk.secondary.count('\n') * 16);
+        for (qsizetype pos = 0, eol; pos < chunk.secondary.size(); pos = eol + 1) {
+            eol = chunk.secondary.indexOf('\n', pos);
+            if (lastAnnId_)
+                buf.append(',');
+            buf.append("{\"id\":");
+            appendInt(buf, ++lastAnnId_);
+            buf.append(',');
+            buf.append(chunk.secondary.constData() + pos, eol - pos);
+        }
+        anns_.write(buf);
+        if (main_.error() != QFile::NoError || anns_.error() != QFile::NoError) {
+            err = main_.error() != QFile::NoError ? main_.errorString() : anns_.errorString();
+            return false;
+        }
+        return true;
+    }
+
+    bool finish(bool ok, QString& err) override {
+        if (ok) {
+            main_.write("],\"annotations\":[");
+            anns_.seek(0);
+            while (!anns_.atEnd())
+                main_.write(anns_.read(1 << 20));
+            main_.write("],\"categories\":[");
+            for (int c = 0; c < kNumColors * kNumLabels; ++c) {
+                QByteArray cat;
+                if (c)
+                    cat.append(',');
+                cat.append("{\"id\":");
+                appendInt(cat, c);
+                cat.append(",\"name\":");
+                appendJsonString(cat, className(c));
+                cat.append(",\"supercategory\":\"armor\",\"keypoints\":[\"tl\",\"bl\",\"br\",\"tr\"],"
+                           "\"skeleton\":[[1,2],[2,3],[3,4],[4,1]]}");
+                main_.write(cat);
+            }
+            main_.write("]}\n");
+            ok = main_.flush() && main_.error() == QFile::NoError;
+            if (!ok)
+                err = main_.errorString();
+        }
+        main_.close();
+        anns_.close();
+        QFile::remove(anns_.fileName());
+        if (!ok) {
+            QFile::remove(main_.fileName());
+            return false;
+        }
+        if (::rename(QFile::encodeName(main_.fileName()), QFile::encodeName(finalPath_)) != 0) {
+            err = "rename failed";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    QString finalPath_;
+    QFile main_;
+    QFile anns_;
+    qsizetype nImages_   = 0;
+    long long lastAnnId_ = 0; // annotation id 全局递增，从 1 开始
+};
+// ---------- 训练分片包：shard-NNNNN.atlpack + manifest.json ----------
+// convert() 并行编码列式标注并记下图片大小；append() 顺序把图片从源文件分块拷进当前分片，
+// 超过 kShardBytes 时封口（写表 → 回填头 → rename），读取端见 dataset/pack_reader.hpp
+class PackExporter final : public DatasetExporter {
+public:
+    static constexpr qint64 kShardBytes = qint64(1) << 30; // 每个分片约 1 GiB
+
+    QString imageSubdir() const override { return {}; } // 图片直接打进分片
+
+    bool begin(const QString& outDir, qsizetype, QString& err) override {
+        outDir_ = outDir;
+        return openShard(err);
+    }
+
+    bool convert(const ExportItem& item, ExportChunk& out, QString& err) const override {
+        const QFileInfo fi(item.imagePath);
+        if (!fi.isReadable()) {
+            err = "image not readable";
+            return false;
+        }
+        out.sourcePath  = item.imagePath;
+        out.sourceBytes = fi.size();
+        out.size        = item.size;
+        out.relPath     = item.relPath;
+
+        // secondary：每个装甲板 color u8, label u8, 8 × f32（归一化）
+        const float W = float(item.size.width()), H = float(item.size.height());
+        out.secondary.resize(qsizetype(item.plates.size()) * kArmorBytes);
+        char* p = out.secondary.data();
+        for (const auto& a : item.plates) {
+            p[0] = char(a.color);
+            p[1] = char(a.cls);
+            float pts[pack::kPointsPerArmor];
+            for (int k = 0; k < pack::kPointsPerArmor; k += 2) {
+                pts[k]     = a.pts[k] / W;
+                pts[k + 1] = a.pts[k + 1] / H;
+            }
+            std::memcpy(p + 2, pts, sizeof(pts));
+            p += kArmorBytes;
+        }
+        return true;
+    }
+
+    bool append(const ExportChunk& chunk, QString& err) override {
+        if (!samples_.empty() && shard_.pos() + chunk.sourceBytes > kShardBytes
+            && (!closeShard(err) || !openShard(err)))
+            return false;
+
+        // 先拷图片：失败时整个导出中止，不会留下指向半截数据的样本
+        QFile src(chunk.sourcePath);
+        if (!src.open(QIODevice::ReadOnly)) {
+            err = src.errorString();
+            return false;
+        }
+        const qint64 offset = shard_.pos();
+        copyBuf_.resize(kCopyBlock);
+        qint64 n = 0;
+        while ((n = src.read(copyBuf_.data(), copyBuf_.size())) > 0) {
+            if (!writeRaw(copyBuf_.constData(), n)) {
+                err = shard_.errorString();
+                return false;
+            }
+        }
+        if (n < 0) {
+            err = src.errorString();
+            return false;
+        }
+
+        pack::PackSample s{};
+        s.imageOffset = quint64(offset);
+        s.imageSize   = quint64(shard_.pos() - offset);
+        s.width       = quint32(chunk.size.width());
+        s.height      = quint32(chunk.size.height());
+        s.armorBegin  = quint32(colors_.size());
+        s.armorCount  = quint32(chunk.secondary.size() / kArmorBytes);
+        const QByteArray name = chunk.relPath.toUtf8();
+        s.nameOffset          = quint32(names_.size());
+        s.nameSize            = quint32(name.size());
+        names_.append(name);
+        samples_.push_back(s);
+
+        const char* p = chunk.secondary.constData();
+        for (quint32 k = 0; k < s.armorCount; ++k, p += kArmorBytes) {
+            colors_.push_back(quint8(p[0]));
+            labels_.push_back(quint8(p[1]));
+            float pts[pack::kPointsPerArmor];
+            std::memcpy(pts, p + 2, sizeof(pts));
+            points_.insert(points_.end(), pts, pts + pack::kPointsPerArmor);
+        }
+        return true;
+    }
+
+    bool finish(bool ok, QString& err) override {
+        if (!ok) {
+            shard_.close();
+            shard_.remove();
+            return true;
+        }
+        if (!samples_.empty() || shards_.isEmpty()) {
+            if (!closeShard(err))
+                return false;
+        } else {
+            shard_.close();
+            shard_.remove();
+        }
+
+        QByteArray m("{\"format\":\"atlpack\",\"version\":");
+        appendInt(m, pack::kVersion);
+        m.append(",\"shards\":[");
+        for (qsizetype i = 0; i < shards_.size(); ++i) {
+            if (i)
+                m.append(',');
+            m.append("{\"file\":");
+            appendJsonString(m, shards_[i].first);
+            m.append(",\"samples\":");
+            appendInt(m, shards_[i].second);
+            m.append('}');
+        }
+        m.append("],\"classes\":[");
+        for (int c = 0; c < kNumColors * kNumLabels; ++c) {
+            if (c)
+                m.append(',');
+            appendJsonString(m, className(c));
+        }
+        m.append("]}\n");
+        return util::writeFileAtomic(outDir_ + "/manifest.json", m, util::FsyncPolicy::None, &err);
+    }
+
+private:
+    static constexpr int kArmorBytes = 2 + pack::kPointsPerArmor * int(sizeof(float));
+    static constexpr qsizetype kCopyBlock = qsizetype(1) << 20; // 流式拷贝块大小
+
+    QString shardName() const {
+        return QString("shard-%1%2").arg(shards_.size(), 5, 10, QChar('0')).arg(pack::kShardExt);
+    }
+
+    bool openShard(QString& err) {
+        shard_.setFileName(outDir_ + "/" + shardName() + ".tmp");
+        if (!shard_.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err = shard_.errorString();
+            return false;
+        }
+        const pack::PackHeader placeholder{}; // fileSize = 0：未封口
+        shard_.write(reinterpret_cast<const char*>(&placeholder), sizeof(placeholder));
+        return true;
+    }
+
+    bool writeRaw(const void* data, qint64 n) {
+        return shard_.write(static_cast<const char*>(data), n) == n;
+    }
+    bool pad8() {
+        static const char zeros[8] = {};
+        const qint64 pos           = shard_.pos();
+        return writeRaw(zeros, qint64(pack::align8(quint64(pos))) - pos);
+    }
+
+    bool closeShard(QString& err) {
+        pack::PackHeader h{};
+        std::memcpy(h.magic, pack::kMagic, sizeof(h.magic));
+        h.version     = pack::kVersion;
+        h.headerSize  = sizeof(pack::PackHeader);
+        h.sampleCount = samples_.size();
+        h.armorCount  = colors_.size();
+
+        bool ok = pad8();
+        h.sampleTableOffset = quint64(shard_.pos());
+        ok = ok && writeRaw(samples_.data(), qint64(samples_.size() * sizeof(pack::PackSample)));
+        h.armorTableOffset = quint64(shard_.pos());
+        ok = ok && writeRaw(colors_.data(), qint64(colors_.size())) && pad8();
+        ok = ok && writeRaw(labels_.data(), qint64(labels_.size())) && pad8();
+        ok = ok && writeRaw(points_.data(), qint64(points_.size() * sizeof(float)));
+        h.nameTableOffset = quint64(shard_.pos());
+        ok = ok && writeRaw(names_.constData(), names_.size());
+        h.fileSize = quint64(shard_.pos());
+        ok = ok && shard_.seek(0) && writeRaw(&h, sizeof(h)) && shard_.flush();
+        if (!ok) {
+            err = shard_.errorString();
+            return false;
+        }
+        shard_.close();
+
+        const QString finalName = shardName();
+        if (::rename(QFile::encodeName(shard_.fileName()), QFile::encodeName(outDir_ + "/" + finalName))
+            != 0) {
+            err = "rename failed: " + finalName;
+            return false;
+        }
+        shards_.push_back({finalName, qint64(samples_.size())});
+        samples_.clear();
+        colors_.clear();
+        labels_.clear();
+        points_.clear();
+        names_.clear();
+        return true;
+    }
+
+    QString outDir_;
+    QFile shard_;
+    QVector<QPair<QString, qint64>> shards_; // 已封口的分片与样本数
+    std::vector<pack::PackSample> samples_;
+    std::vector<quint8> colors_;
+    std::vector<quint8> labels_;
+    std::vector<float> points_;
+    QByteArray names_;
+    QByteArray copyBuf_;
+};
+} // namespace
+
+// ---------- DatasetExporter ----------
+std::unique_ptr<DatasetExporter> DatasetExporter::create(DataSet type) {
+    switch (type) {
+    case DataSet::YOLOPose: return std::make_unique<YoloPoseExporter>();
+    case DataSet::COCO: return std::make_unique<CocoExporter>();
+    case DataSet::TrainPack: return std::make_unique<PackExporter>();
+    default: return nullptr;
+    }
+}
+
+QString DatasetExporter::className(int classIndex) {
+    return FileService::colorId2Letter(classIndex / kNumLabels)
+         + FileService::classId2Token(classIndex % kNumLabels);
+}
+
+// ---------- ExportJob ----------
+ExportJob::ExportJob(QObject* parent)
+    : QObject(parent) {
+    pool_.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+}
+
+ExportJob::~ExportJob() {
+    cancel();
+    if (driver_.joinable())
+        driver_.join();
+}
+
+void ExportJob::cancel() { cancel_.store(true); }
+
+bool ExportJob::start(const QString& root, DataSet type, const QString& outDir, ImageMode mode) {
+    if (!DatasetExporter::create(type) || running_.exchange(true))
+        return false;
+    if (driver_.joinable())
+        driver_.join();
+    cancel_.store(false);
+    driver_ = std::thread([=, this] { run(root, type, outDir, mode); });
+    return true;
+}
+
+void ExportJob::run(QString root, DataSet type, QString outDir, ImageMode mode) {
+    auto exporter = DatasetExporter::create(type);
+    DatasetIndex index;
+    QString err;
+    if (!index.build(root, &cancel_) || !QDir().mkpath(outDir)
+        || !exporter->begin(outDir, index.size(), err)) {
+        if (!err.isEmpty())
+            LOGE(QString("导出失败：%1").arg(err));
+        running_.store(false);
+        emit finished(0, 0, cancel_.load(), outDir);
+        return;
+    }
+
+    const QDir rootDir(index.root());
+    const QString imgDir   = outDir + "/" + exporter->imageSubdir();
+    const bool placeImages = mode != ImageMode::None && !exporter->imageSubdir().isEmpty();
+    const int total      = int(index.size());
+    std::atomic_int failed{0};
+    int exported = 0;
+    bool ok      = true;
+    std::vector<ExportChunk> chunks(std::min<qsizetype>(kBatch, total));
+    std::vector<char> good(chunks.size());
+
+    emit progress(0, total);
+    LOGI(QString("开始导出：%1 → %2（%3 张图片）").arg(root, outDir).arg(total));
+
+    for (qsizetype base = 0; base < total && ok && !cancel_.load(); base += kBatch) {
+        const qsizetype n = std::min<qsizetype>(kBatch, total - base);
+        std::fill(good.begin(), good.end(), 0);
+
+        util::parallelFor(
+            pool_, n, 8,
+            [&](qsizetype i) {
+                ExportItem item;
+                item.id        = base + i;
+                item.imagePath = index.at(item.id).imagePath;
+                item.relPath   = rootDir.relativeFilePath(item.imagePath);
+                item.size      = DatasetIndex::imageSize(item.imagePath); // 只读文件头
+                QString e;
+                if (item.size.isEmpty()) {
+                    e = "cannot read image size";
+                } else {
+                    const QString lbl = FileService::labelFileForImage(item.imagePath);
+                    if (QFile::exists(lbl))
+                        item.plates = FileService::readPlates(lbl, item.size);
+                    if (placeImages) {
+                        const QString dst = imgDir + "/" + item.relPath;
+                        QDir().mkpath(QFileInfo(dst).absolutePath());
+                        if (!util::linkOrCopyFile(item.imagePath, dst, mode == ImageMode::HardLink))
+                            e = "cannot place image";
+                    }
+                    if (e.isEmpty() && exporter->convert(item, chunks[i], e))
+                        good[i] = 1;
+                }
+                if (!good[i]) {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                    LOGW(QString("导出失败：%1 (%2)").arg(item.imagePath, e));
+                }
+            },
+            &cancel_);
+
+        for (qsizetype i = 0; i < n && ok; ++i) {
+            if (good[i]) {
+                ok = exporter->append(chunks[i], err);
+                exported += ok;
+            }
+            chunks[i] = {};
+        }
+        emit progress(int(base + n), total);
+    }
+
+    const bool cancelled = cancel_.load();
+    if (!exporter->finish(ok && !cancelled, err) || !ok)
+        LOGE(QString("导出失败：%1").arg(err));
+    else if (!cancelled)
+        LOGI(QString("导出完成：%1 张，失败 %2").arg(exported).arg(failed.load()));
+    running_.store(false);
+    emit finished(exported, failed.load(), cancelled, outDir);
+}
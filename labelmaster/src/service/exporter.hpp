@@ -0,0 +1,78 @@
+#pragma once
+#include "../dataset/dataset.h"
+#include "types.hpp"
+#include <QByteArray>
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// 导出时图片的处理方式
+enum class ImageMode : unsigned char { None = 0, HardLink, Copy };
+
+// 一张图片的导出输入（像素坐标的标注）
+struct ExportItem {
+    qsizetype id = 0;      // 在数据集索引中的序号（COCO image_id）
+    QString imagePath;     // 绝对路径
+    QString relPath;       // 相对数据集根目录
+    QSize size;
+    std::vector<Plate> plates;
+};
+
+// convert() 的产物：流式格式由 append() 串行写出；逐文件格式可以留空
+struct ExportChunk {
+    QByteArray primary;
+    QByteArray secondary;
+    QSize size;      // append() 需要的逐样本元数据由 convert() 填写
+    QString relPath;
+    QString sourcePath;    // 非空：append() 直接从源文件流式拷贝（大块字节不进批次缓冲）
+    qint64 sourceBytes = 0;
+};
+
+// 导出格式插件：按 DataSet 注册，convert() 会被多个线程并发调用
+class DatasetExporter {
+public:
+    virtual ~DatasetExporter() = default;
+    static std::unique_ptr<DatasetExporter> create(DataSet type); // 不支持的类型返回 nullptr
+
+    // 训练侧的类别编号：color * 8 + label（0..31）
+    static QString className(int classIndex); // "B1" / "RBb" …
+
+    virtual QString imageSubdir() const = 0; // 图片放置目录（相对 outDir）；空 = 不单独放置图片
+    virtual bool begin(const QString& outDir, qsizetype count, QString& err)         = 0;
+    virtual bool convert(const ExportItem& item, ExportChunk& out, QString& err) const = 0;
+    virtual bool append(const ExportChunk& chunk, QString& err)                      = 0; // 按 id 顺序
+    virtual bool finish(bool ok, QString& err)                                       = 0;
+};
+
+// 导出任务：扫描索引 → 分批并行 convert → 串行 append，不阻塞 GUI
+class ExportJob : public QObject {
+    Q_OBJECT
+public:
+    explicit ExportJob(QObject* parent = nullptr);
+    ~ExportJob() override;
+
+    bool isRunning() const { return running_.load(); }
+
+public slots:
+    bool start(const QString& root, DataSet type, const QString& outDir, ImageMode mode);
+    void cancel();
+
+signals:
+    void progress(int done, int total);
+    void finished(int exported, int failed, bool cancelled, const QString& outDir);
+
+private:
+    void run(QString root, DataSet type, QString outDir, ImageMode mode);
+
+    QThreadPool pool_;
+    std::thread driver_;
+    std::atomic_bool running_{false};
+    std::atomic_bool cancel_{false};
+};
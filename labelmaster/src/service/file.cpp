@@ -3,20 +3,21 @@
 // ===============================
 #include "service/file.hpp"
 #include "types.hpp"
-#include <QBuffer>
 #include <QDir>
+#include <QEvent>
 #include <QFile>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QFileSystemModel>
 #include <QImage>
 #include <QImageReader>
+#include <QInputDialog>
+#include <QLineEdit>
 #include <QQueue>
 #include <QSettings>
 #include <QSortFilterProxyModel>
 #include <chrono>
 #include <cstddef>
-#include <qbuffer.h>
 #include <qdebug.h>
 #include <qdir.h>
 #include <qglobal.h>
@@ -28,23 +29,38 @@
 #include <qsortfilterproxymodel.h>
 #include <qstringalgorithms.h>
 #include <qtmetamacros.h>
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-# include <QStringConverter> // Qt6: QTextStream::setEncoding
-#endif
-#include <QTextStream>
 #include <QTimer>
 #include <QUrl>
 
 #include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <cmath>
+#include <cstring>
+#include <string_view>
 
 #include "controller/dataset.hpp"
+#include "service/dataset_stats.hpp"
+#include "service/dataset_watcher.hpp"
+#include "service/duplicate_finder.hpp"
+#include "service/exporter.hpp"
+#include "service/label_store.hpp"
+#include "service/pre_annotator.hpp"
+#include "service/thumbnail_cache.hpp"
+#include "service/tiled_image.hpp"
+#include "service/video_source.hpp"
+#include "detector/flow_tracker.hpp"
 #include "controller/settings.hpp"
 #include "logger/core.hpp"
+#include "service/dataset_index.hpp"
+#include "service/importer.hpp"
+#include "service/label_writer.hpp"
+#include <QCoreApplication>
+#include <QThread>
 
 namespace {
-static const QStringList kImgExt = {"*.png", "*.jpg", "*.jpeg", "*.bmp",
-                                    "*.gif", "*.tif", "*.tiff", "*.webp"};
+static const QStringList kImgExt = DatasetIndex::imageFilters();
+constexpr int kSessionFlushMs = 5000; // 会话状态合并写回周期
 
 class ImageFilterProxy : public QSortFilterProxyModel {
 public:
@@ -70,6 +86,35 @@ protected:
         return false;
     }
 };
+// 标注行解析：按空白切分（不分配）；超过 max 个字段时返回 max
+int splitFields(const char* p, const char* end, std::string_view* out, int max) {
+    int n = 0;
+    while (p < end) {
+        while (p < end && std::isspace(static_cast<unsigned char>(*p)))
+            ++p;
+        const char* b = p;
+        while (p < end && !std::isspace(static_cast<unsigned char>(*p)))
+            ++p;
+        if (p == b)
+            break;
+        if (n == max)
+            return max;
+        out[n++] = std::string_view(b, size_t(p - b));
+    }
+    return n;
+}
+
+bool parseInt(std::string_view s, int& v) {
+    const auto r = std::from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+bool parseReal(std::string_view s, double& v) {
+    if (!s.empty() && s.front() == '+') // from_chars 不接受前导 '+'
+        s.remove_prefix(1);
+    const auto r = std::from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
 } // namespace
 
 // ---------- 工具：token 规范化 ----------
@@ -102,15 +147,7 @@ QString FileService::colorToken2Letter(const QString& tk) {
         return U;
     return "G";
 }
-QString FileService::colorId2Letter(int id) {
-    switch (id) {
-    case 0: return "B"; // BLUE
-    case 1: return "R"; // RED
-    case 2: return "G"; // GRAY
-    case 3: return "P"; // PURPLE
-    default: return "G";
-    }
-}
+QString FileService::colorId2Letter(int id) { return colorLetter(toColorId(id)); } // 未知为 "G"
 // int FileService::colorToken2Id(const QString& token){
 //      const QString l = token.trimmed().toUpper();
 //     if (l == "BLUE")
@@ -124,43 +161,11 @@ QString FileService::colorId2Letter(int id) {
 
 // }
 // 颜色字母(B/R/G/P) → id(0/1/2/3)
-int FileService::colorLetter2Id(const QString& letter) {
-    const QChar c = letter.trimmed().isEmpty() ? QChar() : letter.trimmed().at(0).toUpper();
-    if (c == 'B')
-        return 0;                                               // BLUE
-    if (c == 'R')
-        return 1;                                               // RED
-    if (c == 'G')
-        return 2;                                               // GRAY
-    if (c == 'P')                                               // PURPLE
-        return 3;
-    return 2;                                                   // 默认 GRAY
-}
+int FileService::colorLetter2Id(const QString& letter) { return int(parseColorId(letter)); }
 int FileService::classToken2Id(const QString& NormalizedToken) {
-    if (NormalizedToken == "G") {
-        return 0;
-    }
-    if (NormalizedToken == "1" || NormalizedToken == "2" || NormalizedToken == "3"
-        || NormalizedToken == "4") {
-        return NormalizedToken.toInt();
-    }
-    if (NormalizedToken == "O")
-        return 5;
-    if (NormalizedToken == "Bs")
-        return 6;
-    if (NormalizedToken == "Bb")
-        return 7;
-    return 0;                                                   // 默认哨兵
-}
-QString FileService::classId2Token(const int& Id) {
-    switch (Id) {
-    case 0: return "G";
-    case 5: return "O";
-    case 6: return "Bs";
-    case 7: return "Bb";
-    default: return QString(QChar(Id + '0'));
-    }
+    return int(parseClassId(NormalizedToken));
 }
+QString FileService::classId2Token(const int& Id) { return classToken(toClassId(Id)); }
 QString FileService::normalizeClasslToken(const QString& cls) { // 归一化cls
     const QString u = cls.trimmed().toUpper();
     if (u == "G")
@@ -192,6 +197,7 @@ FileService::FileService(QObject* parent)
     proxy_->setSourceModel(fsModel_);
     proxy_->setRecursiveFilteringEnabled(true);
     proxy_->setDynamicSortFilter(true);
+    decodePool_.setMaxThreadCount(1); // 只需要最新一张的原图
 
     connect(
         fsModel_, &QFileSystemModel::directoryLoaded, this, &FileService::selectFirst,
@@ -205,21 +211,220 @@ FileService::FileService(QObject* parent)
         currentImageSize_ = {};
     });
 
+    // 自动保存：防抖计时器 + 独立写线程
+    autosaveTimer_ = new QTimer(this);
+    autosaveTimer_->setSingleShot(true);
+    connect(autosaveTimer_, &QTimer::timeout, this, &FileService::flushAutosave);
+
+    writerThread_ = new QThread(this);
+    writerThread_->setObjectName("LabelWriter");
+    writer_ = new LabelWriter; // 无 parent，随线程结束释放
+    writer_->moveToThread(writerThread_);
+    connect(writerThread_, &QThread::finished, writer_, &QObject::deleteLater);
+    connect(writer_, &LabelWriter::written, this, &FileService::onLabelWritten);
+    writerThread_->start();
+
+    // 会话状态周期性合并写回（导航只改内存 + 追加日志）
+    sessionTimer_ = new QTimer(this);
+    sessionTimer_->setInterval(kSessionFlushMs);
+    connect(sessionTimer_, &QTimer::timeout, this, [] {
+        controller::DatasetManager::instance().flush();
+    });
+    sessionTimer_->start();
+
+    // 数据集导入：进度/结果转发给 UI，完成后重新加载当前图片的标注
+    importer_ = new DatasetImporter(this);
+    connect(importer_, &DatasetImporter::progress, this, &FileService::taskProgress);
+    connect(importer_, &DatasetImporter::finished, this, [this](int ok, int bad, bool cancelled) {
+        emit taskProgress(-1, -1);
+        emit status(
+            cancelled ? tr("导入已取消：已转换 %1，失败 %2").arg(ok).arg(bad)
+                      : tr("导入完成：已转换 %1，失败 %2").arg(ok).arg(bad),
+            3000);
+        if (proxyCurrent_.isValid())
+            openFileAt(proxyCurrent_);
+        if (!cancelled && !fsModel_->rootPath().isEmpty())
+            labels_->start(fsModel_->rootPath()); // 标注文件已整体改写，重新建表（统计随之重算）
+    });
+
+    // 标注库：建表期间提交的查询在就绪后补跑
+    labels_ = new LabelStore(this);
+    connect(labels_, &LabelStore::ready, this, [this] {
+        if (!queryText_.isEmpty() && queryHits_.isEmpty())
+            runLabelQuery(queryText_);
+    });
+
+    // 统计由标注表派生，不再单独扫描数据集
+    stats_ = new DatasetStats(labels_, this);
+
+    // 近重复查找：完成后把簇列表写到 ~/.atlabelmaster/duplicates.txt
+    dupFinder_ = new DuplicateFinder(this);
+    connect(dupFinder_, &DuplicateFinder::progress, this, &FileService::taskProgress);
+    connect(
+        dupFinder_, &DuplicateFinder::finished, this,
+        [this](int clusters, int redundant, int unreadable, bool cancelled) {
+            emit taskProgress(-1, -1);
+            if (cancelled) {
+                emit status(tr("查重已取消"), 1500);
+                return;
+            }
+            const QString report = QDir::homePath() + "/.atlabelmaster/duplicates.txt";
+            util::writeFileAtomic(report, dupFinder_->reportText().toUtf8());
+            LOGI(QString("近重复报告：%1").arg(report));
+            QString msg = tr("近重复：%1 簇，%2 张可跳过（报告：%3）").arg(clusters).arg(redundant).arg(report);
+            if (unreadable > 0)
+                msg += tr("，%1 张无法读取").arg(unreadable);
+            emit status(msg, 5000);
+        });
+    connect(dupFinder_, &DuplicateFinder::failed, this, [this](const QString& why) {
+        emit taskProgress(-1, -1);
+        LOGE(QString("近重复查找失败：%1").arg(why));
+        emit status(tr("查重失败：%1").arg(why), 3000);
+    });
+
+    // 外部程序（采集机）往数据集里落图/删图：按 inotify 事件增量同步，不重扫目录树
+    watcher_ = new DatasetWatcher(this);
+    connect(watcher_, &DatasetWatcher::indexChanged, this, &FileService::onIndexChanged);
+    connect(watcher_, &DatasetWatcher::fileRenamed, this, &FileService::onFileRenamed);
+
+    // 胶片条缩略图：每个数据集一个 pack，随数据集打开/切换
+    thumbs_ = new ThumbnailCache(this);
+
+    // 视频数据源：首次打开时建寻址索引（进度走公共进度条），之后按帧懒解码
+    video_ = new VideoSource(this);
+    connect(video_, &VideoSource::indexProgress, this, &FileService::taskProgress);
+    connect(video_, &VideoSource::opened, this, [this](const QString& path, int frames, double fps) {
+        emit taskProgress(-1, -1);
+        LOGI(QString("打开视频：%1（%2 帧，%3 fps）").arg(path).arg(frames).arg(fps, 0, 'f', 2));
+        showFrame(std::clamp(videoResume_, 0, frames - 1));
+    });
+    connect(video_, &VideoSource::openFailed, this, [this](const QString& path, const QString& why) {
+        emit taskProgress(-1, -1);
+        videoMode_ = false;
+        LOGE(QString("打开视频失败：%1 (%2)").arg(path, why));
+        emit status(tr("打开视频失败：%1").arg(why), 2000);
+    });
+    connect(video_, &VideoSource::frameReady, this, &FileService::onFrameReady);
+
+    // 数据集导出：与导入共用进度条
+    exportJob_ = new ExportJob(this);
+    connect(exportJob_, &ExportJob::progress, this, &FileService::taskProgress);
+    connect(
+        exportJob_, &ExportJob::finished, this,
+        [this](int ok, int bad, bool cancelled, const QString& outDir) {
+            emit taskProgress(-1, -1);
+            emit status(
+                cancelled ? tr("导出已取消：已导出 %1，失败 %2").arg(ok).arg(bad)
+                          : tr("导出完成：%1 张 → %2，失败 %3").arg(ok).arg(outDir).arg(bad),
+                3000);
+        });
+
+    // 批量预标注：用户操作时只留一个推理请求，停手 idleMs 后恢复全速
+    preJob_ = new PreAnnotateJob(this);
+    connect(preJob_, &PreAnnotateJob::progress, this, [this](int done, int total, double rate, double eta) {
+        emit taskProgress(done, total);
+        emit status(
+            eta < 0 ? tr("预标注 %1/%2").arg(done).arg(total)
+                    : tr("预标注 %1/%2，%3 张/秒，剩余约 %4 秒")
+                          .arg(done)
+                          .arg(total)
+                          .arg(rate, 0, 'f', 1)
+                          .arg(qRound(eta)),
+            1500);
+    });
+    connect(
+        preJob_, &PreAnnotateJob::finished, this, [this](int done, int written, int bad, bool cancelled) {
+            if (QCoreApplication::instance())
+                qApp->removeEventFilter(this);
+            emit taskProgress(-1, -1);
+            emit status(
+                cancelled ? tr("预标注已暂停：已处理 %1，写出 %2，失败 %3（再次运行从断点继续）")
+                                .arg(done)
+                                .arg(written)
+                                .arg(bad)
+                          : tr("预标注完成：已处理 %1，写出 %2，失败 %3").arg(done).arg(written).arg(bad),
+                4000);
+            if (written > 0 && !fsModel_->rootPath().isEmpty()) {
+                labels_->start(fsModel_->rootPath()); // 新写了一批标注文件，重新建表（统计随之重算）
+                // 只刷新“打开时还没有标注、现在有了、且没被动过”的当前图片；视频会话与手上的编辑不打断
+                if (proxyCurrent_.isValid() && !videoMode_ && !currentHadLabel_ && !edited_ && !dirty_) {
+                    flushWriter();
+                    if (QFile::exists(labelFileForImage(currentImagePath_)))
+                        openFileAt(proxyCurrent_);
+                }
+            }
+        });
+
+    if (QCoreApplication::instance()) {
+        connect(qApp, &QCoreApplication::aboutToQuit, this, &FileService::flushAutosave);
+        connect(qApp, &QCoreApplication::aboutToQuit, this, [] {
+            controller::DatasetManager::instance().flush();
+        });
+    }
+
     // 异步尝试恢复上次图片（避免构造期阻塞）
     QTimer::singleShot(0, this, &FileService::tryRestoreLastVisited);
 }
-FileService::~FileService() = default;
+FileService::~FileService() {
+    ++decodeGen_;
+    decodePool_.clear();
+    decodePool_.waitForDone();
+    controller::DatasetManager::instance().flush();
+    flushWriter();
+    writerThread_->quit();
+    writerThread_->wait();
+}
 
 // ---------- 模型暴露 ----------
 void FileService::exposeModel() { emit modelReady(proxy_); }
 
 void FileService::importFrom(const QAction* action) {
-    DataSet dataset;
+    DataSet dataset = DataSet::LabelMaster;
     if (action->objectName() == "actionImport1") {
         dataset = DataSet::SJTU;
     }
     openFolderDialog(dataset);
 }
+
+void FileService::exportTo(const QAction* action) {
+    DataSet dataset = DataSet::LabelMaster;
+    if (action->objectName() == "actionExportYolo")
+        dataset = DataSet::YOLOPose;
+    else if (action->objectName() == "actionExportCoco")
+        dataset = DataSet::COCO;
+    else if (action->objectName() == "actionExportPack")
+        dataset = DataSet::TrainPack;
+    const QString root = proxyRoot_.isValid() ? fsModel_->rootPath() : QString();
+    if (root.isEmpty()) {
+        emit status(tr("请先打开数据集目录"), 1500);
+        return;
+    }
+    if (exportJob_->isRunning() || importer_->isRunning()) {
+        emit status(tr("已有后台任务在运行"), 1500);
+        return;
+    }
+    flushWriter(); // 导出读的是磁盘上的标注：阻塞到最新改动落盘
+
+    const QString outDir = QFileDialog::getExistingDirectory(nullptr, tr("选择导出目录"));
+    if (outDir.isEmpty())
+        return;
+    ImageMode im = ImageMode::None; // 分片包自带图片字节
+    if (dataset != DataSet::TrainPack) {
+        const QStringList modes{
+            tr("硬链接图片（推荐，同一文件系统零拷贝）"), tr("复制图片"), tr("只导出标注")};
+        bool ok            = false;
+        const QString mode = QInputDialog::getItem(
+            nullptr, tr("导出数据集"), tr("图片处理方式："), modes, 0, false, &ok);
+        if (!ok)
+            return;
+        im = mode == modes[0] ? ImageMode::HardLink
+           : mode == modes[1] ? ImageMode::Copy
+                              : ImageMode::None;
+    }
+
+    if (!exportJob_->start(root, dataset, outDir, im))
+        emit status(tr("不支持的导出格式"), 1500);
+}
 // ---------- 打开入口 ----------
 
 void FileService::openFolderDialog(const DataSet& type) {
@@ -273,34 +478,266 @@ bool FileService::openFileAt(const QModelIndex& proxyIndex) {
         return false;
 
     const QString path = fsModel_->filePath(s);
+    if (path == currentImagePath_)
+        flushWriter(); // 重新加载同一张：等待写的标注落盘，否则会读到旧文件
+    else
+        flushAutosave(); // 切图前把上一张的改动交给写线程
+    if (videoMode_)
+        closeVideo(); // 从文件树选了图片：离开视频
+
     QImageReader reader(path);
     reader.setAutoTransform(true);
-    QImage img = reader.read();
-    if (img.isNull()) {
-        LOGE(QString("加载失败：%1 (%2)").arg(path, reader.errorString()));
-        emit status(tr("加载失败：%1").arg(reader.errorString()), 1500);
-        return false;
-    }
 
-    emit imageReady(img);
+    // 文件头里的尺寸（EXIF 旋转 90° 时宽高互换）；标注始终按原图坐标
+    const QSize stored = reader.size();
+    QSize full         = stored;
+    const bool rotated = reader.transformation() & QImageIOHandler::TransformationRotate90;
+    if (rotated)
+        full.transpose();
+
+    const quint64 gen = ++decodeGen_;
+    decodePool_.clear(); // 还没开始的旧原图解码不用做了
+    QSize preview = full.isValid() ? full.scaled(viewportSize_, Qt::KeepAspectRatio) : QSize();
+    Frame shown;  // 当前实际显示的像素（可能只是预览）
+    if (preview.isValid() && preview.width() * 2 <= full.width()) {
+        // 大图：按画布尺寸缩小解码（JPEG 走 DCT 降采样），立即显示
+        reader.setScaledSize(rotated ? preview.transposed() : preview);
+        const QImage img = reader.read();
+        if (img.isNull()) {
+            LOGE(QString("加载失败：%1 (%2)").arg(path, reader.errorString()));
+            emit status(tr("加载失败：%1").arg(reader.errorString()), 1500);
+            return false;
+        }
+        shown = Frame(img, path, full);
+        if (!rotated && TiledImage::shouldTile(full)) {
+            // 超大图：画布按视野只解码可见块，原图从不整张进内存
+            emit tiledImageReady(shown);
+        } else {
+            emit previewReady(shown);
+
+            decodePool_.start([this, path, gen] {
+                if (gen != decodeGen_.load())
+                    return;
+                QImageReader r(path);
+                r.setAutoTransform(true);
+                const Frame frame(r.read(), path); // 在解码线程里包好，之后只传句柄
+                const QString err = r.errorString();
+                QMetaObject::invokeMethod(this, [this, gen, frame, path, err] {
+                    if (gen != decodeGen_.load())
+                        return;
+                    if (frame.isNull()) {
+                        LOGE(QString("加载原图失败：%1 (%2)").arg(path, err));
+                        return;
+                    }
+                    emit imageUpgraded(frame);
+                });
+            });
+        }
+    } else {
+        const QImage img = reader.read();
+        if (img.isNull()) {
+            LOGE(QString("加载失败：%1 (%2)").arg(path, reader.errorString()));
+            emit status(tr("加载失败：%1").arg(reader.errorString()), 1500);
+            return false;
+        }
+        shown = Frame(img, path);
+        emit imageReady(shown);
+    }
     emit status(tr("已打开：%1").arg(QFileInfo(path).fileName()), 800);
 
-    currentImagePath_ = path;       // 记住路径（保存时用）
-    currentImageSize_ = img.size(); // 记住尺寸（保存/反归一化）
-    saveLastVisited(path);
+    controller::DatasetManager::instance().saveProgress(path); // 仅内存 + 追加日志
+    adoptCurrent(path, shown);
+    return true;
+}
 
-    controller::DatasetManager::instance().saveProgress(/*index=*/0);
+void FileService::adoptCurrent(const QString& path, const Frame& shown) {
+    currentImagePath_ = path;             // 记住路径（保存时用）
+    currentImageSize_ = shown.fullSize(); // 记住原图尺寸（保存/反归一化）
+    saveLastVisited(path);
+    emit currentImageChanged(path);
 
     const QString lbl = labelFileForImage(path);
-    if (QFile::exists(lbl)) {
-        QVector<Armor> armors = readLabelFile(lbl, currentImageSize_);
-        emit labelsLoaded(armors);
-    } else {
-        emit labelsLoaded({});
+    QVector<Armor> armors;
+    currentHadLabel_ = QFile::exists(lbl);
+    edited_          = false;
+    if (currentHadLabel_)
+        armors = readLabelFile(lbl, currentImageSize_);
+    if (controller::AppSettings::instance().autoSave()) {
+        // 以“加载内容的序列化结果”为比较基准，未改动就不会回写
+        const QByteArray base = serializeLabels(armors, currentImageSize_);
+        QMetaObject::invokeMethod(
+            writer_, [w = writer_, lbl, base] { w->remember(lbl, base); }, Qt::QueuedConnection);
+    }
+    emit labelsLoaded(armors);
+
+    if (propagate_.active) {
+        propagate_.active = false;
+        if (armors.isEmpty())
+            runPropagation(path, shown);
+        else
+            emit status(tr("这一张已有标注，未传播"), 1500);
     }
+}
+
+// ---------- 标注传播 ----------
+void FileService::propagateToNext(const Frame& shown, const QVector<Armor>& armors) {
+    if (armors.isEmpty() || shown.isNull()) {
+        emit status(tr("当前没有可传播的标注"), 1200);
+        return;
+    }
+    propagate_ = {shown, armors, true};
+    const QString before = currentImagePath_;
+    const int beforeFrame = videoFrame_;
+    next();
+    // 已经是最后一张：没有打开任何东西，别让请求挂到下一次手动翻页上
+    if (videoMode_ ? videoFrame_ == beforeFrame : currentImagePath_ == before)
+        propagate_ = {};
+}
+
+void FileService::runPropagation(const QString& path, const Frame& shown) {
+    // 排在原图解码之后；用户继续翻页时 decodePool_.clear() 会连它一起丢掉
+    decodePool_.start([this, path, shown, from = std::move(propagate_)] {
+        FlowTracker::Result r;
+        try {
+            r = FlowTracker::track(
+                from.frame.image(), from.frame.fullSize(), shown.image(), shown.fullSize(), from.armors);
+        } catch (const std::exception& e) { // cv::Exception 不能穿出 QRunnable，否则 std::terminate
+            LOGW(QString("传播：光流跟踪失败 %1 (%2)").arg(path, e.what()));
+            QMetaObject::invokeMethod(this, [this, path] {
+                if (path == currentImagePath_)
+                    emit status(tr("标注传播失败"), 1500);
+            });
+            return;
+        }
+        QMetaObject::invokeMethod(this, [this, path, r = std::move(r)] {
+            if (path != currentImagePath_)
+                return;
+            for (int i : r.flagged) {
+                const auto& c = r.confidence[i];
+                LOGW(QString("传播：%1 第 %2 个装甲板跟踪置信度低（%3 %4 %5 %6）")
+                         .arg(QFileInfo(path).fileName())
+                         .arg(i)
+                         .arg(c[0], 0, 'f', 2)
+                         .arg(c[1], 0, 'f', 2)
+                         .arg(c[2], 0, 'f', 2)
+                         .arg(c[3], 0, 'f', 2));
+            }
+            emit labelsPropagated(r.armors, r.flagged);
+            emit status(
+                tr("已传播 %1 个装甲板，%2 个需要确认").arg(r.armors.size()).arg(r.flagged.size()),
+                2500);
+        });
+    });
+    propagate_ = {};
+}
+
+bool FileService::openImagePath(const QString& imagePath) {
+    const QModelIndex px = mapFromSourceToProxy(fsModel_->index(imagePath));
+    if (!px.isValid())
+        return false;
+    openIndex(px);
     return true;
 }
 
+// ---------- 外部变更 ----------
+void FileService::onIndexChanged(const QStringList& added, const QStringList& removed) {
+    labels_->refreshImages(added);
+    for (const QString& p : removed) {
+        labels_->removeImage(p);
+        dupFinder_->forget(p);
+    }
+    if (!added.isEmpty())
+        emit status(tr("检测到 %1 张新图片").arg(added.size()), 1200);
+
+    if (currentImagePath_.isEmpty() || !removed.contains(currentImagePath_))
+        return; // 选中项是持久索引，其余增删不会让它跳动
+    // 当前图片被外部删除/移走：等同批的 fileRenamed 处理完，再决定是否换到相邻图片
+    QTimer::singleShot(0, this, [this, gone = currentImagePath_] {
+        if (currentImagePath_ != gone || QFile::exists(gone))
+            return;
+        if (dirty_ && pending_.imagePath == gone) {
+            dirty_ = false;
+            autosaveTimer_->stop();
+        }
+        const DatasetIndex& idx = watcher_->index();
+        const qsizetype pos     = idx.lowerBound(gone);
+        for (qsizetype i : {pos, pos - 1}) {
+            if (i >= 0 && i < idx.size() && openImagePath(idx.at(i).imagePath))
+                return;
+        }
+        currentImagePath_.clear();
+        currentImageSize_ = {};
+    });
+}
+
+void FileService::onFileRenamed(const QString& from, const QString& to) {
+    if (from != currentImagePath_)
+        return;
+    // 标注跟着图片走：已落盘的改名，待写的改写到新路径（否则会在旧名下留一个孤儿标注）
+    const QString oldLabel = labelFileForImage(from);
+    const QString newLabel = labelFileForImage(to);
+    if (QFile::exists(oldLabel) && !QFile::exists(newLabel)) {
+        // 写线程里可能还排着旧路径的写入：阻塞调用排在它们之后，返回即已落盘
+        QMetaObject::invokeMethod(writer_, [] {}, Qt::BlockingQueuedConnection);
+        if (!QFile::rename(oldLabel, newLabel))
+            LOGW(QString("标注改名失败：%1 → %2").arg(oldLabel, newLabel));
+    }
+    if (dirty_ && pending_.imagePath == from) {
+        pending_.imagePath = to;
+        pending_.labelPath = newLabel;
+    }
+    flushWriter(); // 新路径马上要读标注
+    if (!openImagePath(to)) {
+        // 文件树可能还没加载新条目，稍后再试一次
+        QTimer::singleShot(300, this, [this, to] { openImagePath(to); });
+    }
+}
+
+// ---------- 视频 ----------
+void FileService::openVideoDialog() {
+    const QString path = QFileDialog::getOpenFileName(
+        nullptr, tr("选择视频"), QString(),
+        tr("视频 (%1)").arg(VideoSource::videoFilters().join(' ')));
+    if (!path.isEmpty())
+        openVideo(path);
+}
+
+void FileService::openVideo(const QString& videoPath, int frame) {
+    flushAutosave();
+    ++decodeGen_; // 丢掉还在路上的图片原图
+    videoMode_   = true;
+    videoFrame_  = -1;
+    videoResume_ = frame;
+    emit status(tr("正在打开视频：%1").arg(QFileInfo(videoPath).fileName()), 1500);
+    video_->open(videoPath); // 完成后由 opened 信号显示 videoResume_
+}
+
+void FileService::closeVideo() {
+    video_->close();
+    videoMode_  = false;
+    videoFrame_ = -1;
+}
+
+void FileService::showFrame(int frame) {
+    flushAutosave(); // 与切图一样：上一帧的改动先交给写线程
+    videoFrame_ = frame;
+    video_->request(frame); // 命中预取缓存时同步回调 onFrameReady
+}
+
+void FileService::onFrameReady(int frame, const QImage& img) {
+    if (!videoMode_ || frame != videoFrame_)
+        return; // 已经翻到别的帧
+    if (img.isNull()) {
+        LOGE(QString("视频帧解码失败：%1 #%2").arg(video_->path()).arg(frame));
+        emit status(tr("第 %1 帧解码失败").arg(frame), 1500);
+        return;
+    }
+    const Frame f(img, VideoSource::framePath(video_->path(), frame));
+    emit imageReady(f);
+    emit status(tr("帧 %1 / %2").arg(frame + 1).arg(video_->frameCount()), 800);
+    adoptCurrent(f.path(), f);
+}
+
 void FileService::openIndex(const QModelIndex& proxyIndex) {
     if (!proxyIndex.isValid())
         return;
@@ -311,6 +748,17 @@ void FileService::openIndex(const QModelIndex& proxyIndex) {
 
 // ---------- 浏览 ----------
 void FileService::next() {
+    if (videoMode_) {
+        if (videoFrame_ >= 0 && videoFrame_ + 1 < video_->frameCount())
+            showFrame(videoFrame_ + 1);
+        else if (videoFrame_ >= 0)
+            emit status(tr("已经是最后一帧"), 900);
+        return;
+    }
+    if (!queryText_.isEmpty()) {
+        stepQuery(+1);
+        return;
+    }
     if (!proxyCurrent_.isValid())
         return;
 
@@ -321,7 +769,7 @@ void FileService::next() {
     for (; r < rows; ++r) {
         const QModelIndex idx = proxy_->index(r, 0, parent);
         const QModelIndex s   = mapFromProxyToSource(idx);
-        if (s.isValid() && !fsModel_->isDir(s) && isImageFile(fsModel_->filePath(s))) {
+        if (s.isValid() && !fsModel_->isDir(s) && isNavigable(fsModel_->filePath(s))) {
             proxyCurrent_ = idx;
             emit currentIndexChanged(proxyCurrent_);
             openFileAt(proxyCurrent_);
@@ -332,6 +780,17 @@ void FileService::next() {
 }
 
 void FileService::prev() {
+    if (videoMode_) {
+        if (videoFrame_ > 0)
+            showFrame(videoFrame_ - 1);
+        else if (videoFrame_ == 0)
+            emit status(tr("已经是第一帧"), 900);
+        return;
+    }
+    if (!queryText_.isEmpty()) {
+        stepQuery(-1);
+        return;
+    }
     if (!proxyCurrent_.isValid())
         return;
 
@@ -341,7 +800,7 @@ void FileService::prev() {
     for (; r >= 0; --r) {
         const QModelIndex idx = proxy_->index(r, 0, parent);
         const QModelIndex s   = mapFromProxyToSource(idx);
-        if (s.isValid() && !fsModel_->isDir(s) && isImageFile(fsModel_->filePath(s))) {
+        if (s.isValid() && !fsModel_->isDir(s) && isNavigable(fsModel_->filePath(s))) {
             proxyCurrent_ = idx;
             emit currentIndexChanged(proxyCurrent_);
             openFileAt(proxyCurrent_);
@@ -353,6 +812,10 @@ void FileService::prev() {
 
 // ---------- 删除 ----------
 void FileService::deleteCurrent() {
+    if (videoMode_) {
+        emit status(tr("视频帧不能删除"), 1200);
+        return;
+    }
     if (!proxyCurrent_.isValid())
         return;
     const QModelIndex s = mapFromProxyToSource(proxyCurrent_);
@@ -360,7 +823,12 @@ void FileService::deleteCurrent() {
         return;
 
     const QString path = fsModel_->filePath(s);
+    if (dirty_ && path == currentImagePath_) {
+        dirty_ = false; // 图片都删了，未落盘的改动一并丢弃
+        autosaveTimer_->stop();
+    }
     if (QFile::remove(path)) {
+        labels_->removeImage(path);
         LOGW(QString("已删除：%1").arg(path));
         next();
         if (!proxyCurrent_.isValid()) {
@@ -401,102 +869,18 @@ bool FileService::openDir(const QString& dir, DataSet type) {
         pendingDir_.clear();
         return false;
     } else {
-        if (type != DataSet::LabelMaster) {                 // 开始导入
-            auto fail = [&](const QString& tip = nullptr, const QString& arg = nullptr) {
-                if (tip != nullptr && arg != nullptr) {
-                    LOGW(QString("%1:%2").arg(tip).arg(arg));
-                    emit status(tip, 1200);
-                }
-            };
-            const QModelIndex target = findFirstImageUnder(proxyRoot_);
-
-            if (target.isValid()) {
-                qDebug() << proxy_->rowCount(target.parent());
-                for (int i = 0; i < proxy_->rowCount(target.parent()); i++) {
-                    QString imgPath = fsModel_->filePath(
-                        fsModel_->index(i, 0, mapFromProxyToSource(target.parent())));
-                    qDebug() << imgPath;
-                    const QString labelPath = labelFileForImage(imgPath);
-                    if (QFile::exists(labelPath)) {
-                        switch (type) {
-                        case DataSet::SJTU: {
-                            QBuffer buffer;
-                            buffer.open(QIODevice::ReadWrite);
-                            QTextStream convertStream(&buffer);
-                            QFile labelFile(labelPath);
-                            if (!labelFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-                                fail("导入失败!无法打开Label:", labelPath);
-                                continue;
-                            }
-                            qDebug() << labelPath;
-                            QTextStream ts(&labelFile);
-                            while (!ts.atEnd()) {
-                                QString raw = ts.readLine();
-                                int hash    = raw.indexOf('#');
-                                if (hash >= 0)
-                                    raw = raw.left(hash);
-                                const QString line = raw.trimmed();
-                                if (line.isEmpty())
-                                    continue;
-
-                                // x1 y1 x2 y2 x3 y3 x4 y4 color label
-                                QStringList t = line.simplified().split(' ');
-                                if (t.size() != 10)
-                                    continue;
-                                for (int i = 2; i > 0; i--) {
-                                    t.move(t.size() - i, 0);
-                                }
-                                // 颜色字段:id
-                                // 装甲板标注目标ID见下表
-                                // 贴纸	ID
-                                // G（哨兵）	0
-                                // 1（一号）	1
-                                // 2（二号）	2
-                                // 3（三号）	3
-                                // 4（四号）	4
-                                // 5（五号）	5
-                                // O（前哨站）	6
-                                // Bs（基地）	7
-                                // Bb（基地大装甲）	8
-                                // L3（三号平衡）	9
-                                // L4（四号平衡）	10
-                                // L5（五号平衡）	11
-                                // 颜色ID见下表
-                                // 类别	color
-                                // Blue	0
-                                // Red	1
-                                // N（熄灭) 2
-                                // Purple	3
-                                int clsId = t.at(0).toInt();
-                                qDebug() << t.join(" ");
-                                if (0 <= clsId && clsId < 5) {
-                                    convertStream << t.join(" ") << "\n";
-                                } else if (clsId > 5 && clsId < 9) {
-                                    clsId--;
-                                    t[0] = QString(QChar('0' + clsId));
-                                    convertStream << t.join(" ") << "\n";
-                                } else {
-                                    continue;
-                                }
-                            }
-                            convertStream.seek(0);
-                            QString Text = convertStream.readAll();
-                            qDebug() << Text;
-                            buffer.close();
-                            labelFile.close();
-                            labelFile.open(QIODevice::WriteOnly);
-                            ts << Text;
-                            labelFile.close();
-                            break;
-                        }
-                        default: break;
-                        }
-                    } else {
-                        fail("导入失败!Label不存在:", labelPath);
-                    }
-                }
-            }
+        if (type != DataSet::LabelMaster) { // 开始导入：后台遍历整棵目录树，完成后再统计
+            if (!importer_->start(dir, type))
+                emit status(tr("已有导入任务在进行"), 1200);
+        } else if (QDir::cleanPath(dir) != labels_->root()) {
+            labels_->start(dir); // 首次打开：后台并行建表（统计由表派生），之后只走增量
+            queryText_.clear(); // 换了数据集，旧的查询结果作废
+            queryHits_.clear();
         }
+        if (QDir(dir).absolutePath() != watcher_->root())
+            watcher_->start(dir);
+        if (QDir(dir).absolutePath() != thumbs_->root())
+            thumbs_->open(QDir(dir).absolutePath());
         tryOpenFirstAfterLoaded(dir);
         return true;
     }
@@ -607,6 +991,10 @@ void FileService::openPaths(const QStringList& paths) {
         if (!fi.exists())
             continue;
 
+        if (fi.isFile() && VideoSource::isVideoFile(p)) {
+            openVideo(fi.absoluteFilePath());
+            return;
+        }
         if (fi.isDir()) {
             dir = fi.absoluteFilePath();
             pendingTargetPath_.clear();
@@ -626,17 +1014,31 @@ void FileService::openPaths(const QStringList& paths) {
 }
 
 // ---------- 记忆 & 恢复 ----------
+// 会话状态统一由 DatasetManager 管理：导航时不做同步 JSON/QSettings 写入
 void FileService::saveLastVisited(const QString& imagePath) {
-    QSettings st("ATLabelMaster", "ATLabelMaster");
-    st.setValue("lastImagePath", imagePath);
-    st.setValue("lastDir", QFileInfo(imagePath).absolutePath());
+    controller::DatasetManager::instance().setLastImage(imagePath);
 }
 
 void FileService::tryRestoreLastVisited() {
-    QSettings st("ATLabelMaster", "ATLabelMaster");
-    const QString lastImg = st.value("lastImagePath").toString();
-    const QString lastDir = st.value("lastDir").toString();
-    if (lastDir.isEmpty())
+    auto& dm        = controller::DatasetManager::instance();
+    QString lastImg = dm.lastImage();
+    QString lastDir = dm.imageDir();
+    if (lastImg.isEmpty())
+        lastImg = dm.loadProgress(); // 没有最后图片记录时退回当前图片目录的进度
+    if (lastImg.isEmpty()) { // 兼容旧版本写在 QSettings 里的记录
+        QSettings st("ATLabelMaster", "ATLabelMaster");
+        lastImg = st.value("lastImagePath").toString();
+        lastDir = st.value("lastDir").toString();
+    }
+    QString video;
+    int frame = 0;
+    if (VideoSource::parseFramePath(lastImg, &video, &frame) && QFileInfo(video).isFile()) {
+        openVideo(video, frame); // 上次停在视频的某一帧
+        return;
+    }
+    if (!lastImg.isEmpty() && (lastDir.isEmpty() || !lastImg.startsWith(lastDir + '/')))
+        lastDir = QFileInfo(lastImg).absolutePath();
+    if (lastDir.isEmpty() || !QFileInfo(lastDir).isDir())
         return;
 
     if (!lastImg.isEmpty()) {
@@ -648,115 +1050,138 @@ void FileService::tryRestoreLastVisited() {
 
 // ---------- 标注 I/O（归一化格式 + 兼容旧像素格式） ----------
 QString FileService::labelFileForImage(const QString& imagePath) {
+    QString video;
+    int frame = 0;
+    if (VideoSource::parseFramePath(imagePath, &video, &frame))
+        return VideoSource::frameLabelPath(video, frame);
     QFileInfo fi(imagePath);
     QDir labelDir(fi.absolutePath() + "/../label");
     const QString dirPath = QDir::cleanPath(labelDir.absolutePath());
     return dirPath + "/" + fi.completeBaseName() + ".txt";
 }
 
-bool FileService::writeLabelFile(
-    const QString& labelPath, const QVector<Armor>& armors, const QSize& imgSize) {
-    if (imgSize.width() <= 0 || imgSize.height() <= 0)
-        return false;
+QByteArray FileService::serializeLabels(const QVector<Armor>& armors, const QSize& imgSize) {
+    std::vector<Plate> plates;
+    plates.reserve(armors.size());
+    for (const auto& a : armors)
+        plates.push_back(toPlate(a)); // 字符串 → id 只在这一处
+    return serializePlates(plates, imgSize);
+}
 
-    QDir().mkpath(QFileInfo(labelPath).absolutePath());
-    QFile f(labelPath);
-    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
-        return false;
+QByteArray FileService::serializePlates(const std::vector<Plate>& plates, const QSize& imgSize) {
+    QByteArray out;
+    if (imgSize.width() <= 0 || imgSize.height() <= 0)
+        return out;
 
-    QTextStream ts(&f);
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-    ts.setEncoding(QStringConverter::Utf8);
-#else
-    ts.setCodec("UTF-8");
-#endif
-    ts.setRealNumberNotation(QTextStream::FixedNotation);
-    ts.setRealNumberPrecision(6);                                       // 保留 6 位小数
+    // 每行：2 个整数 + 8 个定点小数（裁剪到 ±1e6，最长 15 字符）+ 分隔符
+    constexpr qsizetype kMaxLine = 2 * 11 + 8 * 16 + 10 + 1;
+    constexpr double kLimit      = 1e6;
+    out.resize(qsizetype(plates.size()) * kMaxLine);
+    char* p         = out.data();
+    char* const end = p + out.size();
 
     const double W = double(imgSize.width());
     const double H = double(imgSize.height());
-    auto norm      = [&](const QPointF& p) { return QPointF(p.x() / W, p.y() / H); };
+    auto putInt    = [&](int v) { p = std::to_chars(p, end, v).ptr; };
+    auto putReal   = [&](double v) {
+        *p++ = ' ';
+        p    = std::to_chars(p, end, std::clamp(v, -kLimit, kLimit), std::chars_format::fixed, 6)
+                .ptr; // 保留 6 位小数
+    };
+
+    for (const auto& pl : plates) {
+        putInt(int(pl.color)); // 0/1/2/3
+        *p++ = ' ';
+        putInt(int(pl.cls));
+        for (int k = 0; k < 8; k += 2) {
+            putReal(pl.pts[k] / W);
+            putReal(pl.pts[k + 1] / H);
+        }
+        *p++ = '\n';
+    }
+    out.resize(p - out.data());
+    return out;
+}
 
-    for (const auto& a : armors) {
-        const int colorId = colorLetter2Id(a.color);                    // 0/1/2/3
-        const int labelId = classToken2Id(normalizeClasslToken(a.cls)); // 字符串
+bool FileService::writeLabelFile(
+    const QString& labelPath, const QVector<Armor>& armors, const QSize& imgSize,
+    util::FsyncPolicy policy) {
+    if (imgSize.width() <= 0 || imgSize.height() <= 0)
+        return false;
 
-        const QPointF q0 = norm(a.p0), q1 = norm(a.p1), q2 = norm(a.p2), q3 = norm(a.p3);
-        ts << colorId << ' ' << labelId << ' ' << q0.x() << ' ' << q0.y() << ' ' << q1.x() << ' '
-           << q1.y() << ' ' << q2.x() << ' ' << q2.y() << ' ' << q3.x() << ' ' << q3.y() << '\n';
+    QDir().mkpath(QFileInfo(labelPath).absolutePath());
+    QString err;
+    if (!util::writeFileAtomic(labelPath, serializeLabels(armors, imgSize), policy, &err)) {
+        LOGE(QString("写入标注失败：%1 (%2)").arg(labelPath, err));
+        return false;
     }
     return true;
 }
 
 QVector<Armor> FileService::readLabelFile(const QString& labelPath, const QSize& imgSize) {
+    const std::vector<Plate> plates = readPlates(labelPath, imgSize);
     QVector<Armor> res;
+    res.reserve(qsizetype(plates.size()));
+    for (const auto& pl : plates)
+        res.push_back(toArmor(pl));
+    return res;
+}
+
+std::vector<Plate> FileService::readPlates(const QString& labelPath, const QSize& imgSize) {
+    std::vector<Plate> res;
     QFile f(labelPath);
-    if (!f.open(QIODevice::ReadOnly | QIODevice::Text))
+    if (!f.open(QIODevice::ReadOnly))
         return res;
+    const QByteArray bytes = f.readAll();
 
     const double W = double(imgSize.width());
     const double H = double(imgSize.height());
 
-    QTextStream ts(&f);
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-    ts.setEncoding(QStringConverter::Utf8);
-#else
-    ts.setCodec("UTF-8");
-#endif
-    while (!ts.atEnd()) {
-        QString raw = ts.readLine();
-        int hash    = raw.indexOf('#');
-        if (hash >= 0)
-            raw = raw.left(hash);
-        const QString line = raw.trimmed();
-        if (line.isEmpty())
-            continue;
+    const char* p   = bytes.constData();
+    const char* end = p + bytes.size();
+    if (bytes.startsWith("\xEF\xBB\xBF")) // UTF-8 BOM
+        p += 3;
+
+    std::string_view t[11];
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+        if (!eol)
+            eol = end;
+        const char* stop = static_cast<const char*>(std::memchr(p, '#', size_t(eol - p)));
+        const int n      = splitFields(p, stop ? stop : eol, t, 11);
+        p                = eol + 1;
 
         // color label x1 y1 x2 y2 x3 y3 x4 y4
-        const QStringList t = line.simplified().split(' ');
-        if (t.size() != 10)
+        if (n != 10)
             continue;
 
-        bool ok  = true;
-        auto tod = [&](int i) -> double {
-            bool o   = false;
-            double v = t.at(i).toDouble(&o);
-            ok &= o;
-            return v;
-        };
-
-        Armor a;
-        // 颜色字段：兼容“数字或字符串”
-        bool okInt = false;
-        int cid    = t.at(0).toInt(&okInt);
-        a.color    = okInt ? colorId2Letter(cid)         // 数字 → 字母
-                           : colorToken2Letter(t.at(0)); // 字符串 → 字母
-
-        okInt       = false;
-        int classId = t.at(0).toInt(&okInt);
-        a.cls   = okInt ? classId2Token(t.at(1).toInt()) : normalizeClasslToken(t.at(1)); // classId
-        a.score = 0.f;
-
-        double x0 = tod(2), y0 = tod(3), x1 = tod(4), y1 = tod(5), x2 = tod(6), y2 = tod(7),
-               x3 = tod(8), y3 = tod(9);
+        Plate pl;
+        // 颜色 / 类别字段：兼容“数字或字符串”
+        int id = 0;
+        pl.color = parseInt(t[0], id) ? toColorId(id)
+                                      : parseColorId(QLatin1String(t[0].data(), qsizetype(t[0].size())));
+        pl.cls   = parseInt(t[1], id) ? toClassId(id)
+                                      : parseClassId(QLatin1String(t[1].data(), qsizetype(t[1].size())));
+
+        double v[8];
+        bool ok = true;
+        for (int k = 0; k < 8; ++k)
+            ok &= parseReal(t[k + 2], v[k]);
         if (!ok)
             continue;
 
         // 归一化判定：坐标绝对值的最大值 <= 1.5 视为已归一化（留容错）
-        const double mx = std::max({std::fabs(x0), std::fabs(x1), std::fabs(x2), std::fabs(x3)});
-        const double my = std::max({std::fabs(y0), std::fabs(y1), std::fabs(y2), std::fabs(y3)});
+        double mx = 0, my = 0;
+        for (int k = 0; k < 8; k += 2) {
+            mx = std::max(mx, std::fabs(v[k]));
+            my = std::max(my, std::fabs(v[k + 1]));
+        }
         const bool normalized = (mx <= 1.5 && my <= 1.5 && W > 0 && H > 0);
-
-        auto denorm = [&](double x, double y) -> QPointF {
-            return normalized ? QPointF(x * W, y * H) : QPointF(x, y);
-        };
-
-        a.p0 = denorm(x0, y0);
-        a.p1 = denorm(x1, y1);
-        a.p2 = denorm(x2, y2);
-        a.p3 = denorm(x3, y3);
-
-        res.push_back(a);
+        for (int k = 0; k < 8; k += 2) {
+            pl.pts[k]     = float(normalized ? v[k] * W : v[k]);
+            pl.pts[k + 1] = float(normalized ? v[k + 1] * H : v[k + 1]);
+        }
+        res.push_back(pl);
     }
     return res;
 }
@@ -794,8 +1219,27 @@ void FileService::saveLabels(const QVector<Armor>& armors) {
     }
 
     const QString lblPath = labelFileForImage(imgPath);
+    if (dirty_ && pending_.labelPath == lblPath) {
+        dirty_ = false; // 手动保存覆盖同一文件的待写内容
+        autosaveTimer_->stop();
+    }
 
-    if (writeLabelFile(lblPath, armors, sz)) {
+    // 经写线程阻塞执行：与排队中的自动保存保持先后顺序
+    const auto policy =
+        util::fsyncPolicyFromInt(controller::AppSettings::instance().labelFsync());
+    const QByteArray bytes = serializeLabels(armors, sz);
+    bool ok                = false;
+    inflight_[lblPath].enqueue({imgPath, lblPath, {}, sz, /*manual=*/true}); // 与排队的自动保存对齐回报顺序
+    QMetaObject::invokeMethod(
+        writer_, [&] { ok = writer_->write(lblPath, bytes, policy, /*force=*/true); },
+        Qt::BlockingQueuedConnection);
+    if (ok) {
+        if (imgPath == currentImagePath_) {
+            currentHadLabel_ = true; // 改动已落盘
+            edited_          = false;
+        }
+        labels_->updateImage(imgPath, armors);
+        emit labelsWritten(imgPath, !armors.isEmpty());
         emit status(tr("已保存标注：%1").arg(QFileInfo(lblPath).fileName()), 900);
         LOGI(QString("保存标注：%1").arg(lblPath));
     } else {
@@ -803,3 +1247,225 @@ void FileService::saveLabels(const QVector<Armor>& armors) {
         LOGE(QString("保存失败：%1").arg(lblPath));
     }
 }
+
+void FileService::cancelTasks() {
+    if (importer_->isRunning()) {
+        importer_->cancel();
+        emit status(tr("正在取消导入…"), 1200);
+    }
+    if (exportJob_->isRunning()) {
+        exportJob_->cancel();
+        emit status(tr("正在取消导出…"), 1200);
+    }
+    if (dupFinder_->isRunning()) {
+        dupFinder_->cancel();
+        emit status(tr("正在取消查重…"), 1200);
+    }
+    if (preJob_->isRunning()) {
+        preJob_->cancel();
+        emit status(tr("正在暂停预标注…"), 1200);
+    }
+    if (videoMode_ && !video_->isOpen()) {
+        closeVideo(); // 还在建视频索引
+        emit taskProgress(-1, -1);
+        emit status(tr("已取消打开视频"), 1200);
+    }
+}
+
+void FileService::findDuplicates() {
+    const QString root = proxyRoot_.isValid() ? fsModel_->rootPath() : QString();
+    if (root.isEmpty()) {
+        emit status(tr("请先打开数据集目录"), 1500);
+        return;
+    }
+    const int radius = std::clamp(controller::AppSettings::instance().dupHammingRadius(), 0, 32);
+    if (!dupFinder_->start(root, radius))
+        emit status(tr("查重正在进行"), 1200);
+}
+
+void FileService::preAnnotate() {
+    const QString root = proxyRoot_.isValid() ? fsModel_->rootPath() : QString();
+    if (root.isEmpty()) {
+        emit status(tr("请先打开数据集目录"), 1500);
+        return;
+    }
+    if (preJob_->isRunning()) {
+        emit status(tr("预标注正在进行"), 1200);
+        return;
+    }
+    // 上次被取消或中断：问是续跑还是从头来（比如换了模型）
+    bool restart = false;
+    if (QFile::exists(PreAnnotator::journalPath(root))) {
+        const QStringList choices{tr("从断点继续"), tr("重新开始")};
+        bool ok              = false;
+        const QString choice = QInputDialog::getItem(
+            nullptr, tr("批量预标注"), tr("上次的预标注没有跑完："), choices, 0, false, &ok);
+        if (!ok)
+            return;
+        restart = choice == choices.at(1);
+    }
+    auto& s = controller::AppSettings::instance();
+    PreAnnotator::Options opt;
+    opt.assetsDir = s.assetsDir();
+    opt.workers   = s.preAnnotateWorkers();
+    opt.minScore  = s.preAnnotateMinScore();
+    preJob_->throttle().setIdleMs(std::max(0, s.preAnnotateIdleMs()));
+    if (!preJob_->start(root, opt, restart)) {
+        emit status(tr("预标注正在进行"), 1200);
+        return;
+    }
+    if (QCoreApplication::instance())
+        qApp->installEventFilter(this); // 只在任务期间监听，平时不给事件分发加开销
+    emit status(tr("预标注已开始（取消后再次运行从断点继续）"), 2000);
+}
+
+bool FileService::eventFilter(QObject* watched, QEvent* event) {
+    switch (event->type()) {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseMove:
+    case QEvent::Wheel:
+    case QEvent::KeyPress:
+        preJob_->throttle().touch();
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void FileService::setViewportSize(const QSize& devicePixels) {
+    if (devicePixels.width() >= 64 && devicePixels.height() >= 64)
+        viewportSize_ = devicePixels;
+}
+
+void FileService::setSkipDuplicates(bool on) {
+    controller::AppSettings::instance().setskipDuplicates(on);
+    if (on && dupFinder_->clusters().isEmpty() && !dupFinder_->isRunning())
+        findDuplicates(); // 还没有查重结果：顺手算一次（有缓存时很快）
+}
+
+void FileService::queryLabelsDialog() {
+    if (labels_->root().isEmpty()) {
+        emit status(tr("请先打开数据集目录"), 1500);
+        return;
+    }
+    bool ok            = false;
+    const QString expr = QInputDialog::getText(
+        nullptr, tr("标注查询"),
+        tr("条件以空格分隔，留空退出查询浏览：\n"
+           "color=R class=Bb size<20    area>=400    plates>4    unlabeled"),
+        QLineEdit::Normal, queryText_, &ok);
+    if (ok)
+        runLabelQuery(expr.trimmed());
+}
+
+void FileService::runLabelQuery(const QString& expr) {
+    queryHits_.clear();
+    if (expr.isEmpty()) {
+        if (!queryText_.isEmpty())
+            emit status(tr("已退出查询浏览"), 1200);
+        queryText_.clear();
+        return;
+    }
+    LabelQuery q;
+    QString err;
+    if (!LabelQuery::parse(expr, q, &err)) {
+        emit status(tr("查询无效：%1").arg(err), 2500);
+        return;
+    }
+    queryText_ = expr;
+    if (labels_->isRunning()) {
+        emit status(tr("标注库建立中，完成后自动查询"), 1500);
+        return;
+    }
+
+    const auto t0              = std::chrono::steady_clock::now();
+    const LabelQueryResult res = labels_->query(q);
+    const auto us =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0)
+            .count();
+    queryHits_ = res.images;
+    LOGI(QString("标注查询“%1”：%2 张图片，%3 个装甲板（%4 µs）")
+             .arg(expr)
+             .arg(res.images.size())
+             .arg(res.plates)
+             .arg(us));
+    if (queryHits_.isEmpty()) {
+        queryText_.clear();
+        emit status(tr("没有符合条件的图片"), 2000);
+        return;
+    }
+    emit status(tr("查询命中 %1 张图片 / %2 个装甲板").arg(queryHits_.size()).arg(res.plates), 2500);
+    if (!queryHits_.contains(currentImagePath_))
+        stepQuery(+1);
+}
+
+void FileService::stepQuery(int dir) {
+    // 当前图片不在结果里时，按路径序定位到它前后最近的一张
+    const auto it = dir > 0 ? std::upper_bound(queryHits_.begin(), queryHits_.end(), currentImagePath_)
+                            : std::lower_bound(queryHits_.begin(), queryHits_.end(), currentImagePath_);
+    qsizetype i = (it - queryHits_.begin()) - (dir > 0 ? 0 : 1);
+    for (; i >= 0 && i < queryHits_.size(); i += dir) {
+        if (QFile::exists(queryHits_[i]) && openImagePath(queryHits_[i])) {
+            emit status(tr("查询结果 %1 / %2").arg(i + 1).arg(queryHits_.size()), 900);
+            return;
+        }
+    }
+    emit status(dir > 0 ? tr("已经是最后一个查询结果") : tr("已经是第一个查询结果"), 900);
+}
+
+bool FileService::isNavigable(const QString& path) const {
+    if (!isImageFile(path))
+        return false;
+    return !controller::AppSettings::instance().skipDuplicates() || !dupFinder_->isRedundant(path);
+}
+
+// ---------- 自动保存 ----------
+void FileService::markDirty(const QVector<Armor>& armors) {
+    edited_  = !currentImagePath_.isEmpty();
+    auto& st = controller::AppSettings::instance();
+    if (!st.autoSave() || currentImagePath_.isEmpty() || currentImageSize_.isEmpty())
+        return;
+    pending_ = {currentImagePath_, labelFileForImage(currentImagePath_), armors, currentImageSize_};
+    dirty_   = true;
+    autosaveTimer_->start(std::max(0, st.autoSaveDelayMs())); // 重新开始防抖窗口
+}
+
+void FileService::flushAutosave() {
+    if (!dirty_)
+        return;
+    dirty_ = false;
+    autosaveTimer_->stop();
+
+    const QByteArray bytes = serializeLabels(pending_.armors, pending_.imgSize);
+    const auto policy =
+        util::fsyncPolicyFromInt(controller::AppSettings::instance().labelFsync());
+    inflight_[pending_.labelPath].enqueue(pending_);
+    QMetaObject::invokeMethod(
+        writer_, [w = writer_, path = pending_.labelPath, bytes,
+                  policy] { w->write(path, bytes, policy); },
+        Qt::QueuedConnection);
+}
+
+void FileService::flushWriter() {
+    flushAutosave();
+    // 阻塞调用排在所有已投递写请求之后，返回即表示队列已清空
+    QMetaObject::invokeMethod(writer_, [] {}, Qt::BlockingQueuedConnection);
+}
+
+void FileService::onLabelWritten(const QString& labelPath, bool ok) {
+    auto it = inflight_.find(labelPath);
+    if (it == inflight_.end())
+        return;
+    const PendingSave save = it->dequeue();
+    if (it->isEmpty())
+        inflight_.erase(it);
+    if (save.manual)
+        return;
+    if (!ok) {
+        emit status(tr("自动保存失败：%1").arg(QFileInfo(labelPath).fileName()), 2000);
+        return;
+    }
+    labels_->updateImage(save.imagePath, save.armors);
+    emit labelsWritten(save.imagePath, !save.armors.isEmpty());
+}
@@ -3,20 +3,40 @@
 // ===============================
 #pragma once
 #include "../dataset/dataset.h"
+#include "frame.hpp"
 #include "types.hpp"    // Armor 定义
+#include "util/atomic_file.hpp"
+#include <QHash>
+#include <QImage>
 #include <QModelIndex>
 #include <QObject>
 #include <QPersistentModelIndex>
+#include <QQueue>
 #include <QSize>
 #include <QStringList>
+#include <QThreadPool>
 #include <QVector>
 #include <qaction.h>
 #include <qobject.h>
 
+#include <atomic>
+#include <vector>
+
 class QAbstractItemModel;
 class QFileSystemModel;
 class QSortFilterProxyModel;
-class QImage;
+class QThread;
+class QTimer;
+class LabelWriter;
+class DatasetImporter;
+class ExportJob;
+class DatasetStats;
+class DatasetWatcher;
+class DuplicateFinder;
+class LabelStore;
+class PreAnnotateJob;
+class ThumbnailCache;
+class VideoSource;
 
 class FileService : public QObject {
     Q_OBJECT
@@ -25,13 +45,51 @@ public:
     ~FileService() override;
 
     void exposeModel(); // 把 proxy 模型抛给 UI
+    DatasetStats* stats() const { return stats_; } // 当前数据集的统计（增量维护）
+    DatasetWatcher* watcher() const { return watcher_; } // 当前数据集的增量索引
+    LabelStore* labels() const { return labels_; } // 当前数据集的列式标注库（增量维护）
+    ThumbnailCache* thumbnails() const { return thumbs_; } // 当前数据集的缩略图 pack
+
+    // 标注 I/O（归一化支持）
+    static QString labelFileForImage(const QString& imagePath);
+    static bool writeLabelFile(
+        const QString& labelPath, const QVector<Armor>& armors, const QSize& imgSize,
+        util::FsyncPolicy policy = util::FsyncPolicy::None);           // 保存为归一化（原子替换）
+    static QByteArray
+        serializeLabels(const QVector<Armor>& armors, const QSize& imgSize); // 归一化文本
+    static QVector<Armor>
+        readLabelFile(const QString& labelPath, const QSize& imgSize); // 自动反归一化
+    // 批量路径：不经 QString，直接产出/消费紧凑的 Plate
+    static QByteArray serializePlates(const std::vector<Plate>& plates, const QSize& imgSize);
+    static std::vector<Plate> readPlates(const QString& labelPath, const QSize& imgSize);
+
+    // 字段规范化
+    static QString colorLetter2Token(const QString& letter); // "B"→"BLUE" 等
+    static QString colorToken2Letter(const QString& tk);     // "BLUE"→"B" 等
+    static QString colorId2Letter(int id);                   // 0/1/2/3→"B/R/G/P"
+    static int colorLetter2Id(const QString& letter);        // "B/R/G/P"→0/1/2/3
+    static QString normalizeClasslToken(const QString& cls); // "1|2|3|4|G|O|Bs|Bb"
+    static QString classId2Token(const int& Id);
+    static int classToken2Id(const QString& nomalizedToken);
 
 public slots:
     // === 打开 ===
     void openFolderDialog(const DataSet& type= DataSet::LabelMaster);                // 弹框选目录
+    void openVideoDialog();                 // 弹框选视频：逐帧标注，不抽帧
     void importFrom(const QAction* action); // 导入其他数据集
+    void exportTo(const QAction* action);   // 导出为训练格式（YOLO-Pose / COCO）
+    void cancelTasks();                     // 取消进行中的导入/导出/查重/预标注
+    void findDuplicates();                  // 后台查找当前数据集的近重复图片
+    void preAnnotate();                     // 后台对未标注图片跑 AI 检测（可断点续跑）
+    void setSkipDuplicates(bool on);        // next()/prev() 跳过冗余的近重复图片
+    void queryLabelsDialog();               // 输入查询条件；结果作为 next()/prev() 的浏览列表
+    void runLabelQuery(const QString& expr); // 空串：退出查询浏览
+    void setViewportSize(const QSize& devicePixels); // 预览解码的目标尺寸
+    // 光流传播：翻到下一张，若它还没有标注，就把当前标注跟踪过去预填
+    void propagateToNext(const Frame& shown, const QVector<Armor>& armors);
     void openPaths(const QStringList&);     // 拖拽/命令行路径
     void openIndex(const QModelIndex&);     // 由文件树激活
+    bool openImagePath(const QString& imagePath); // 在文件树中定位并打开（胶片条等）
 
     // === 浏览 ===
     void next();
@@ -43,50 +101,63 @@ public slots:
     // === 保存标注 ===
     void saveLabels(const QVector<Armor>& armors);
 
+    // === 自动保存（AppSettings::autoSave 开启时生效）===
+    void markDirty(const QVector<Armor>& armors); // 标注被编辑：记脏并重启防抖计时
+    void flushAutosave();                         // 立即把待写内容交给写线程
+    void flushWriter(); // 交出待写内容并阻塞到写线程落盘；之后要读盘的操作先调用
+    void onLabelWritten(const QString& labelPath, bool ok); // 写线程回报：成功才更新标注库/胶片条
+
 signals:
     // === 给 UI 的输出 ===
     void modelReady(QAbstractItemModel* proxyModel);
     void rootChanged(const QModelIndex& proxyRoot);
     void currentIndexChanged(const QModelIndex& proxyIndex);
-    void imageReady(const QImage& img);
+    void imageReady(const Frame& frame);      // 原图（小图直接给）
+    void previewReady(const Frame& preview);  // 大图：先给缩小解码的预览（fullSize 为原图尺寸）
+    void imageUpgraded(const Frame& full);    // 预览之后到达的原图
+    void tiledImageReady(const Frame& overview); // 超大图：分块显示（path 指向原图）
     void status(const QString& msg, int ms = 1500);
     void busy(bool on);
+    void taskProgress(int done, int total); // 后台导入/导出进度，total < 0 表示结束
 
     // === 打开图片时加载到的标注 ===
     void labelsLoaded(const QVector<Armor>& armors);
+    void currentImageChanged(const QString& imagePath);
+    void labelsWritten(const QString& imagePath, bool labeled); // 手动保存 / 自动保存已落盘
+    void labelsPropagated(const QVector<Armor>& armors, const QVector<int>& flagged); // flagged：需人工确认
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override; // 预标注期间感知用户操作
 
 private:
     // 目录加载完成后再尝试选第一张
     void selectFirst(const QString& path);
     bool openDir(const QString& dir, DataSet type = DataSet::LabelMaster);
     bool openFileAt(const QModelIndex& proxyIndex);
+    void adoptCurrent(const QString& path, const Frame& shown); // 记住当前图片并加载其标注
+    void runPropagation(const QString& path, const Frame& shown);
     void tryOpenFirstAfterLoaded(const QString& dir);
     QModelIndex findFirstImageUnder(const QModelIndex& proxyRoot) const;
     QModelIndex mapFromProxyToSource(const QModelIndex&) const;
     QModelIndex mapFromSourceToProxy(const QModelIndex&) const;
     bool isImageFile(const QString& path) const;
+    bool isNavigable(const QString& path) const; // 图片且（开启跳过时）不是冗余的近重复
+    void stepQuery(int dir);                     // 在查询结果中前后移动（dir = ±1）
 
     // 记忆 & 恢复
     void saveLastVisited(const QString& imagePath);
     void tryRestoreLastVisited(); // 异步调用
     bool setProxyRoot(const QString& dir);
 
-    // 标注 I/O（归一化支持）
-    static QString labelFileForImage(const QString& imagePath);
-    static bool writeLabelFile(
-        const QString& labelPath, const QVector<Armor>& armors,
-        const QSize& imgSize);                                         // 保存为归一化
-    static QVector<Armor>
-        readLabelFile(const QString& labelPath, const QSize& imgSize); // 自动反归一化
+    // 外部程序增删/重命名了图片（DatasetWatcher 批量上报）
+    void onIndexChanged(const QStringList& added, const QStringList& removed);
+    void onFileRenamed(const QString& from, const QString& to);
 
-    // 字段规范化
-    static QString colorLetter2Token(const QString& letter); // "B"→"BLUE" 等
-    static QString colorToken2Letter(const QString& tk);     // "BLUE"→"B" 等
-    static QString colorId2Letter(int id);                   // 0/1/2/3→"B/R/G/P"
-    static int colorLetter2Id(const QString& letter);        // "B/R/G/P"→0/1/2/3
-    static QString normalizeClasslToken(const QString& cls); // "1|2|3|4|G|O|Bs|Bb"
-    static QString classId2Token(const int& Id);
-    static int classToken2Id(const QString& nomalizedToken);
+    // 视频数据源：当前“图片”是虚拟路径 <视频>#<帧号>
+    void openVideo(const QString& videoPath, int frame = 0);
+    void closeVideo();
+    void showFrame(int frame);
+    void onFrameReady(int frame, const QImage& img);
 
 private:
     QString pendingDir_;                                     // 临时Dir
@@ -97,4 +168,49 @@ private:
     QPersistentModelIndex proxyCurrent_;
     QString currentImagePath_;                               // 当前图片绝对路径
     QSize currentImageSize_;                                 // 当前图片尺寸（归一化需要）
+    bool currentHadLabel_ = false;                           // 打开当前图片时已有标注文件
+    bool edited_          = false;                           // 当前图片打开后被编辑过（不论是否开了自动保存）
+
+    // 渐进解码：预览同步解码，原图在 decodePool_ 上解码，代号不符的结果直接丢弃
+    QSize viewportSize_{1920, 1080};
+    QThreadPool decodePool_;
+    std::atomic<quint64> decodeGen_{0};
+
+    // 自动保存：GUI 线程只记脏与防抖，序列化后交给写线程
+    struct PendingSave {
+        QString imagePath;
+        QString labelPath;
+        QVector<Armor> armors;
+        QSize imgSize;
+        bool manual = false; // 手动保存：结果在 saveLabels 里同步处理，回报时只出队
+    };
+    PendingSave pending_;
+    bool dirty_              = false;
+    QHash<QString, QQueue<PendingSave>> inflight_;           // 已交给写线程、尚未回报的自动保存（按标注路径，先进先出）
+    QTimer* autosaveTimer_   = nullptr;
+    QTimer* sessionTimer_    = nullptr;                      // 周期 flush DatasetManager
+    QThread* writerThread_   = nullptr;
+    LabelWriter* writer_     = nullptr;                      // 生活在 writerThread_
+    DatasetImporter* importer_ = nullptr;                    // 后台批量导入
+    ExportJob* exportJob_      = nullptr;                    // 后台并行导出
+    DatasetStats* stats_       = nullptr;                    // 数据集统计
+    DatasetWatcher* watcher_   = nullptr;                    // inotify 变更源（增量索引）
+    DuplicateFinder* dupFinder_ = nullptr;                   // 近重复查找
+    LabelStore* labels_         = nullptr;                   // 列式标注库（查询）
+    PreAnnotateJob* preJob_     = nullptr;                   // 批量预标注（用户操作时限速）
+    QString queryText_;                                      // 当前查询；空 = 按文件树浏览
+    QStringList queryHits_;                                  // 查询结果（按路径排序）
+    ThumbnailCache* thumbs_     = nullptr;                   // 胶片条缩略图
+    VideoSource* video_         = nullptr;                   // 视频帧解码 + 预取
+    bool videoMode_             = false;                     // 当前浏览的是视频而不是文件树
+    int videoFrame_             = -1;
+    int videoResume_            = 0;                         // 索引建好后要显示的帧
+
+    // 等待下一张打开后执行的标注传播
+    struct PendingPropagation {
+        Frame frame; // 上一张显示的像素（含原图尺寸）
+        QVector<Armor> armors;
+        bool active = false;
+    };
+    PendingPropagation propagate_;
 };
@@ -0,0 +1,254 @@
+#include "service/importer.hpp"
+#include "logger/core.hpp"
+#include "service/dataset_index.hpp"
+#include "service/file.hpp"
+#include "util/atomic_file.hpp"
+#include "util/parallel.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+
+namespace {
+// 已转换文件的首行标记：readLabelFile 会忽略 '#' 注释；重复导入时据此跳过原地转换过的文件
+constexpr std::string_view kSjtuMarker = "# converted from SJTU by ATLabelMaster\n";
+constexpr int kProgressStep            = 64; // 每完成多少个文件上报一次进度
+
+bool parseInt(std::string_view s, int& v) {
+    auto r = std::from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+bool isNumber(std::string_view s) {
+    double v = 0;
+    auto r   = std::from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+using SjtuFields = std::array<std::string_view, 10>;
+
+// 去掉注释后按空白切分；字段数恰为 10 时返回 true
+bool splitFields(std::string_view line, SjtuFields& t) {
+    if (auto hash = line.find('#'); hash != std::string_view::npos)
+        line = line.substr(0, hash);
+    size_t n = 0, pos = 0;
+    while (pos < line.size()) {
+        while (pos < line.size() && std::isspace(static_cast<unsigned char>(line[pos])))
+            ++pos;
+        if (pos >= line.size())
+            break;
+        size_t end = pos;
+        while (end < line.size() && !std::isspace(static_cast<unsigned char>(line[end])))
+            ++end;
+        if (n == t.size())
+            return false; // 字段过多
+        t[n++] = line.substr(pos, end - pos);
+        pos    = end;
+    }
+    return n == t.size();
+}
+
+bool isBlank(std::string_view line) {
+    if (auto hash = line.find('#'); hash != std::string_view::npos)
+        line = line.substr(0, hash);
+    return std::all_of(line.begin(), line.end(), [](char c) {
+        return std::isspace(static_cast<unsigned char>(c));
+    });
+}
+
+template <class Fn> void forEachLine(std::string_view text, Fn&& fn) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string_view::npos)
+            eol = text.size();
+        fn(text.substr(pos, eol - pos));
+        pos = eol + 1;
+    }
+}
+} // namespace
+
+DatasetImporter::DatasetImporter(QObject* parent)
+    : QObject(parent) {
+    pool_.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+}
+
+DatasetImporter::~DatasetImporter() {
+    cancel();
+    if (driver_.joinable())
+        driver_.join();
+}
+
+void DatasetImporter::cancel() { cancel_.store(true); }
+
+bool DatasetImporter::start(const QString& root, DataSet type) {
+    if (running_.exchange(true))
+        return false;
+    if (driver_.joinable())
+        driver_.join(); // 上一次已结束，只回收线程
+    cancel_.store(false);
+    emit started(root);
+    driver_ = std::thread([this, root, type] { run(root, type); });
+    return true;
+}
+
+void DatasetImporter::run(const QString& root, DataSet type) {
+    DatasetIndex index;
+    if (!index.build(root, &cancel_)) {
+        running_.store(false);
+        emit finished(0, 0, true);
+        return;
+    }
+
+    const int total = int(index.size());
+    emit progress(0, total);
+    LOGI(QString("开始导入：%1（%2 张图片）").arg(root).arg(total));
+
+    std::atomic_int done{0}, converted{0}, failedCount{0};
+    util::parallelFor(
+        pool_, total, 32,
+        [&](qsizetype i) {
+            const QString& img = index.at(i).imagePath;
+            QString reason;
+            switch (convertOne(img, type, reason)) {
+            case Result::Converted: converted.fetch_add(1, std::memory_order_relaxed); break;
+            case Result::Failed:
+                failedCount.fetch_add(1, std::memory_order_relaxed);
+                LOGW(QString("导入失败：%1 (%2)").arg(img, reason));
+                emit failed(img, reason);
+                break;
+            case Result::Skipped: break;
+            }
+            const int d = done.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (d % kProgressStep == 0 || d == total)
+                emit progress(d, total);
+        },
+        &cancel_);
+
+    const bool cancelled = cancel_.load();
+    LOGI(QString("导入%1：转换 %2，失败 %3")
+             .arg(cancelled ? "已取消" : "完成")
+             .arg(converted.load())
+             .arg(failedCount.load()));
+    running_.store(false);
+    emit finished(converted.load(), failedCount.load(), cancelled);
+}
+
+DatasetImporter::Result
+    DatasetImporter::convertOne(const QString& imagePath, DataSet type, QString& reason) const {
+    if (type != DataSet::SJTU) {
+        reason = "unsupported dataset type";
+        return Result::Failed;
+    }
+
+    // 交龙原始标注与图片同目录同名；若已被放进 ../label，只有确认整份都是交龙格式才原地转换。
+    // ../label 下已有的 LabelMaster 标注（含用户手动保存的）一律不动
+    const QFileInfo fi(imagePath);
+    const QString dst    = FileService::labelFileForImage(imagePath);
+    const QString native = fi.absolutePath() + "/" + fi.completeBaseName() + ".txt";
+    const bool hasNative = QFile::exists(native);
+    const bool hasDst    = QFile::exists(dst);
+    if (!hasNative && !hasDst)
+        return Result::Skipped; // 未标注图片
+
+    auto readAll = [&](const QString& path, QByteArray& bytes) {
+        QFile f(path);
+        if (!f.open(QIODevice::ReadOnly)) {
+            reason = f.errorString();
+            return false;
+        }
+        bytes = f.readAll();
+        return true;
+    };
+    auto textOf = [](const QByteArray& b) { return std::string_view(b.constData(), size_t(b.size())); };
+
+    QByteArray existing;
+    if (hasDst) {
+        if (!readAll(dst, existing))
+            return Result::Failed;
+        if (textOf(existing).substr(0, kSjtuMarker.size()) == kSjtuMarker)
+            return Result::Skipped; // 已经转换过
+    }
+
+    QByteArray bytes;
+    if (hasNative) {
+        if (hasDst) {
+            // 两份标注同时存在：不知道哪份是新的，不覆盖用户的编辑
+            reason = "label file already exists, not overwritten";
+            return Result::Failed;
+        }
+        if (!readAll(native, bytes))
+            return Result::Failed;
+    } else {
+        if (!isSjtuText(textOf(existing)))
+            return Result::Skipped; // 已是 LabelMaster 标注（或空文件），保持原样
+        bytes = existing;
+    }
+
+    const std::string_view text = textOf(bytes);
+    std::string out(kSjtuMarker);
+    out.reserve(bytes.size() + kSjtuMarker.size());
+    forEachLine(text, [&](std::string_view line) { convertSjtuLine(line, out); });
+
+    QDir().mkpath(QFileInfo(dst).absolutePath());
+    QString err;
+    if (!util::writeFileAtomic(dst, out.data(), out.size(), util::FsyncPolicy::None, &err)) {
+        reason = err;
+        return Result::Failed;
+    }
+    return Result::Converted;
+}
+
+// 交龙：x1 y1 x2 y2 x3 y3 x4 y4 color label
+//   label：G 0 / 1-5 / O 6 / Bs 7 / Bb 8 / L3-L5 9-11
+//   color：Blue 0 / Red 1 / N(熄灭) 2 / Purple 3（与 LabelMaster 相同）
+// LabelMaster：color label x1 y1 ... x4 y4
+//   label：G 0 / 1-4 / O 5 / Bs 6 / Bb 7（五号与平衡步兵丢弃）
+bool DatasetImporter::convertSjtuLine(std::string_view line, std::string& out) {
+    SjtuFields t;
+    if (!splitFields(line, t))
+        return false;
+
+    int color = 0, cls = 0;
+    if (!parseInt(t[8], color) || !parseInt(t[9], cls) || color < 0 || color > 3)
+        return false;
+    if (cls > 5 && cls < 9)
+        --cls;
+    else if (cls < 0 || cls > 4)
+        return false;
+    for (size_t i = 0; i < 8; ++i)
+        if (!isNumber(t[i]))
+            return false;
+
+    out.append(t[8]);
+    out.push_back(' ');
+    out.append(std::to_string(cls));
+    for (size_t i = 0; i < 8; ++i) {
+        out.push_back(' ');
+        out.append(t[i]);
+    }
+    out.push_back('\n');
+    return true;
+}
+
+// 正向判定：每个非空行都是 8 个坐标 + 整数颜色(0-3) + 整数类别(0-11)。
+// LabelMaster 的坐标固定写 6 位小数、颜色/类别在行首，不会被误认
+bool DatasetImporter::isSjtuText(std::string_view text) {
+    bool valid = true, any = false;
+    forEachLine(text, [&](std::string_view line) {
+        if (!valid || isBlank(line))
+            return;
+        SjtuFields t;
+        int color = 0, cls = 0;
+        valid = splitFields(line, t) && parseInt(t[8], color) && parseInt(t[9], cls) && color >= 0
+             && color <= 3 && cls >= 0 && cls <= 11
+             && std::all_of(t.begin(), t.begin() + 8, [](std::string_view f) { return isNumber(f); });
+        any = true;
+    });
+    return valid && any;
+}
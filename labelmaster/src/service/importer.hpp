@@ -0,0 +1,46 @@
+#pragma once
+#include "../dataset/dataset.h"
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// 其他数据集格式 → LabelMaster（../label/*.txt）的批量导入器
+// 扫描与转换都在后台线程池进行，进度/错误通过信号排队回到 GUI 线程
+class DatasetImporter : public QObject {
+    Q_OBJECT
+public:
+    explicit DatasetImporter(QObject* parent = nullptr);
+    ~DatasetImporter() override;
+
+    bool isRunning() const { return running_.load(); }
+
+    // 单行转换（纯函数，便于复用）；无效或需丢弃的行返回 false
+    static bool convertSjtuLine(std::string_view line, std::string& out);
+    // 整份文本的每个非空行都符合交龙格式（空文本返回 false）；原地转换前必须通过
+    static bool isSjtuText(std::string_view text);
+
+public slots:
+    bool start(const QString& root, DataSet type); // 已在运行时返回 false
+    void cancel();
+
+signals:
+    void started(const QString& root);
+    void progress(int done, int total);
+    void failed(const QString& path, const QString& reason);
+    void finished(int converted, int failed, bool cancelled);
+
+private:
+    enum class Result { Converted, Skipped, Failed };
+    Result convertOne(const QString& imagePath, DataSet type, QString& reason) const;
+    void run(const QString& root, DataSet type);
+
+    QThreadPool pool_;   // 转换工作线程
+    std::thread driver_; // 扫描 + 调度
+    std::atomic_bool running_{false};
+    std::atomic_bool cancel_{false};
+};
@@ -0,0 +1,63 @@
+#include "service/job_journal.hpp"
+#include "logger/core.hpp"
+
+JobJournal::JobJournal(const QString& root, const QString& name)
+    : root_(root)
+    , path_(root_.filePath(name)) {}
+
+bool JobJournal::open(bool restart) {
+    close();
+    done_.clear();
+    failed_.clear();
+
+    QFile f(path_);
+    if (!restart && f.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> lines = f.readAll().split('\n');
+        f.close();
+        // 最后一个元素是换行之后的部分：完整文件里为空，崩溃时可能是半行
+        for (qsizetype i = 0; i + 1 < lines.size(); ++i) {
+            const QByteArray& line = lines[i];
+            if (line.size() < 3 || line.at(1) != '\t')
+                continue;
+            const QString key = QString::fromUtf8(line.mid(2));
+            if (line.at(0) == 'D') {
+                done_.insert(key);
+                failed_.remove(key);
+            } else if (line.at(0) == 'F' && !done_.contains(key)) {
+                failed_.insert(key);
+            }
+        }
+    }
+
+    file_.setFileName(path_);
+    const auto mode = QIODevice::WriteOnly | (restart ? QIODevice::Truncate : QIODevice::Append);
+    if (!file_.open(mode)) {
+        LOGW(QString("任务日志不可用：%1 (%2)").arg(path_, file_.errorString()));
+        return false;
+    }
+    return true;
+}
+
+void JobJournal::close() {
+    std::lock_guard lk(mu_);
+    if (file_.isOpen())
+        file_.close();
+}
+
+void JobJournal::discard() {
+    close();
+    if (QFile::exists(path_) && !QFile::remove(path_))
+        LOGW(QString("删除任务日志失败：%1").arg(path_));
+    done_.clear();
+    failed_.clear();
+}
+
+void JobJournal::append(char op, const QString& imagePath) {
+    QByteArray line = keyOf(imagePath).toUtf8();
+    line.prepend('\t').prepend(op).append('\n');
+    std::lock_guard lk(mu_);
+    if (!file_.isOpen())
+        return;
+    file_.write(line); // 整行一次写入，并发追加不会交错
+    file_.flush();
+}
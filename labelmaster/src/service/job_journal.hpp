@@ -0,0 +1,40 @@
+#pragma once
+#include <QDir>
+#include <QFile>
+#include <QSet>
+#include <QString>
+
+#include <mutex>
+
+// 批处理任务的追加式日志（放在数据集根目录的隐藏文件里，索引与监视都会忽略）。
+// 每处理完一项追加一行 <op>\t<相对路径>\n：D 已完成，F 失败（下次重试）；
+// 只 flush 不 fsync，进程崩溃后可从最后一行继续，末尾写了一半的行直接忽略
+class JobJournal {
+public:
+    JobJournal(const QString& root, const QString& name);
+
+    // 读入已有记录并以追加方式打开；restart 时清空重来
+    bool open(bool restart = false);
+    void close();
+    void discard(); // 任务完整跑完：删除日志，下次从头开始（日志只用于断点续跑）
+
+    const QString& path() const { return path_; }
+    qsizetype doneCount() const { return done_.size(); }
+    qsizetype failedCount() const { return failed_.size(); }
+    bool isDone(const QString& imagePath) const { return done_.contains(keyOf(imagePath)); }
+
+    // 工作线程并发调用
+    void markDone(const QString& imagePath) { append('D', imagePath); }
+    void markFailed(const QString& imagePath) { append('F', imagePath); }
+
+private:
+    QString keyOf(const QString& imagePath) const { return root_.relativeFilePath(imagePath); }
+    void append(char op, const QString& imagePath);
+
+    QDir root_;
+    QString path_;
+    QSet<QString> done_;   // 打开时读入的已完成项（相对路径）
+    QSet<QString> failed_; // 打开时读入、之后也没成功的失败项
+    std::mutex mu_;
+    QFile file_;
+};
@@ -0,0 +1,443 @@
+#include "service/label_store.hpp"
+#include "logger/core.hpp"
+#include "service/dataset_index.hpp"
+#include "service/file.hpp"
+#include "util/parallel.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+namespace {
+constexpr qsizetype kCompactMinRows = 4096; // 作废行少于此数时不压实
+
+// 按比较符收紧闭区间 [lo, hi]；严格不等号对浮点取相邻可表示值，对整数取 ±1
+template <class T> bool narrow(const QString& op, T v, T& lo, T& hi) {
+    T below = v, above = v;
+    if constexpr (std::is_floating_point_v<T>) {
+        below = std::nextafter(v, -LabelQuery::kInf);
+        above = std::nextafter(v, LabelQuery::kInf);
+    } else {
+        below = v - 1;
+        above = v + 1;
+    }
+    if (op == "=") {
+        lo = std::max(lo, v);
+        hi = std::min(hi, v);
+    } else if (op == "<") {
+        hi = std::min(hi, below);
+    } else if (op == "<=") {
+        hi = std::min(hi, v);
+    } else if (op == ">") {
+        lo = std::max(lo, above);
+    } else if (op == ">=") {
+        lo = std::max(lo, v);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+template <class T> void gather(std::vector<T>& col, const std::vector<quint32>& rows) {
+    std::vector<T> out;
+    out.reserve(rows.size());
+    for (quint32 r : rows)
+        out.push_back(col[r]);
+    col.swap(out);
+}
+} // namespace
+
+// ---------- LabelQuery ----------
+bool LabelQuery::filtersPlates() const {
+    return colors != 0x0f || classes != 0xff || minArea > 0 || maxArea < kInf || minSize > 0
+        || maxSize < kInf;
+}
+
+bool LabelQuery::parse(const QString& text, LabelQuery& out, QString* err) {
+    static const QRegularExpression kCond(R"(^([A-Za-z]+)(<=|>=|!=|=|<|>)(\S+)$)");
+    auto fail = [err](const QString& why) {
+        if (err)
+            *err = why;
+        return false;
+    };
+
+    LabelQuery q;
+    for (const QString& tok : text.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts)) {
+        const QString word = tok.toLower();
+        if (word == "labeled") {
+            q.labeled = Labeled::Yes;
+            continue;
+        }
+        if (word == "unlabeled") {
+            q.labeled = Labeled::No;
+            continue;
+        }
+        const auto m = kCond.match(tok);
+        if (!m.hasMatch())
+            return fail(QString("无法识别的条件：%1").arg(tok));
+        const QString key = m.captured(1).toLower();
+        const QString op  = m.captured(2);
+        const QString val = m.captured(3);
+
+        if (key == "color" || key == "class") {
+            if (op != "=" && op != "!=")
+                return fail(QString("%1 只支持 = 或 !=").arg(key));
+            quint8 mask = 0;
+            for (const QString& v : val.split(',', Qt::SkipEmptyParts)) {
+                if (key == "color") {
+                    const ColorId c = parseColorId(v);
+                    if (colorLetter(c).compare(v.left(1), Qt::CaseInsensitive) != 0)
+                        return fail(QString("未知颜色：%1").arg(v));
+                    mask |= quint8(1u << int(c));
+                } else {
+                    const ClassId c = parseClassId(v);
+                    if (classToken(c).compare(v, Qt::CaseInsensitive) != 0)
+                        return fail(QString("未知类别：%1").arg(v));
+                    mask |= quint8(1u << int(c));
+                }
+            }
+            if (op == "!=")
+                mask = quint8(~mask);
+            (key == "color" ? q.colors : q.classes) &= mask; // 多个条件取交集
+            continue;
+        }
+
+        bool ok = false;
+        if (key == "plates") {
+            const int v = val.toInt(&ok);
+            if (!ok || !narrow(op, v, q.minPlates, q.maxPlates))
+                return fail(QString("无效条件：%1").arg(tok));
+            continue;
+        }
+        const float v = val.toFloat(&ok);
+        float* lo     = key == "area" ? &q.minArea : key == "size" ? &q.minSize : nullptr;
+        float* hi     = key == "area" ? &q.maxArea : key == "size" ? &q.maxSize : nullptr;
+        if (!lo)
+            return fail(QString("未知字段：%1").arg(key));
+        if (!ok || !narrow(op, v, *lo, *hi))
+            return fail(QString("无效条件：%1").arg(tok));
+    }
+    out = q;
+    return true;
+}
+
+// ---------- LabelTable ----------
+quint32 LabelTable::addImage(const QString& path, bool labeled, const std::vector<Plate>& plates) {
+    const quint32 id = quint32(images_.size());
+    images_.push_back({path, 0, 0, labeled, true});
+    appendRows(id, plates);
+    return id;
+}
+
+void LabelTable::setImage(quint32 id, bool labeled, const std::vector<Plate>& plates) {
+    retireRows(id);
+    images_[id].labeled = labeled;
+    images_[id].alive   = true;
+    appendRows(id, plates);
+}
+
+std::vector<Plate> LabelTable::plates(quint32 id) const {
+    const Image& im = images_[id];
+    std::vector<Plate> out(im.rowCount);
+    for (quint32 i = 0; i < im.rowCount; ++i) {
+        const size_t r = im.rowBegin + i;
+        Plate& p       = out[i];
+        p.color        = ColorId(color_[r]);
+        p.cls          = ClassId(cls_[r]);
+        for (size_t k = 0; k < 8; ++k)
+            p.pts[k] = pts_[k][r];
+    }
+    return out;
+}
+
+void LabelTable::removeImage(quint32 id) {
+    retireRows(id);
+    images_[id].labeled = false;
+    images_[id].alive   = false;
+}
+
+void LabelTable::reserve(qsizetype images, qsizetype rows) {
+    images_.reserve(size_t(images));
+    image_.reserve(size_t(rows));
+    color_.reserve(size_t(rows));
+    cls_.reserve(size_t(rows));
+    for (auto& c : pts_)
+        c.reserve(size_t(rows));
+    area_.reserve(size_t(rows));
+}
+
+void LabelTable::appendRows(quint32 id, const std::vector<Plate>& plates) {
+    Image& im   = images_[id];
+    im.rowBegin = quint32(image_.size());
+    im.rowCount = quint32(plates.size());
+    for (const Plate& p : plates) {
+        image_.push_back(id);
+        color_.push_back(quint8(p.color));
+        cls_.push_back(quint8(p.cls));
+        for (int k = 0; k < 8; ++k)
+            pts_[size_t(k)].push_back(p.pts[k]);
+        area_.push_back(p.area());
+    }
+}
+
+void LabelTable::retireRows(quint32 id) {
+    Image& im = images_[id];
+    std::fill_n(image_.begin() + im.rowBegin, im.rowCount, kDeadRow);
+    deadRows_ += im.rowCount;
+    im.rowCount = 0;
+    if (deadRows_ >= kCompactMinRows && deadRows_ * 2 > qsizetype(image_.size()))
+        compact();
+}
+
+void LabelTable::compact() {
+    std::vector<quint32> rows; // 存活行的旧下标，按图片 id 排列
+    rows.reserve(image_.size() - size_t(deadRows_));
+    for (Image& im : images_) {
+        const quint32 begin = im.rowBegin;
+        im.rowBegin         = quint32(rows.size());
+        for (quint32 r = begin; r < begin + im.rowCount; ++r)
+            rows.push_back(r);
+    }
+    gather(image_, rows);
+    gather(color_, rows);
+    gather(cls_, rows);
+    for (auto& c : pts_)
+        gather(c, rows);
+    gather(area_, rows);
+    deadRows_ = 0;
+}
+
+LabelQueryResult LabelTable::query(const LabelQuery& q) const {
+    const bool byPlate  = q.filtersPlates();
+    const bool bySize   = q.minSize > 0 || q.maxSize < LabelQuery::kInf;
+    const int minPlates = q.minPlates >= 0 ? q.minPlates : (byPlate ? 1 : 0);
+
+    // 只有装甲板级条件才需要扫列；否则每图命中数就是它的行数
+    std::vector<int> hits;
+    if (byPlate) {
+        hits.assign(images_.size(), 0);
+        const size_t n = image_.size();
+        for (size_t r = 0; r < n; ++r) {
+            const quint32 id = image_[r];
+            if (id == kDeadRow || !((q.colors >> color_[r]) & 1) || !((q.classes >> cls_[r]) & 1))
+                continue;
+            if (area_[r] < q.minArea || area_[r] > q.maxArea)
+                continue;
+            if (bySize) {
+                float x0 = pts_[0][r], x1 = x0, y0 = pts_[1][r], y1 = y0;
+                for (size_t k = 2; k < 8; k += 2) {
+                    x0 = std::min(x0, pts_[k][r]);
+                    x1 = std::max(x1, pts_[k][r]);
+                    y0 = std::min(y0, pts_[k + 1][r]);
+                    y1 = std::max(y1, pts_[k + 1][r]);
+                }
+                const float size = std::max(x1 - x0, y1 - y0);
+                if (size < q.minSize || size > q.maxSize)
+                    continue;
+            }
+            ++hits[id];
+        }
+    }
+
+    LabelQueryResult res;
+    for (size_t id = 0; id < images_.size(); ++id) {
+        const Image& im = images_[id];
+        if (!im.alive)
+            continue;
+        if ((q.labeled == LabelQuery::Labeled::Yes && !im.labeled)
+            || (q.labeled == LabelQuery::Labeled::No && im.labeled))
+            continue;
+        const int h = byPlate ? hits[id] : int(im.rowCount);
+        if (h < minPlates || h > q.maxPlates)
+            continue;
+        res.images.push_back(im.path);
+        res.plates += h;
+    }
+    std::sort(res.images.begin(), res.images.end());
+    return res;
+}
+
+// ---------- LabelStore ----------
+LabelStore::LabelStore(QObject* parent)
+    : QObject(parent) {
+    pool_.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+}
+
+LabelStore::~LabelStore() {
+    cancel();
+    if (driver_.joinable())
+        driver_.join();
+    pool_.waitForDone(); // refreshImages 的任务
+}
+
+LabelStore::ImageLabels LabelStore::scanImage(const QString& imagePath) {
+    ImageLabels out;
+    const QString lbl = FileService::labelFileForImage(imagePath);
+    if (!QFile::exists(lbl))
+        return out;
+    out.labeled      = true;
+    const QSize size = DatasetIndex::imageSize(imagePath); // 只读文件头
+    if (!size.isEmpty())
+        out.plates = FileService::readPlates(lbl, size);
+    return out;
+}
+
+LabelStore::Built LabelStore::build(const QString& root, QThreadPool& pool, const std::atomic_bool* cancel) {
+    Built out;
+    DatasetIndex index;
+    if (!index.build(root, cancel))
+        return out;
+
+    const qsizetype n = index.size();
+    std::vector<ImageLabels> each(size_t(n));
+    util::parallelFor(
+        pool, n, 32, [&](qsizetype i) { each[size_t(i)] = scanImage(index.at(i).imagePath); }, cancel);
+    if (cancel && cancel->load())
+        return out;
+
+    qsizetype rows = 0;
+    for (const auto& e : each)
+        rows += qsizetype(e.plates.size());
+    out.table.reserve(n, rows);
+    out.ids.reserve(n);
+    for (qsizetype i = 0; i < n; ++i) {
+        auto& e            = each[size_t(i)];
+        const QString& img = index.at(i).imagePath;
+        out.ids.insert(img, out.table.addImage(img, e.labeled, e.plates));
+        std::vector<Plate>().swap(e.plates); // 边拷边释放，峰值内存约一份
+    }
+    return out;
+}
+
+void LabelStore::cancel() {
+    cancel_.store(true);
+    if (!running_.exchange(false))
+        return;
+    // 建表被取消：已投递的结果作废，排队的增量丢弃，表不再对应任何数据集（下次 start 重建）
+    ++generation_;
+    pending_.clear();
+    root_.clear();
+    table_ = {};
+    ids_.clear();
+}
+
+void LabelStore::start(const QString& root) {
+    cancel();
+    if (driver_.joinable())
+        driver_.join(); // 旧的建表已取消；已投递的结果会因代号不符被丢弃
+    cancel_.store(false);
+    running_.store(true);
+    root_ = QDir::cleanPath(root);
+    pending_.clear();
+
+    const quint64 gen = ++generation_;
+    driver_           = std::thread([this, root = root_, gen] {
+        auto built = std::make_shared<Built>(build(root, pool_, &cancel_));
+        if (cancel_.load())
+            return;
+
+        // 回到 GUI 线程换表，再补上建表期间到达的增量
+        QMetaObject::invokeMethod(this, [this, gen, built] {
+            if (gen != generation_)
+                return;
+            table_ = std::move(built->table);
+            ids_   = std::move(built->ids);
+            running_.store(false);
+            const auto pending = std::exchange(pending_, {});
+            for (auto it = pending.begin(); it != pending.end(); ++it)
+                apply(it.key(), it.value().get());
+            LOGI(QString("标注库就绪：%1 张图片，%2 个装甲板")
+                     .arg(table_.imageCount())
+                     .arg(table_.rowCount()));
+            emit ready(table_.imageCount(), table_.rowCount());
+        });
+    });
+}
+
+bool LabelStore::lookup(const QString& imagePath, ImageLabels& out) const {
+    const auto it = ids_.constFind(imagePath);
+    if (it == ids_.constEnd() || !table_.image(*it).alive)
+        return false;
+    out.labeled = table_.image(*it).labeled;
+    out.plates  = table_.plates(*it);
+    return true;
+}
+
+bool LabelStore::inRoot(const QString& path) const {
+    return !root_.isEmpty() && path.startsWith(root_ + '/');
+}
+
+void LabelStore::updateImage(const QString& imagePath, const QVector<Armor>& armors) {
+    if (!inRoot(imagePath) || !DatasetIndex::isImageFile(imagePath))
+        return; // 视频帧是 <视频>#<帧号> 虚拟路径，不进表
+    auto next     = std::make_shared<ImageLabels>();
+    next->labeled = true;
+    next->plates.reserve(size_t(armors.size()));
+    for (const auto& a : armors)
+        next->plates.push_back(toPlate(a));
+    if (running_.load()) {
+        pending_.insert(imagePath, next);
+        return;
+    }
+    apply(imagePath, next.get());
+    emit imagesChanged({imagePath});
+}
+
+void LabelStore::removeImage(const QString& imagePath) {
+    if (!inRoot(imagePath))
+        return;
+    if (running_.load()) {
+        pending_.insert(imagePath, nullptr);
+        return;
+    }
+    apply(imagePath, nullptr);
+    emit imagesChanged({imagePath});
+}
+
+void LabelStore::refreshImages(const QStringList& imagePaths) {
+    QStringList paths;
+    for (const QString& p : imagePaths)
+        if (inRoot(p))
+            paths.push_back(p);
+    if (paths.isEmpty())
+        return;
+
+    pool_.start([this, gen = generation_, paths] {
+        auto fresh = std::make_shared<std::vector<ImageLabels>>();
+        fresh->reserve(size_t(paths.size()));
+        for (const QString& p : paths)
+            fresh->push_back(scanImage(p));
+        QMetaObject::invokeMethod(this, [this, gen, paths, fresh] {
+            if (gen != generation_)
+                return;
+            for (qsizetype i = 0; i < paths.size(); ++i) {
+                auto next = std::make_shared<ImageLabels>(std::move((*fresh)[size_t(i)]));
+                if (running_.load())
+                    pending_.insert(paths[i], next);
+                else
+                    apply(paths[i], next.get());
+            }
+            if (!running_.load())
+                emit imagesChanged(paths);
+        });
+    });
+}
+
+void LabelStore::apply(const QString& imagePath, const ImageLabels* next) {
+    const auto it = ids_.constFind(imagePath);
+    if (it == ids_.constEnd()) {
+        if (next)
+            ids_.insert(imagePath, table_.addImage(imagePath, next->labeled, next->plates));
+        return;
+    }
+    if (next)
+        table_.setImage(*it, next->labeled, next->plates);
+    else
+        table_.removeImage(*it);
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include "types.hpp"
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+#include <array>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// 标注查询条件；未设置的字段不参与过滤。
+// 装甲板级条件先筛出每张图命中的装甲板，再按命中数与是否有标注文件筛图片
+struct LabelQuery {
+    enum class Labeled : unsigned char { Any, Yes, No };
+    static constexpr float kInf = std::numeric_limits<float>::infinity();
+
+    quint8 colors  = 0x0f; // 位掩码：1 << ColorId
+    quint8 classes = 0xff; // 位掩码：1 << ClassId
+    float minArea = 0, maxArea = kInf; // 四边形面积（px²）
+    float minSize = 0, maxSize = kInf; // 外接框长边（px）
+    int minPlates = -1;                // 每图命中数下限；-1：有装甲板条件时为 1，否则不限
+    int maxPlates = std::numeric_limits<int>::max();
+    Labeled labeled = Labeled::Any;
+
+    bool filtersPlates() const;
+    // 空格分隔的条件，如 "color=R class=Bb size<20"、"plates>4"、"unlabeled"；
+    // 键：color / class（=、!=，逗号分隔多值）、area / size / plates（= < <= > >=）
+    static bool parse(const QString& text, LabelQuery& out, QString* err = nullptr);
+};
+
+struct LabelQueryResult {
+    QStringList images; // 按路径排序
+    qint64 plates = 0;  // 命中的装甲板总数
+};
+
+// 列式（SoA）标注表：每个装甲板一行，各字段一列连续存放，过滤时只扫需要的列。
+// 一张图的装甲板总是连续追加；改写时旧行作废（image 列置 kDeadRow），作废过半再压实
+class LabelTable {
+public:
+    static constexpr quint32 kDeadRow = 0xffffffffu;
+
+    struct Image {
+        QString path;
+        quint32 rowBegin = 0;
+        quint32 rowCount = 0;
+        bool labeled     = false; // 存在标注文件
+        bool alive       = true;  // 已删除的图片保留 id，不再参与查询
+    };
+
+    // 追加一张新图片，返回 id
+    quint32 addImage(const QString& path, bool labeled, const std::vector<Plate>& plates);
+    void setImage(quint32 id, bool labeled, const std::vector<Plate>& plates);
+    void reserve(qsizetype images, qsizetype rows);
+    void removeImage(quint32 id);
+
+    qsizetype imageCount() const { return qsizetype(images_.size()); }
+    qsizetype rowCount() const { return qsizetype(image_.size()) - deadRows_; }
+    const Image& image(quint32 id) const { return images_[id]; }
+    std::vector<Plate> plates(quint32 id) const; // 从列还原一张图的装甲板（不含 score）
+
+    LabelQueryResult query(const LabelQuery& q) const;
+
+private:
+    void appendRows(quint32 id, const std::vector<Plate>& plates);
+    void retireRows(quint32 id);
+    void compact();
+
+    std::vector<Image> images_;
+    // 列
+    std::vector<quint32> image_;
+    std::vector<quint8> color_;
+    std::vector<quint8> cls_;
+    std::array<std::vector<float>, 8> pts_; // x0 y0 x1 y1 x2 y2 x3 y3
+    std::vector<float> area_;
+    qsizetype deadRows_ = 0;
+};
+
+// 数据集的标注库：打开数据集时并行读取全部 ../label/*.txt 建表，之后由保存/删除增量维护。
+// 这是数据集唯一的全量扫描，DatasetStats 由这张表派生
+class LabelStore : public QObject {
+    Q_OBJECT
+public:
+    // 一张图片的标注（增量更新的单位）
+    struct ImageLabels {
+        bool labeled = false;
+        std::vector<Plate> plates;
+    };
+
+    explicit LabelStore(QObject* parent = nullptr);
+    ~LabelStore() override;
+
+    static ImageLabels scanImage(const QString& imagePath); // 读文件头尺寸 + 标注文件
+
+    struct Built {
+        LabelTable table;
+        QHash<QString, quint32> ids; // 图片路径 → id
+    };
+    static Built build(const QString& root, QThreadPool& pool, const std::atomic_bool* cancel = nullptr);
+
+    const QString& root() const { return root_; }
+    bool isRunning() const { return running_.load(); }
+    const LabelTable& table() const { return table_; }
+    bool lookup(const QString& imagePath, ImageLabels& out) const; // 图片不在表中或已删除时返回 false
+    LabelQueryResult query(const LabelQuery& q) const { return table_.query(q); }
+
+public slots:
+    void start(const QString& root); // 后台全量建表，覆盖旧表
+    void cancel();
+    void updateImage(const QString& imagePath, const QVector<Armor>& armors); // 标注已保存
+    void removeImage(const QString& imagePath);                               // 图片已删除
+    void refreshImages(const QStringList& imagePaths); // 外部新增/覆盖的图片：后台重读
+
+signals:
+    void ready(qsizetype images, qsizetype plates);
+    void imagesChanged(const QStringList& imagePaths); // 就绪后的增量已写入表
+
+private:
+    void apply(const QString& imagePath, const ImageLabels* next); // next 为空表示移除
+    bool inRoot(const QString& path) const;
+
+    QString root_;
+    LabelTable table_;
+    QHash<QString, quint32> ids_;
+    QHash<QString, std::shared_ptr<ImageLabels>> pending_; // 建表期间到达的增量（空指针 = 移除）
+
+    quint64 generation_ = 0;
+
+    QThreadPool pool_;
+    std::thread driver_;
+    std::atomic_bool running_{false};
+    std::atomic_bool cancel_{false};
+};
@@ -0,0 +1,31 @@
+#include "service/label_writer.hpp"
+#include "logger/core.hpp"
+#include <QDir>
+#include <QFileInfo>
+
+bool LabelWriter::write(
+    const QString& labelPath, const QByteArray& bytes, util::FsyncPolicy policy, bool force) {
+    auto it = lastBytes_.constFind(labelPath);
+    if (!force && it != lastBytes_.constEnd() && it.value() == bytes) {
+        emit written(labelPath, true); // 内容未变，跳过 I/O；磁盘上已是这份内容
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(labelPath).absolutePath());
+    QString err;
+    const bool ok = util::writeFileAtomic(labelPath, bytes, policy, &err);
+    if (ok) {
+        lastBytes_.insert(labelPath, bytes); // 隐式共享，不复制
+    } else {
+        lastBytes_.remove(labelPath);
+        LOGE(QString("自动保存失败：%1 (%2)").arg(labelPath, err));
+    }
+    emit written(labelPath, ok);
+    return ok;
+}
+
+void LabelWriter::remember(const QString& labelPath, const QByteArray& bytes) {
+    lastBytes_.insert(labelPath, bytes);
+}
+
+void LabelWriter::forget(const QString& labelPath) { lastBytes_.remove(labelPath); }
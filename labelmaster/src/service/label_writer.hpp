@@ -0,0 +1,29 @@
+#pragma once
+#include "util/atomic_file.hpp"
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QString>
+
+// 后台标注写入器：运行在 FileService 的写线程上，所有成员只在该线程访问
+class LabelWriter : public QObject {
+    Q_OBJECT
+public:
+    explicit LabelWriter(QObject* parent = nullptr)
+        : QObject(parent) {}
+
+    // 内容与上次写入（或加载）逐字节一致则跳过；force 时无条件写入
+    bool write(
+        const QString& labelPath, const QByteArray& bytes, util::FsyncPolicy policy,
+        bool force = false);
+    // 记录磁盘上已有的内容（打开图片时调用），避免无改动时回写
+    void remember(const QString& labelPath, const QByteArray& bytes);
+    void forget(const QString& labelPath);
+
+signals:
+    void written(const QString& labelPath, bool ok); // 每次 write 都会发出（跳过也算成功）
+
+private:
+    // 标注文件只有几百字节：直接存内容比较，哈希碰撞会悄悄跳过真实的写入
+    QHash<QString, QByteArray> lastBytes_;
+};
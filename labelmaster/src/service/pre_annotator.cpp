@@ -0,0 +1,256 @@
+#include "service/pre_annotator.hpp"
+#include "detector/ai/detector.hpp"
+#include "logger/core.hpp"
+#include "service/dataset_index.hpp"
+#include "service/file.hpp"
+#include "service/job_journal.hpp"
+#include "util/bridge.hpp"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImageReader>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+
+namespace {
+constexpr int kProgressMs     = 1000;
+constexpr int kThrottlePollMs = 100;
+constexpr double kRecentAlpha = 0.3; // 近期速度的指数平滑系数
+
+struct Decoded {
+    QString path;
+    QImage image; // 缩小解码后的像素
+    QSize full;   // 原图尺寸（标注坐标系）
+};
+
+// 按网络输入尺寸缩小解码（JPEG 走 DCT 降采样）；与打开图片一样应用 EXIF 旋转
+Decoded decode(const QString& path) {
+    Decoded d;
+    d.path = path;
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    QSize full         = reader.size();
+    const bool rotated = reader.transformation() & QImageIOHandler::TransformationRotate90;
+    if (rotated)
+        full.transpose();
+    if (full.isValid() && std::max(full.width(), full.height()) > PreAnnotator::kDecodeEdge) {
+        const QSize small = full.scaled(
+            PreAnnotator::kDecodeEdge, PreAnnotator::kDecodeEdge, Qt::KeepAspectRatio);
+        reader.setScaledSize(rotated ? small.transposed() : small);
+    }
+    d.image = reader.read();
+    d.full  = full.isValid() ? full : d.image.size();
+    return d;
+}
+} // namespace
+
+// ---------- Throttle ----------
+void PreAnnotator::Throttle::touch() {
+    lastMs_.store(QDateTime::currentMSecsSinceEpoch(), std::memory_order_relaxed);
+}
+
+bool PreAnnotator::Throttle::userActive() const {
+    return QDateTime::currentMSecsSinceEpoch() - lastMs_.load(std::memory_order_relaxed)
+         < idleMs_.load(std::memory_order_relaxed);
+}
+
+// ---------- PreAnnotator ----------
+QStringList PreAnnotator::pendingImages(
+    const QString& root, const JobJournal* journal, qint64* resumed, const std::atomic_bool* cancel) {
+    QStringList out;
+    qint64 skipped = 0;
+    DatasetIndex index;
+    if (index.build(root, cancel)) {
+        for (const auto& e : index.entries()) {
+            if (QFile::exists(FileService::labelFileForImage(e.imagePath)))
+                continue;
+            if (journal && journal->isDone(e.imagePath)) {
+                ++skipped; // 上次跑过但没有检测结果
+                continue;
+            }
+            out.push_back(e.imagePath);
+        }
+    }
+    if (resumed)
+        *resumed = skipped;
+    return out;
+}
+
+PreAnnotator::Result PreAnnotator::run(
+    const QStringList& images, const Options& opt, const std::atomic_bool* cancel,
+    const ProgressFn& onProgress) {
+    Result res;
+    res.total = images.size();
+    if (images.isEmpty())
+        return res;
+
+    ai::Detector detector;
+    detector.setupModel(opt.assetsDir, /*throughput=*/true);
+    if (!detector.isReady()) {
+        LOGE(QString("预标注：模型加载失败（%1/models）").arg(opt.assetsDir));
+        res.aborted = true;
+        res.failed  = res.done = res.total;
+        return res;
+    }
+    QElapsedTimer clock; // 吞吐不含模型编译时间
+    clock.start();
+    const int workers = std::clamp(
+        opt.workers > 0 ? opt.workers : detector.optimalRequests(), 1, int(images.size()));
+    LOGI(QString("预标注：%1 张图片，%2 个推理请求").arg(images.size()).arg(workers));
+
+    std::atomic<qsizetype> next{0};
+    std::atomic<qint64> done{0}, written{0}, plates{0}, failed{0};
+    auto stopped = [cancel] { return cancel && cancel->load(std::memory_order_relaxed); };
+    auto take    = [&]() -> Decoded {
+        const qsizetype i = stopped() ? images.size() : next.fetch_add(1);
+        return i < images.size() ? decode(images.at(i)) : Decoded{};
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    auto finish = [&](const QString& path, bool ok) {
+        if (!ok)
+            failed.fetch_add(1);
+        if (opt.journal) // 标注文件先落盘，再记日志：两者之间崩溃也只会重跑这一张
+            ok ? opt.journal->markDone(path) : opt.journal->markFailed(path);
+        done.fetch_add(1);
+    };
+
+    for (int w = 0; w < workers; ++w) {
+        pool.start([&, w] {
+            ov::InferRequest request = detector.createRequest();
+            // 第 0 个工作线程始终运行；其余在用户操作期间暂停领取新图
+            auto yield = [&] {
+                while (w > 0 && opt.throttle && opt.throttle->userActive() && !stopped())
+                    QThread::msleep(kThrottlePollMs);
+            };
+            yield();
+            Decoded cur = take();
+            while (!cur.path.isEmpty()) {
+                if (cur.image.isNull()) {
+                    LOGW(QString("预标注：解码失败 %1").arg(cur.path));
+                    finish(cur.path, false);
+                    yield();
+                    cur = take();
+                    continue;
+                }
+                QVector<Armor> armors;
+                Decoded nxt;
+                try {
+                    const util::ImageView view = util::viewOf(cur.image);
+                    const auto in              = detector.prepare(view.mat, view.order);
+                    request.set_input_tensor(in.tensor);
+                    request.start_async();
+                    nxt = take(); // 推理期间解码下一张
+                    request.wait();
+                    armors = detector.parse(request.get_output_tensor(), in.scale);
+                } catch (const std::exception& e) {
+                    LOGW(QString("预标注：推理失败 %1 (%2)").arg(cur.path, e.what()));
+                    finish(cur.path, false);
+                    cur = nxt.path.isEmpty() ? take() : std::move(nxt);
+                    continue;
+                }
+
+                // 检测坐标在缩小图上，换回原图坐标
+                const double sx = double(cur.full.width()) / cur.image.width();
+                const double sy = double(cur.full.height()) / cur.image.height();
+                armors.removeIf([&](const Armor& a) { return a.score < opt.minScore; });
+                for (auto& a : armors)
+                    for (QPointF* p : {&a.p0, &a.p1, &a.p2, &a.p3})
+                        *p = QPointF(p->x() * sx, p->y() * sy);
+
+                // 没有检测结果不写文件：图片仍算“未标注”，留给人工（日志记为已完成，不会重跑）。
+                // 期间用户已手动保存过的不覆盖
+                bool ok           = true;
+                const QString lbl = FileService::labelFileForImage(cur.path);
+                if (!armors.isEmpty() && !QFile::exists(lbl)) {
+                    ok = FileService::writeLabelFile(lbl, armors, cur.full);
+                    if (ok) {
+                        written.fetch_add(1);
+                        plates.fetch_add(armors.size());
+                    }
+                }
+                finish(cur.path, ok);
+                yield();
+                cur = std::move(nxt);
+            }
+        });
+    }
+
+    auto snapshot = [&] {
+        const qint64 prevDone = res.done;
+        const double prevSecs = res.seconds;
+        res.done              = done.load();
+        res.written           = written.load();
+        res.plates            = plates.load();
+        res.failed            = failed.load();
+        res.seconds           = clock.elapsed() / 1000.0;
+        res.cancelled         = stopped() && res.done < res.total;
+        const double dt       = res.seconds - prevSecs;
+        if (dt > 0) {
+            const double inst = double(res.done - prevDone) / dt;
+            res.recent        = res.recent > 0 ? res.recent + kRecentAlpha * (inst - res.recent) : inst;
+        }
+        return res;
+    };
+    while (!pool.waitForDone(kProgressMs))
+        if (onProgress)
+            onProgress(snapshot());
+    snapshot();
+    LOGI(QString("预标注%1：%2/%3 张，写出 %4，装甲板 %5，失败 %6，%7 张/秒")
+             .arg(res.cancelled ? "已取消" : "完成")
+             .arg(res.done)
+             .arg(res.total)
+             .arg(res.written)
+             .arg(res.plates)
+             .arg(res.failed)
+             .arg(res.rate(), 0, 'f', 1));
+    return res;
+}
+
+// ---------- PreAnnotateJob ----------
+PreAnnotateJob::PreAnnotateJob(QObject* parent)
+    : QObject(parent) {}
+
+PreAnnotateJob::~PreAnnotateJob() {
+    cancel();
+    if (driver_.joinable())
+        driver_.join();
+}
+
+void PreAnnotateJob::cancel() { cancel_.store(true); }
+
+bool PreAnnotateJob::start(const QString& root, PreAnnotator::Options opt, bool restart) {
+    if (root.isEmpty() || running_.exchange(true))
+        return false;
+    if (driver_.joinable())
+        driver_.join();
+    cancel_.store(false);
+    driver_ = std::thread([=, this] { run(root, opt, restart); });
+    return true;
+}
+
+void PreAnnotateJob::run(QString root, PreAnnotator::Options opt, bool restart) {
+    JobJournal journal(root, PreAnnotator::kJournalName);
+    if (journal.open(restart))
+        opt.journal = &journal;
+    opt.throttle = &throttle_;
+
+    qint64 resumed         = 0;
+    const QStringList todo = PreAnnotator::pendingImages(root, opt.journal, &resumed, &cancel_);
+    if (resumed > 0)
+        LOGI(QString("预标注：从任务日志恢复，跳过 %1 张已处理图片").arg(resumed));
+
+    const auto res = PreAnnotator::run(todo, opt, &cancel_, [this](const PreAnnotator::Result& r) {
+        emit progress(int(r.done), int(r.total), r.recent, r.eta());
+    });
+    if (res.complete() && !cancel_.load())
+        journal.discard();
+    else
+        journal.close(); // 留着日志，下次从断点继续
+    running_.store(false);
+    emit finished(int(res.done), int(res.written), int(res.failed), res.cancelled || cancel_.load());
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+class JobJournal;
+
+// 批量预标注：对还没有标注文件的图片跑 AI 检测，结果经 FileService::writeLabelFile 写出。
+// 每个工作线程持有自己的 InferRequest（共享同一个按吞吐编译的模型）；推理异步进行，
+// 等待期间解码下一张，解码与推理相互重叠。不依赖 GUI，可在无显示的服务器上运行。
+// 处理过的图片记进数据集根目录的任务日志，取消或崩溃后再次运行从断点继续；
+// 完整跑完后日志删除，之后的运行重新检测所有未标注图片
+class PreAnnotator {
+public:
+    static constexpr int kDecodeEdge          = 640; // 网络输入边长：按它缩小解码即可，不必解原图
+    static constexpr const char* kJournalName = ".atlm_preannotate.journal";
+    static QString journalPath(const QString& root) { return root + "/" + kJournalName; }
+
+    // 用户操作时让位：只留一个工作线程，其余在操作停止 idleMs 后恢复
+    class Throttle {
+    public:
+        void touch(); // 任意线程，开销只是一次原子写
+        bool userActive() const;
+        void setIdleMs(int ms) { idleMs_.store(ms); }
+
+    private:
+        std::atomic<qint64> lastMs_{0};
+        std::atomic_int idleMs_{2000};
+    };
+
+    struct Options {
+        QString assetsDir;                  // 模型目录（其下 models/）
+        int workers              = 0;       // 0：取推理插件建议的并发请求数
+        float minScore           = 0.f;     // 低于此置信度的检测丢弃
+        JobJournal* journal      = nullptr; // 断点记录；为空则不记录
+        const Throttle* throttle = nullptr; // 为空则始终全速
+    };
+
+    struct Result {
+        qint64 total   = 0; // 本次待处理图片数（不含日志里已完成的）
+        qint64 resumed = 0; // 日志里已完成、本次跳过的
+        qint64 done    = 0; // 已处理（含失败）
+        qint64 written = 0; // 有检测结果、写出了标注文件
+        qint64 plates  = 0;
+        qint64 failed  = 0; // 解码、推理或写入失败（下次重试）
+        double seconds = 0;
+        double recent  = 0; // 近几秒的处理速度（张/秒，限速时会下降）
+        bool cancelled = false;
+        bool aborted   = false; // 模型加载失败，一张也没处理
+        bool complete() const { return !cancelled && !aborted && done == total; } // 可以删日志了
+        double rate() const { return seconds > 0 ? double(done) / seconds : 0.0; } // 张/秒
+        double eta() const { return recent > 0 ? double(total - done) / recent : -1.0; } // 秒，-1 未知
+    };
+    using ProgressFn = std::function<void(const Result& sofar)>; // 在调用 run() 的线程上约每秒一次
+
+    // root 下没有标注文件、且不在日志里记为已完成的图片（按路径排序）；resumed 返回跳过的数量
+    static QStringList pendingImages(
+        const QString& root, const JobJournal* journal = nullptr, qint64* resumed = nullptr,
+        const std::atomic_bool* cancel = nullptr);
+
+    // 阻塞直到处理完或取消；模型加载失败时 failed == total
+    static Result run(
+        const QStringList& images, const Options& opt, const std::atomic_bool* cancel = nullptr,
+        const ProgressFn& onProgress = {});
+};
+
+// GUI 用的后台预标注任务：同一时间只跑一个，进度与速度通过信号报告
+class PreAnnotateJob : public QObject {
+    Q_OBJECT
+public:
+    explicit PreAnnotateJob(QObject* parent = nullptr);
+    ~PreAnnotateJob() override;
+
+    bool isRunning() const { return running_.load(); }
+    PreAnnotator::Throttle& throttle() { return throttle_; }
+
+public slots:
+    // 已在运行时返回 false；opt.journal / opt.throttle 由任务自己提供
+    bool start(const QString& root, PreAnnotator::Options opt, bool restart = false);
+    void cancel();
+
+signals:
+    void progress(int done, int total, double itemsPerSec, double etaSeconds);
+    void finished(int done, int written, int failed, bool cancelled);
+
+private:
+    void run(QString root, PreAnnotator::Options opt, bool restart);
+
+    PreAnnotator::Throttle throttle_;
+    std::thread driver_;
+    std::atomic_bool running_{false};
+    std::atomic_bool cancel_{false};
+};
@@ -0,0 +1,321 @@
+#include "service/thumbnail_cache.hpp"
+#include "logger/core.hpp"
+
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QThread>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+// pack 布局：magic(8) 之后是若干记录
+// [u64 key][u32 size][u16 pathLen][pathLen 字节 UTF-8 相对路径][size 字节 JPEG]
+constexpr char kMagic[8]            = {'A', 'T', 'L', 'T', 'H', 'M', 'B', '2'};
+constexpr qint64 kRecordHead        = 14;
+constexpr qint64 kKeyBytes          = 64 * 1024; // 内容键只读文件开头这么多
+constexpr qint64 kMapChunk          = 64 << 20;  // 映射按此粒度预留，追加不必每次重映射
+constexpr int kJpegQuality          = 85;
+constexpr qsizetype kCompactMinDead = 256; // 作废记录少于此数时不压实
+
+bool preadAll(int fd, void* buf, size_t n, off_t off) {
+    auto* p = static_cast<char*>(buf);
+    while (n > 0) {
+        const ssize_t r = ::pread(fd, p, n, off);
+        if (r <= 0) {
+            if (r < 0 && errno == EINTR)
+                continue;
+            return false;
+        }
+        p += r;
+        n -= size_t(r);
+        off += r;
+    }
+    return true;
+}
+} // namespace
+
+ThumbnailCache::ThumbnailCache(QObject* parent)
+    : QObject(parent) {
+    pool_.setMaxThreadCount(std::max(1, QThread::idealThreadCount() / 2)); // 给导航解码留出核心
+}
+
+ThumbnailCache::~ThumbnailCache() { close(); }
+
+quint64 ThumbnailCache::contentKey(const QString& imagePath, bool* ok) {
+    QFile f(imagePath);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (ok)
+            *ok = false;
+        return 0;
+    }
+    const QByteArray head = f.read(kKeyBytes);
+    quint64 h             = 1469598103934665603ull; // FNV-1a 64
+    auto mix              = [&h](uchar c) { h = (h ^ c) * 1099511628211ull; };
+    auto mix64            = [&mix](quint64 v) {
+        for (int i = 0; i < 8; ++i)
+            mix(uchar(v >> (i * 8)));
+    };
+    for (char c : head)
+        mix(uchar(c));
+    mix64(quint64(f.size()));
+    struct stat st{};
+    if (::fstat(f.handle(), &st) == 0) // 纳秒精度：同一秒内的两次改写也能区分
+        mix64(quint64(st.st_mtim.tv_sec) * 1'000'000'000ull + quint64(st.st_mtim.tv_nsec));
+    if (ok)
+        *ok = true;
+    return h;
+}
+
+// ---------- pack 文件 ----------
+void ThumbnailCache::open(const QString& root) {
+    close();
+    QWriteLocker lk(&lock_);
+    root_             = root;
+    const QString path = root + "/" + kPackName;
+    fd_               = ::open(QFile::encodeName(path).constData(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        LOGW(QString("缩略图缓存不可写，仅使用内存：%1").arg(path));
+        return;
+    }
+    struct stat st{};
+    ::fstat(fd_, &st);
+    fileLen_ = st.st_size;
+    char magic[sizeof(kMagic)];
+    if (fileLen_ < qint64(sizeof(kMagic)) || !preadAll(fd_, magic, sizeof(magic), 0)
+        || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        // 新建或格式不符：重建
+        if (::ftruncate(fd_, 0) != 0 || ::pwrite(fd_, kMagic, sizeof(kMagic), 0) != sizeof(kMagic)) {
+            ::close(fd_);
+            fd_ = -1;
+            return;
+        }
+        fileLen_ = sizeof(kMagic);
+    }
+    QVector<Record> records;
+    scanLocked(&records);
+    compactLocked(records);
+    ensureMappedLocked();
+    LOGI(QString("缩略图缓存：%1 条，%2 KiB").arg(slots_.size()).arg(fileLen_ / 1024));
+}
+
+void ThumbnailCache::scanLocked(QVector<Record>* records) {
+    slots_.clear();
+    if (records)
+        records->clear();
+    qint64 off = sizeof(kMagic);
+    QByteArray path;
+    while (off + kRecordHead <= fileLen_) {
+        quint64 key     = 0;
+        quint32 size    = 0;
+        quint16 pathLen = 0;
+        if (!preadAll(fd_, &key, sizeof(key), off) || !preadAll(fd_, &size, sizeof(size), off + 8)
+            || !preadAll(fd_, &pathLen, sizeof(pathLen), off + 12)
+            || off + kRecordHead + pathLen + size > fileLen_)
+            break;
+        if (records) {
+            path.resize(pathLen);
+            if (!preadAll(fd_, path.data(), pathLen, off + kRecordHead))
+                break;
+            records->push_back({off, kRecordHead + pathLen + size, QString::fromUtf8(path)});
+        }
+        slots_.insert(key, {off + kRecordHead + pathLen, size});
+        off += kRecordHead + pathLen + size;
+    }
+    if (off != fileLen_) {
+        // 上次写到一半退出：丢掉残缺的尾部记录
+        if (::ftruncate(fd_, off) == 0)
+            fileLen_ = off;
+    }
+}
+
+void ThumbnailCache::compactLocked(const QVector<Record>& records) {
+    // 同一路径只有最后一条可能有效；图片已删除/改名的也作废（改名的下次请求重新生成）
+    QHash<QString, qsizetype> latest;
+    latest.reserve(records.size());
+    for (qsizetype i = 0; i < records.size(); ++i)
+        latest.insert(records[i].path, i);
+    const QDir root(root_);
+    QVector<qsizetype> live;
+    live.reserve(latest.size());
+    for (qsizetype i = 0; i < records.size(); ++i)
+        if (latest.value(records[i].path) == i && QFileInfo::exists(root.filePath(records[i].path)))
+            live.push_back(i);
+    const qsizetype dead = records.size() - live.size();
+    if (dead < kCompactMinDead || dead * 2 <= records.size())
+        return;
+
+    // 先写临时文件再改名替换：中途失败时旧 pack 完好
+    const QString path = root_ + "/" + kPackName;
+    const QString tmp  = path + ".tmp";
+    const int out      = ::open(
+        QFile::encodeName(tmp).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0)
+        return;
+    bool ok    = ::pwrite(out, kMagic, sizeof(kMagic), 0) == qint64(sizeof(kMagic));
+    qint64 pos = sizeof(kMagic);
+    QByteArray buf;
+    for (qsizetype i : live) {
+        const Record& r = records[i];
+        buf.resize(r.length);
+        ok = ok && preadAll(fd_, buf.data(), size_t(r.length), r.offset)
+          && ::pwrite(out, buf.constData(), size_t(r.length), pos) == r.length;
+        pos += r.length;
+    }
+    ::close(out);
+    if (!ok
+        || ::rename(QFile::encodeName(tmp).constData(), QFile::encodeName(path).constData()) != 0) {
+        ::unlink(QFile::encodeName(tmp).constData());
+        LOGW(QString("缩略图缓存压实失败：%1").arg(path));
+        return;
+    }
+
+    const qint64 before = fileLen_;
+    ::close(fd_);
+    fd_ = ::open(QFile::encodeName(path).constData(), O_RDWR | O_CLOEXEC);
+    if (fd_ < 0) {
+        slots_.clear();
+        fileLen_ = 0;
+        return;
+    }
+    fileLen_ = pos;
+    scanLocked();
+    LOGI(QString("缩略图缓存压实：%1 → %2 条，%3 → %4 KiB")
+             .arg(records.size())
+             .arg(live.size())
+             .arg(before / 1024)
+             .arg(fileLen_ / 1024));
+}
+
+bool ThumbnailCache::remapLocked(qint64 length) {
+    if (map_)
+        ::munmap(const_cast<uchar*>(map_), size_t(mapLen_));
+    map_    = nullptr;
+    mapLen_ = 0;
+    if (fd_ < 0 || length <= 0)
+        return false;
+    void* p = ::mmap(nullptr, size_t(length), PROT_READ, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED)
+        return false;
+    map_    = static_cast<const uchar*>(p);
+    mapLen_ = length;
+    return true;
+}
+
+bool ThumbnailCache::ensureMappedLocked() {
+    if (map_ && fileLen_ <= mapLen_)
+        return true;
+    // 多映射一段：超出文件末尾的页不会被访问，文件追加后同一映射里直接可见
+    const qint64 length = (fileLen_ / kMapChunk + 1) * kMapChunk;
+    return remapLocked(length);
+}
+
+void ThumbnailCache::close() {
+    ++epoch_;
+    pool_.clear();
+    pool_.waitForDone();
+    inFlight_.clear();
+    QWriteLocker lk(&lock_);
+    remapLocked(0);
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_      = -1;
+    fileLen_ = 0;
+    slots_.clear();
+    root_.clear();
+}
+
+bool ThumbnailCache::lookup(quint64 key, QImage& out) {
+    QReadLocker lk(&lock_);
+    const auto it = slots_.constFind(key);
+    if (it == slots_.constEnd() || it->offset + it->size > std::min(fileLen_, mapLen_))
+        return false;
+    out = QImage::fromData(map_ + it->offset, int(it->size), "JPEG");
+    return !out.isNull();
+}
+
+bool ThumbnailCache::append(quint64 key, const QString& imagePath, const QByteArray& jpeg) {
+    QWriteLocker lk(&lock_);
+    if (fd_ < 0 || slots_.contains(key))
+        return false;
+    const QByteArray path = QDir(root_).relativeFilePath(imagePath).toUtf8();
+    if (path.size() > 0xffff)
+        return false;
+    QByteArray rec(kRecordHead, Qt::Uninitialized);
+    const quint32 size    = quint32(jpeg.size());
+    const quint16 pathLen = quint16(path.size());
+    std::memcpy(rec.data(), &key, sizeof(key));
+    std::memcpy(rec.data() + 8, &size, sizeof(size));
+    std::memcpy(rec.data() + 12, &pathLen, sizeof(pathLen));
+    rec.append(path);
+    rec.append(jpeg);
+    if (::pwrite(fd_, rec.constData(), size_t(rec.size()), fileLen_) != rec.size())
+        return false;
+    slots_.insert(key, {fileLen_ + kRecordHead + pathLen, size});
+    fileLen_ += rec.size();
+    return ensureMappedLocked(); // 通常仍在预留范围内，不重映射
+}
+
+// ---------- 生成 ----------
+QImage ThumbnailCache::load(const QString& imagePath) {
+    bool ok           = false;
+    const quint64 key = contentKey(imagePath, &ok);
+    if (!ok)
+        return {};
+    QImage img;
+    if (lookup(key, img))
+        return img;
+
+    // 缩小解码：JPEG 直接走 DCT 降采样，从不做全尺寸解码
+    QImageReader reader(imagePath);
+    reader.setAutoTransform(true);
+    const QSize full = reader.size();
+    if (full.isValid() && (full.width() > kThumbSize || full.height() > kThumbSize))
+        reader.setScaledSize(full.scaled(kThumbSize, kThumbSize, Qt::KeepAspectRatio));
+    img = reader.read();
+    if (img.isNull())
+        return {};
+    if (img.width() > kThumbSize || img.height() > kThumbSize)
+        img = img.scaled(kThumbSize, kThumbSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    img = img.convertToFormat(QImage::Format_RGB888);
+
+    QByteArray jpeg;
+    QBuffer buf(&jpeg);
+    buf.open(QIODevice::WriteOnly);
+    if (img.save(&buf, "JPEG", kJpegQuality))
+        append(key, imagePath, jpeg);
+    return img;
+}
+
+void ThumbnailCache::request(const QString& imagePath) {
+    if (inFlight_.contains(imagePath))
+        return;
+    const int priority = ++seq_; // 最新可见的项先做
+    inFlight_.insert(imagePath, priority);
+    pool_.start(
+        [this, imagePath, ep = epoch_.load()] {
+            if (ep != epoch_.load())
+                return;
+            const QImage thumb = load(imagePath);
+            QMetaObject::invokeMethod(this, [this, imagePath, thumb, ep] {
+                if (ep != epoch_.load())
+                    return;
+                inFlight_.remove(imagePath);
+                emit thumbnailReady(imagePath, thumb);
+            });
+        },
+        priority);
+}
+
+void ThumbnailCache::cancelPending() {
+    pool_.clear();
+    inFlight_.clear(); // 正在跑的任务结果照常送达；被清掉的以后会重新请求
+}
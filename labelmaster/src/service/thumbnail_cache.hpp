@@ -0,0 +1,70 @@
+#pragma once
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+
+#include <atomic>
+
+// 缩略图缓存：每个数据集一个只追加的 pack 文件（根目录下的 kPackName，mmap 读取）。
+// 键是内容键（文件大小 + 修改时间 + 前 64 KiB 的 FNV-1a），改名的图片直接命中；
+// 原地改写（同尺寸重编码等，大小和文件头都可能不变）靠修改时间区分。
+// 每条记录带生成时的相对路径：被同路径新记录取代、或图片已不存在的记录视为作废，
+// 打开时作废过半就压实重写。
+// 生成在后台线程池进行：缩小解码 → JPEG 编码 → 追加到 pack；越晚请求的优先级越高
+class ThumbnailCache : public QObject {
+    Q_OBJECT
+public:
+    static constexpr const char* kPackName = ".atlm_thumbs";
+    static constexpr int kThumbSize        = 160; // 长边像素
+
+    explicit ThumbnailCache(QObject* parent = nullptr);
+    ~ThumbnailCache() override;
+
+    void open(const QString& root); // 映射已有 pack 并建立键 → 偏移索引
+    void close();
+    const QString& root() const { return root_; }
+
+    // 排队生成/读取；同一路径未完成前的重复请求被忽略
+    void request(const QString& imagePath);
+    void cancelPending(); // 丢弃全部尚未开始的请求（快速滚动时）
+
+    static quint64 contentKey(const QString& imagePath, bool* ok = nullptr);
+
+signals:
+    void thumbnailReady(const QString& imagePath, const QImage& thumb);
+
+private:
+    struct Slot {
+        qint64 offset = 0; // JPEG 字节在 pack 中的位置
+        quint32 size  = 0;
+    };
+    struct Record {
+        qint64 offset = 0; // 记录头在 pack 中的位置
+        qint64 length = 0; // 头 + 路径 + JPEG
+        QString path;      // 相对数据集根目录
+    };
+    QImage load(const QString& imagePath); // 工作线程：命中则从映射解码，否则生成并追加
+    bool lookup(quint64 key, QImage& out);
+    bool append(quint64 key, const QString& imagePath, const QByteArray& jpeg);
+    bool remapLocked(qint64 length); // 需持有写锁；length 为 0 时解除映射
+    bool ensureMappedLocked();       // 需持有写锁：映射不够覆盖 fileLen_ 时按 kMapChunk 扩大
+    void scanLocked(QVector<Record>* records = nullptr); // 需持有写锁：扫描记录头，截掉不完整的尾部
+    void compactLocked(const QVector<Record>& records);  // 需持有写锁且尚未映射：作废过半时重写
+
+    QString root_;
+    int fd_               = -1;
+    const uchar* map_     = nullptr;
+    qint64 mapLen_        = 0; // 映射长度，可以超过文件长度（只读 fileLen_ 以内）
+    qint64 fileLen_       = 0;
+    QHash<quint64, Slot> slots_;
+    QReadWriteLock lock_; // 读：查表+解码映射；写：追加+重映射
+
+    QThreadPool pool_;
+    QHash<QString, int> inFlight_; // GUI 线程：路径 → 优先级
+    int seq_ = 0;
+    std::atomic<quint64> epoch_{0}; // open/close 时递增，旧任务的结果作废
+};
@@ -0,0 +1,157 @@
+#include "service/tiled_image.hpp"
+#include "logger/core.hpp"
+
+#include <QImageReader>
+
+#include <algorithm>
+#include <cmath>
+
+TiledImage::TiledImage(const QString& path, const QSize& baseSize, QObject* parent)
+    : QObject(parent)
+    , path_(path)
+    , base_(baseSize) {
+    while (std::max(levelSize(levels_ - 1).width(), levelSize(levels_ - 1).height()) > kTileSize)
+        ++levels_;
+    regionDecode_ = QImageReader(path_).supportsOption(QImageIOHandler::ScaledClipRect);
+    cache_.setMaxCost(kCacheMiB * 1024);
+    pool_.setMaxThreadCount(2);
+    LOGI(QString("分块加载：%1（%2×%3，%4 层，%5）")
+             .arg(path_)
+             .arg(base_.width())
+             .arg(base_.height())
+             .arg(levels_)
+             .arg(regionDecode_ ? "区域解码" : "整图解码后裁块"));
+}
+
+TiledImage::~TiledImage() {
+    ++epoch_;
+    pool_.clear();
+    pool_.waitForDone();
+}
+
+QSize TiledImage::levelSize(int level) const {
+    const int d = 1 << level;
+    return {(base_.width() + d - 1) / d, (base_.height() + d - 1) / d};
+}
+
+int TiledImage::levelFor(double pixelsPerBase) const {
+    if (pixelsPerBase >= 1.0 || pixelsPerBase <= 0.0)
+        return 0;
+    const int level = int(std::floor(std::log2(1.0 / pixelsPerBase)));
+    return std::clamp(level, 0, levels_ - 1);
+}
+
+QRect TiledImage::tileRect(int level, int tx, int ty) const {
+    return QRect(tx * kTileSize, ty * kTileSize, kTileSize, kTileSize)
+        .intersected(QRect(QPoint(0, 0), levelSize(level)));
+}
+
+// ---------- 块 ----------
+bool TiledImage::tile(int level, int tx, int ty, QImage& out) {
+    const quint64 key = keyOf(level, tx, ty);
+    if (const QImage* img = cache_.object(key)) {
+        out = *img;
+        return true;
+    }
+    if (pending_.contains(key))
+        return false;
+    const QRect rect = tileRect(level, tx, ty);
+    if (rect.isEmpty())
+        return false;
+    auto started = std::make_shared<std::atomic_bool>(false);
+    pending_.insert(key, started);
+    pool_.start([this, key, level, rect, started, adj = adjust_, ep = epoch_.load()] {
+        started->store(true);
+        if (ep != epoch_.load())
+            return;
+        const QImage img = decodeTile(level, rect, adj);
+        QMetaObject::invokeMethod(this, [this, key, img, ep] {
+            if (ep != epoch_.load())
+                return;
+            pending_.remove(key);
+            if (!img.isNull())
+                cache_.insert(key, new QImage(img), std::max<qsizetype>(1, img.sizeInBytes() / 1024));
+            emit tileReady();
+        });
+    });
+    return false;
+}
+
+void TiledImage::cancelPending() {
+    pool_.clear();
+    // 只忘掉还没开始的：正在解的块结果照常入缓存，不会被重复请求
+    for (auto it = pending_.begin(); it != pending_.end();)
+        it = it.value()->load() ? std::next(it) : pending_.erase(it);
+}
+
+QImage TiledImage::fullImage() {
+    std::lock_guard lk(fullMu_);
+    if (full_.isNull()) {
+        QImageReader r(path_);
+        full_ = r.read();
+        if (full_.isNull())
+            LOGE(QString("分块加载失败：%1 (%2)").arg(path_, r.errorString()));
+    }
+    return full_;
+}
+
+QImage TiledImage::decodeTile(int level, const QRect& rect, const std::optional<util::Adjustments>& adj) {
+    QImage img;
+    if (regionDecode_) {
+        QImageReader r(path_);
+        if (level > 0) {
+            r.setScaledSize(levelSize(level));
+            r.setScaledClipRect(rect);
+        } else {
+            r.setClipRect(rect);
+        }
+        img = r.read();
+    } else {
+        const QImage full = fullImage();
+        if (full.isNull())
+            return {};
+        const int d = 1 << level;
+        const QRect src =
+            QRect(rect.x() * d, rect.y() * d, rect.width() * d, rect.height() * d).intersected(full.rect());
+        img = full.copy(src);
+        if (level > 0)
+            img = img.scaled(rect.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    if (!img.isNull() && adj)
+        img = util::applyAdjustments(img, *adj);
+    return img;
+}
+
+QImage TiledImage::region(const QRect& baseRect) {
+    const QRect rect = baseRect.intersected(QRect(QPoint(0, 0), base_));
+    if (rect.isEmpty())
+        return {};
+    QImage img;
+    {
+        std::lock_guard lk(fullMu_);
+        if (!full_.isNull())
+            img = full_.copy(rect); // 退化路径已经有整图，直接裁
+    }
+    if (img.isNull()) {
+        // 只解 ROI：支持区域解码的格式只读相关扫描行；其余格式由 Qt 临时整图解码后裁剪，
+        // 用完即释放，不像 fullImage() 那样常驻
+        QImageReader r(path_);
+        r.setClipRect(rect);
+        img = r.read();
+        if (img.isNull())
+            LOGW(QString("ROI 解码失败：%1 (%2)").arg(path_, r.errorString()));
+    }
+    if (!img.isNull() && adjust_)
+        img = util::applyAdjustments(img, *adjust_);
+    return img;
+}
+
+void TiledImage::setAdjustments(const std::optional<util::Adjustments>& adj) {
+    if (adjust_ == adj)
+        return;
+    adjust_ = adj;
+    ++epoch_; // 在途的旧块结果会被丢弃
+    pool_.clear();
+    pending_.clear();
+    cache_.clear();
+}
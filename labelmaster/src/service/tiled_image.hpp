@@ -0,0 +1,72 @@
+#pragma once
+#include "util/image_adjust.hpp"
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QRect>
+#include <QString>
+#include <QThreadPool>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+// 超大图的分块金字塔：level 0 为原图，每升一级边长减半，按 kTileSize 切块。
+// 只解码当前视野需要的块，放进 LRU；JPEG 走 ScaledClipRect 区域解码（DCT 降采样 + 只解相关扫描行），
+// 不支持区域解码的格式退化为后台整图解码一次、从中裁块（仍省掉整图缩放重绘）
+class TiledImage : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int kTileSize          = 512;
+    static constexpr qint64 kMinPixels      = 36'000'000; // 超过此像素数才走分块
+    static constexpr int kCacheMiB          = 256;
+
+    TiledImage(const QString& path, const QSize& baseSize, QObject* parent = nullptr);
+    ~TiledImage() override;
+
+    static bool shouldTile(const QSize& baseSize) {
+        return qint64(baseSize.width()) * baseSize.height() >= kMinPixels;
+    }
+
+    const QString& path() const { return path_; }
+    QSize baseSize() const { return base_; }
+    int levelCount() const { return levels_; }
+    QSize levelSize(int level) const;
+    // 每个原图像素对应 pixelsPerBase 个屏幕物理像素时该用的层
+    int levelFor(double pixelsPerBase) const;
+    QRect tileRect(int level, int tx, int ty) const; // 该层坐标
+
+    // 命中返回 true；否则排队解码（同一块只排一次），完成后发 tileReady
+    bool tile(int level, int tx, int ty, QImage& out);
+    void cancelPending();                 // 视野变了：丢掉排队中的块请求
+    QImage region(const QRect& baseRect); // 同步：原图分辨率的区域（检测 ROI 用）
+
+    // 与画布一致的显示调整（nullopt 关闭），作用在解码后的块上
+    void setAdjustments(const std::optional<util::Adjustments>& adj);
+
+signals:
+    void tileReady();
+
+private:
+    static quint64 keyOf(int level, int tx, int ty) {
+        return (quint64(level) << 48) | (quint64(ty) << 24) | quint64(tx);
+    }
+    QImage decodeTile(int level, const QRect& rect, const std::optional<util::Adjustments>& adj); // 工作线程
+    QImage fullImage();                              // 退化路径：整图解码一次
+
+    QString path_;
+    QSize base_;
+    int levels_         = 1;
+    bool regionDecode_  = false; // 格式支持 ScaledClipRect
+    std::optional<util::Adjustments> adjust_; // 仅 GUI 线程读写；排队时按值带进任务
+
+    QCache<quint64, QImage> cache_;
+    QHash<quint64, std::shared_ptr<std::atomic_bool>> pending_; // 块 → 是否已开始解码
+    QThreadPool pool_;
+    std::atomic<quint64> epoch_{0}; // 切换均衡化时递增，旧块作废
+
+    std::mutex fullMu_;
+    QImage full_; // 仅退化路径使用
+};
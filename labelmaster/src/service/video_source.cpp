@@ -0,0 +1,305 @@
+#include "service/video_source.hpp"
+#include "logger/core.hpp"
+#include "util/atomic_file.hpp"
+#include "util/bridge.hpp"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <opencv2/core/version.hpp>
+#include <utility>
+
+namespace {
+constexpr quint32 kIndexMagic  = 0x41564931; // "AVI1"
+constexpr int kProgressStep    = 4096;
+constexpr int kMaxForwardGrab  = 64; // 同一 GOP 内往后不超过这么多帧就直接 grab，不 seek
+} // namespace
+
+VideoSource::VideoSource(QObject* parent)
+    : QObject(parent) {
+    cache_.setMaxCost(kCacheMiB);
+}
+
+VideoSource::~VideoSource() { close(); }
+
+// ---------- 路径约定 ----------
+const QStringList& VideoSource::videoFilters() {
+    static const QStringList f{"*.mp4", "*.avi", "*.mkv", "*.mov"};
+    return f;
+}
+
+bool VideoSource::isVideoFile(const QString& path) {
+    const QString low = path.toLower();
+    for (const auto& ext : videoFilters())
+        if (low.endsWith(ext.mid(1)))
+            return true;
+    return false;
+}
+
+QString VideoSource::framePath(const QString& videoPath, int frame) {
+    return QString("%1#%2").arg(videoPath).arg(frame, 6, 10, QChar('0'));
+}
+
+bool VideoSource::parseFramePath(const QString& path, QString* videoPath, int* frame) {
+    const int hash = path.lastIndexOf('#');
+    if (hash <= 0)
+        return false;
+    bool ok     = false;
+    const int n = path.mid(hash + 1).toInt(&ok);
+    if (!ok || n < 0 || !isVideoFile(path.left(hash)))
+        return false;
+    if (videoPath)
+        *videoPath = path.left(hash);
+    if (frame)
+        *frame = n;
+    return true;
+}
+
+QString VideoSource::frameLabelPath(const QString& videoPath, int frame) {
+    // 与“抽帧成 <视频名>_<帧号>.jpg”后的标注同名：以后真要抽帧，标注无需改动
+    const QFileInfo fi(videoPath);
+    const QString dirPath = QDir::cleanPath(fi.absolutePath() + "/../label");
+    return QString("%1/%2_%3.txt").arg(dirPath, fi.completeBaseName()).arg(frame, 6, 10, QChar('0'));
+}
+
+// ---------- 寻址索引：(大小, mtime) 校验，缓存在 .<文件名>.atlm_vidx ----------
+QString VideoSource::indexPathFor(const QString& videoPath) {
+    const QFileInfo fi(videoPath);
+    return fi.absolutePath() + "/." + fi.fileName() + ".atlm_vidx";
+}
+
+bool VideoSource::loadIndex(const QString& videoPath, SeekIndex& idx) {
+    QFile f(indexPathFor(videoPath));
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+    const QFileInfo fi(videoPath);
+    QDataStream in(&f);
+    quint32 magic = 0;
+    in >> magic >> idx.size >> idx.mtime >> idx.frames >> idx.fps >> idx.keyframes;
+    return in.status() == QDataStream::Ok && magic == kIndexMagic && idx.size == fi.size()
+        && idx.mtime == fi.lastModified().toMSecsSinceEpoch() && idx.frames > 0;
+}
+
+bool VideoSource::saveIndex(const QString& videoPath, const SeekIndex& idx) {
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out << kIndexMagic << idx.size << idx.mtime << idx.frames << idx.fps << idx.keyframes;
+    return util::writeFileAtomic(indexPathFor(videoPath), bytes);
+}
+
+bool VideoSource::buildIndex(const QString& videoPath, SeekIndex& idx) {
+    const QFileInfo fi(videoPath);
+    idx       = {};
+    idx.size  = fi.size();
+    idx.mtime = fi.lastModified().toMSecsSinceEpoch();
+
+    cv::VideoCapture probe(videoPath.toStdString());
+    if (!probe.isOpened())
+        return false;
+    idx.fps              = probe.get(cv::CAP_PROP_FPS);
+    const int estimated  = int(probe.get(cv::CAP_PROP_FRAME_COUNT)); // 由时长估算，不一定准
+    probe.release();
+
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 6)
+    // 原始码流模式：grab() 只解复用不解码，逐包读出关键帧标记与精确帧数
+    cv::VideoCapture raw(videoPath.toStdString(), cv::CAP_FFMPEG, {cv::CAP_PROP_FORMAT, -1});
+    if (raw.isOpened()) {
+        int n = 0;
+        while (raw.grab()) {
+            if (raw.get(cv::CAP_PROP_LRF_HAS_KEY_FRAME) != 0)
+                idx.keyframes.push_back(n);
+            if (++n % kProgressStep == 0) {
+                emit indexProgress(n, std::max(n, estimated));
+                std::lock_guard lk(mu_);
+                if (stop_)
+                    return false;
+            }
+        }
+        idx.frames = n;
+        return n > 0;
+    }
+#endif
+    // 后端不支持原始码流：退化为估算帧数，seek 交给后端自己处理
+    idx.frames = estimated;
+    return estimated > 0;
+}
+
+// ---------- 打开 / 关闭 ----------
+void VideoSource::open(const QString& videoPath) {
+    close();
+    path_             = QFileInfo(videoPath).absoluteFilePath();
+    const quint64 gen = ++generation_;
+    {
+        std::lock_guard lk(mu_);
+        stop_   = false;
+        want_   = -1;
+        cursor_ = 0;
+        known_  = 0;
+        cache_.clear();
+    }
+    worker_ = std::thread([this, p = path_, gen] { run(p, gen); });
+}
+
+void VideoSource::close() {
+    ++generation_;
+    {
+        std::lock_guard lk(mu_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable())
+        worker_.join();
+    cap_.release();
+    std::lock_guard lk(mu_);
+    cache_.clear();
+    known_  = 0;
+    frames_ = 0;
+    fps_    = 0;
+    path_.clear();
+}
+
+void VideoSource::request(int frame) {
+    if (frame < 0 || frame >= frames_)
+        return;
+    QImage hit;
+    {
+        std::lock_guard lk(mu_);
+        cursor_ = frame;
+        if (const QImage* img = cache_.object(frame)) {
+            hit = *img;
+        } else {
+            want_ = frame;
+        }
+    }
+    cv_.notify_one(); // 命中时也唤醒：光标移动了，预取窗口跟着走
+    if (!hit.isNull())
+        emit frameReady(frame, hit);
+}
+
+// ---------- 工作线程 ----------
+void VideoSource::run(const QString& videoPath, quint64 gen) {
+    SeekIndex idx;
+    if (!loadIndex(videoPath, idx)) {
+        if (!buildIndex(videoPath, idx)) {
+            QMetaObject::invokeMethod(this, [this, videoPath, gen] {
+                if (gen == generation_)
+                    emit openFailed(videoPath, tr("无法读取视频"));
+            });
+            return;
+        }
+        if (!saveIndex(videoPath, idx))
+            LOGW(QString("视频索引写入失败：%1").arg(indexPathFor(videoPath)));
+        LOGI(QString("视频索引：%1，%2 帧，%3 个关键帧")
+                 .arg(videoPath)
+                 .arg(idx.frames)
+                 .arg(idx.keyframes.size()));
+    }
+    index_ = std::move(idx);
+
+    if (!cap_.open(videoPath.toStdString())) {
+        QMetaObject::invokeMethod(this, [this, videoPath, gen] {
+            if (gen == generation_)
+                emit openFailed(videoPath, tr("无法打开解码器"));
+        });
+        return;
+    }
+    decodePos_ = 0;
+    {
+        std::lock_guard lk(mu_);
+        known_ = index_.frames;
+    }
+    QMetaObject::invokeMethod(this, [this, videoPath, gen, frames = index_.frames, fps = index_.fps] {
+        if (gen != generation_)
+            return;
+        frames_ = frames;
+        fps_    = fps;
+        emit opened(videoPath, frames, fps);
+    });
+
+    for (;;) {
+        int target  = -1;
+        bool urgent = false;
+        {
+            std::unique_lock lk(mu_);
+            for (;;) {
+                if (stop_)
+                    return;
+                if (want_ >= 0) {
+                    target = std::exchange(want_, -1);
+                    urgent = true;
+                    break;
+                }
+                target = nextPrefetchLocked();
+                if (target >= 0)
+                    break;
+                cv_.wait(lk);
+            }
+        }
+        QImage img;
+        const bool ok = decode(target, img);
+        {
+            std::lock_guard lk(mu_);
+            if (ok)
+                cache_.insert(target, new QImage(img), int(img.sizeInBytes() >> 20) + 1);
+            else if (!urgent)
+                known_ = std::min(known_, target); // 估算帧数偏大时预取会撞到尾部：就此为止
+        }
+        if (urgent) {
+            QMetaObject::invokeMethod(this, [this, gen, target, img] {
+                if (gen == generation_)
+                    emit frameReady(target, img);
+            });
+        }
+    }
+}
+
+int VideoSource::nextPrefetchLocked() const {
+    for (int d = 1; d <= kPrefetchAhead; ++d) {
+        const int f = cursor_ + d;
+        if (f < known_ && !cache_.contains(f))
+            return f;
+    }
+    for (int d = 1; d <= kPrefetchBehind; ++d) {
+        const int f = cursor_ - d;
+        if (f >= 0 && !cache_.contains(f))
+            return f;
+    }
+    return -1;
+}
+
+int VideoSource::keyframeAtOrBefore(int frame) const {
+    const auto& k = index_.keyframes;
+    const auto it = std::upper_bound(k.cbegin(), k.cend(), frame);
+    return it == k.cbegin() ? -1 : *(it - 1);
+}
+
+bool VideoSource::decode(int frame, QImage& out) {
+    if (frame != decodePos_) {
+        const int key = keyframeAtOrBefore(frame);
+        // 目标在解码器前方且中间确知没有关键帧（或距离很近）：继续往后解，省掉一次 seek。
+        // 没有关键帧表时（旧 OpenCV / 后端不提供）key 为 -1，不能据此判断，只在近距离内顺序解
+        const bool sameGop = key >= 0 && key <= decodePos_;
+        const bool forward = frame > decodePos_ && (sameGop || frame - decodePos_ <= kMaxForwardGrab);
+        if (!forward) {
+            // 落在关键帧上 seek 最便宜；没有关键帧信息时交给后端（它自己回退到关键帧再解）
+            const int seekTo = key >= 0 ? key : frame;
+            if (!cap_.set(cv::CAP_PROP_POS_FRAMES, seekTo))
+                return false;
+            decodePos_ = seekTo;
+        }
+    }
+    while (decodePos_ < frame) {
+        if (!cap_.grab())
+            return false;
+        ++decodePos_;
+    }
+    cv::Mat m;
+    if (!cap_.read(m) || m.empty())
+        return false;
+    ++decodePos_;
+    out = matToQImage(m);
+    return !out.isNull();
+}
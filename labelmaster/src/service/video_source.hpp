@@ -0,0 +1,87 @@
+#pragma once
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <condition_variable>
+#include <mutex>
+#include <opencv2/videoio.hpp>
+#include <thread>
+
+// 视频数据源：直接把录像当数据集打开，不再先导出成 JPEG。
+// 打开时建一次寻址索引（关键帧 + 精确帧数，缓存在视频旁的隐藏文件里），
+// 之后由单个工作线程按需解码：顺序翻帧直接往后 grab，跨关键帧才 seek，并在光标附近预取。
+// 每一帧用虚拟路径 "<视频>#<帧号>" 表示，标注按帧号存成 ../label/<视频名>_<帧号>.txt
+class VideoSource : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int kPrefetchAhead  = 8;   // 光标后预取的帧数
+    static constexpr int kPrefetchBehind = 2;   // 回看也常见，少量预取
+    static constexpr int kCacheMiB       = 256; // 已解码帧的 LRU 上限
+
+    explicit VideoSource(QObject* parent = nullptr);
+    ~VideoSource() override;
+
+    static const QStringList& videoFilters(); // "*.mp4" 等
+    static bool isVideoFile(const QString& path);
+    static QString framePath(const QString& videoPath, int frame);
+    static bool parseFramePath(const QString& path, QString* videoPath = nullptr, int* frame = nullptr);
+    static QString frameLabelPath(const QString& videoPath, int frame);
+
+    bool isOpen() const { return frames_ > 0; }
+    const QString& path() const { return path_; }
+    int frameCount() const { return frames_; }
+    double fps() const { return fps_; }
+
+public slots:
+    void open(const QString& videoPath); // 后台建/读索引，完成后发 opened()
+    void close();
+    void request(int frame);             // 命中缓存立即发 frameReady，否则排给工作线程
+
+signals:
+    void opened(const QString& videoPath, int frames, double fps);
+    void openFailed(const QString& videoPath, const QString& reason);
+    void indexProgress(int done, int total); // 首次建索引（只解复用、不解码）
+    void frameReady(int frame, const QImage& img); // img 为空表示解码失败
+
+private:
+    struct SeekIndex {
+        qint64 size  = 0;
+        qint64 mtime = 0;
+        int frames   = 0;
+        double fps   = 0;
+        QVector<int> keyframes; // 升序帧号
+    };
+    static QString indexPathFor(const QString& videoPath);
+    static bool loadIndex(const QString& videoPath, SeekIndex& idx);
+    static bool saveIndex(const QString& videoPath, const SeekIndex& idx);
+    bool buildIndex(const QString& videoPath, SeekIndex& idx); // 工作线程
+
+    void run(const QString& videoPath, quint64 gen); // 工作线程主循环
+    bool decode(int frame, QImage& out);             // 工作线程：只有它碰 cap_
+    int keyframeAtOrBefore(int frame) const;
+    int nextPrefetchLocked() const;
+
+    QString path_;
+    int frames_  = 0;
+    double fps_  = 0;
+    quint64 generation_ = 0; // GUI 线程：open/close 递增，旧视频的结果作废
+
+    // 工作线程状态
+    cv::VideoCapture cap_;
+    SeekIndex index_;
+    int decodePos_ = 0; // 解码器下一次 read() 会吐出的帧号
+
+    // 共享状态（mu_ 保护）
+    std::mutex mu_;
+    std::condition_variable cv_;
+    QCache<int, QImage> cache_;
+    int cursor_ = 0;    // 最近一次请求的帧：预取围绕它
+    int want_   = -1;   // 等待解码的请求帧
+    int known_  = 0;    // 工作线程已知的帧数（索引完成前为 0）
+    bool stop_  = false;
+    std::thread worker_;
+};
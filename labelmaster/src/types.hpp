@@ -1,20 +1,118 @@
 #pragma once
 #include <QString>
+#include <QLatin1String>
 #include <QMetaType>
 #include <QPointF>
+#include <QStringView>
 #include <QVector>
 
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+// 界面与检测器之间传递的标注：颜色 / 类别是字符串，供 UI 显示与编辑
 struct Armor {
     QString cls;
     QString color;
     float score = 0.f;
     // 角点顺序：从 0 开始逆时针：TL(0) → BL(1) → BR(2) → TR(3)，全为“原图坐标”
     QPointF p0, p1, p2, p3;
-    QPointF norm_p0, norm_p1, norm_p2, norm_p3;
 };
 
+// 颜色 / 类别编号，与标注文件中的整数一致
+enum class ColorId : std::uint8_t { Blue = 0, Red = 1, Gray = 2, Purple = 3 };
+enum class ClassId : std::uint8_t { G = 0, N1 = 1, N2 = 2, N3 = 3, N4 = 4, O = 5, Bs = 6, Bb = 7 };
+inline constexpr int kColorCount = 4; // B R G P
+inline constexpr int kClassCount = 8; // G 1 2 3 4 O Bs Bb
+
+// 批量处理（读盘、统计、导出）用的紧凑标注：无堆内存、可平凡拷贝，40 字节一条。
+// 角点顺序同 Armor，原图坐标：x0 y0 x1 y1 x2 y2 x3 y3
+struct Plate {
+    ColorId color = ColorId::Gray;
+    ClassId cls   = ClassId::G;
+    float score   = 0.f;
+    float pts[8]  = {};
+
+    int classIndex() const { return int(color) * kClassCount + int(cls); } // 训练侧编号 0..31
+    float area() const {                                                   // 鞋带公式
+        float a2 = 0;
+        for (int i = 0; i < 4; ++i) {
+            const int j = (i + 1) % 4;
+            a2 += pts[2 * i] * pts[2 * j + 1] - pts[2 * j] * pts[2 * i + 1];
+        }
+        return std::abs(a2) / 2;
+    }
+};
+static_assert(std::is_trivially_copyable_v<Plate> && sizeof(Plate) == 40);
+
+// ---------- 编号 ↔ 文本（仅在 UI / 文件边界使用） ----------
+inline ColorId toColorId(int id) { return id >= 0 && id < kColorCount ? ColorId(id) : ColorId::Gray; }
+inline ClassId toClassId(int id) { return id >= 0 && id < kClassCount ? ClassId(id) : ClassId::G; }
+
+// "B" / "BLUE" / "b" … → 编号，按首字母判定，未知为 GRAY
+template <class View> ColorId parseColorId(View token) {
+    token = token.trimmed();
+    if (token.isEmpty())
+        return ColorId::Gray;
+    switch (QChar(token.front()).toUpper().unicode()) {
+    case 'B': return ColorId::Blue;
+    case 'R': return ColorId::Red;
+    case 'P': return ColorId::Purple;
+    default: return ColorId::Gray;
+    }
+}
+inline ColorId parseColorId(const QString& token) { return parseColorId(QStringView(token)); }
+
+// "1|2|3|4|G|O|Bs|Bb"（不分大小写）→ 编号，未知为 G
+template <class View> ClassId parseClassId(View token) {
+    token = token.trimmed();
+    if (token.size() == 1) {
+        const char16_t c = QChar(token.front()).toUpper().unicode();
+        if (c >= '1' && c <= '4')
+            return ClassId(c - '0');
+        return c == 'O' ? ClassId::O : ClassId::G;
+    }
+    if (token.compare(QLatin1String("BS"), Qt::CaseInsensitive) == 0)
+        return ClassId::Bs;
+    if (token.compare(QLatin1String("BB"), Qt::CaseInsensitive) == 0)
+        return ClassId::Bb;
+    return ClassId::G;
+}
+inline ClassId parseClassId(const QString& token) { return parseClassId(QStringView(token)); }
+
+inline QString colorLetter(ColorId c) {
+    static const QString kLetters[kColorCount] = {"B", "R", "G", "P"};
+    return kLetters[int(c)]; // 共享数据，不分配
+}
+inline QString classToken(ClassId c) {
+    static const QString kTokens[kClassCount] = {"G", "1", "2", "3", "4", "O", "Bs", "Bb"};
+    return kTokens[int(c)];
+}
 
+inline Plate toPlate(const Armor& a) {
+    Plate p;
+    p.color = parseColorId(a.color);
+    p.cls   = parseClassId(a.cls);
+    p.score = a.score;
+    int k   = 0;
+    for (const QPointF* q : {&a.p0, &a.p1, &a.p2, &a.p3}) {
+        p.pts[k++] = float(q->x());
+        p.pts[k++] = float(q->y());
+    }
+    return p;
+}
 
+inline Armor toArmor(const Plate& p) {
+    Armor a;
+    a.color = colorLetter(p.color);
+    a.cls   = classToken(p.cls);
+    a.score = p.score;
+    a.p0    = {p.pts[0], p.pts[1]};
+    a.p1    = {p.pts[2], p.pts[3]};
+    a.p2    = {p.pts[4], p.pts[5]};
+    a.p3    = {p.pts[6], p.pts[7]};
+    return a;
+}
 
 Q_DECLARE_METATYPE(Armor)
 Q_DECLARE_METATYPE(QVector<Armor>)
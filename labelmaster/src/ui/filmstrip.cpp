@@ -0,0 +1,214 @@
+#include "ui/filmstrip.hpp"
+#include "service/dataset_index.hpp"
+#include "service/file.hpp"
+#include "service/thumbnail_cache.hpp"
+
+#include <QFileInfo>
+#include <QPainter>
+#include <QScrollBar>
+#include <QStyledItemDelegate>
+
+#include <algorithm>
+
+using namespace ui;
+
+namespace {
+constexpr int kMemoryCacheKiB = 64 * 1024;     // 内存里最多留 64 MiB 缩略图
+constexpr QSize kCellSize{128, 100};
+constexpr int kDotRadius      = 5;
+
+// 缩略图 + 右上角标注状态圆点；没有缩略图时画占位底色，不触发任何解码
+class FilmstripDelegate : public QStyledItemDelegate {
+public:
+    using QStyledItemDelegate::QStyledItemDelegate;
+
+    QSize sizeHint(const QStyleOptionViewItem&, const QModelIndex&) const override {
+        return kCellSize;
+    }
+
+    void paint(QPainter* p, const QStyleOptionViewItem& opt, const QModelIndex& index) const override {
+        p->save();
+        const QRect cell = opt.rect.adjusted(2, 2, -2, -2);
+        if (opt.state & QStyle::State_Selected)
+            p->fillRect(opt.rect, opt.palette.highlight());
+
+        const QImage thumb = index.data(Qt::DecorationRole).value<QImage>();
+        if (thumb.isNull()) {
+            p->fillRect(cell, opt.palette.mid());
+        } else {
+            const QSize fit = thumb.size().scaled(cell.size(), Qt::KeepAspectRatio);
+            QRect target(QPoint(0, 0), fit);
+            target.moveCenter(cell.center());
+            p->drawImage(target, thumb);
+        }
+
+        QColor dot;
+        switch (index.data(FilmstripModel::LabelStatusRole).toInt()) {
+        case FilmstripModel::Labeled: dot = QColor(60, 200, 90); break;
+        case FilmstripModel::Empty: dot = QColor(230, 190, 40); break;
+        default: dot = QColor(220, 60, 60); break;
+        }
+        p->setRenderHint(QPainter::Antialiasing);
+        p->setPen(QPen(Qt::black, 1));
+        p->setBrush(dot);
+        p->drawEllipse(
+            QPoint(cell.right() - kDotRadius - 2, cell.top() + kDotRadius + 2), kDotRadius,
+            kDotRadius);
+        p->restore();
+    }
+};
+} // namespace
+
+// ---------- 模型 ----------
+FilmstripModel::FilmstripModel(ThumbnailCache* cache, QObject* parent)
+    : QAbstractListModel(parent)
+    , cache_(cache) {
+    thumbs_.setMaxCost(kMemoryCacheKiB);
+    if (cache_)
+        connect(cache_, &ThumbnailCache::thumbnailReady, this, &FilmstripModel::onThumbnail);
+}
+
+int FilmstripModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : int(paths_.size());
+}
+
+int FilmstripModel::rowOf(const QString& imagePath) const {
+    const auto it = std::lower_bound(paths_.cbegin(), paths_.cend(), imagePath);
+    return it != paths_.cend() && *it == imagePath ? int(it - paths_.cbegin()) : -1;
+}
+
+int FilmstripModel::labelStatusOf(const QString& imagePath) {
+    const QFileInfo fi(FileService::labelFileForImage(imagePath));
+    if (!fi.exists())
+        return Unlabeled;
+    return fi.size() > 0 ? Labeled : Empty;
+}
+
+QVariant FilmstripModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= paths_.size())
+        return {};
+    const QString& path = paths_.at(index.row());
+    switch (role) {
+    case PathRole: return path;
+    case Qt::ToolTipRole: return QFileInfo(path).fileName();
+    case Qt::DecorationRole:
+        if (const QImage* img = thumbs_.object(path))
+            return *img;
+        if (cache_ && !failed_.contains(path))
+            cache_->request(path); // 视图只为可见行取数据，这里就是“按可见优先”
+        return {};
+    case LabelStatusRole: {
+        auto it = status_.constFind(path);
+        if (it == status_.constEnd())
+            it = status_.insert(path, qint8(labelStatusOf(path)));
+        return int(*it);
+    }
+    default: return {};
+    }
+}
+
+void FilmstripModel::resetFrom(const DatasetIndex& index) {
+    beginResetModel();
+    paths_.clear();
+    paths_.reserve(index.size());
+    for (const auto& e : index.entries())
+        paths_.push_back(e.imagePath);
+    thumbs_.clear();
+    status_.clear();
+    failed_.clear();
+    endResetModel();
+}
+
+void FilmstripModel::applyChanges(const QStringList& added, const QStringList& removed) {
+    for (const QString& p : removed) {
+        const int row = rowOf(p);
+        if (row < 0)
+            continue;
+        beginRemoveRows({}, row, row);
+        paths_.removeAt(row);
+        thumbs_.remove(p);
+        status_.remove(p);
+        failed_.remove(p);
+        endRemoveRows();
+    }
+    for (const QString& p : added) {
+        thumbs_.remove(p); // 覆盖写的图片内容变了，缩略图重新取
+        status_.remove(p);
+        failed_.remove(p);
+        const auto it = std::lower_bound(paths_.cbegin(), paths_.cend(), p);
+        const int row = int(it - paths_.cbegin());
+        if (it != paths_.cend() && *it == p) {
+            emit dataChanged(index(row), index(row));
+            continue;
+        }
+        beginInsertRows({}, row, row);
+        paths_.insert(row, p);
+        endInsertRows();
+    }
+}
+
+void FilmstripModel::setLabelStatus(const QString& imagePath, bool labeled) {
+    const int row = rowOf(imagePath);
+    if (row < 0)
+        return;
+    status_.insert(imagePath, qint8(labeled ? Labeled : Empty));
+    emit dataChanged(index(row), index(row), {LabelStatusRole});
+}
+
+void FilmstripModel::cancelPending() {
+    if (cache_)
+        cache_->cancelPending();
+}
+
+void FilmstripModel::onThumbnail(const QString& imagePath, const QImage& thumb) {
+    if (thumb.isNull())
+        failed_.insert(imagePath);
+    else
+        thumbs_.insert(imagePath, new QImage(thumb), std::max<qsizetype>(1, thumb.sizeInBytes() / 1024));
+    const int row = rowOf(imagePath);
+    if (row >= 0)
+        emit dataChanged(index(row), index(row), {Qt::DecorationRole});
+}
+
+// ---------- 视图 ----------
+Filmstrip::Filmstrip(QWidget* parent)
+    : QListView(parent) {
+    setViewMode(QListView::IconMode);
+    setFlow(QListView::LeftToRight);
+    setWrapping(false); // IconMode 默认换行，胶片条只要一行
+    setMovement(QListView::Static);
+    setUniformItemSizes(true);
+    setLayoutMode(QListView::Batched);
+    setBatchSize(512);
+    setSpacing(2);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+    setHorizontalScrollMode(QAbstractItemView::ScrollPerPixel);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setItemDelegate(new FilmstripDelegate(this));
+
+    connect(this, &QListView::clicked, this, [this](const QModelIndex& idx) {
+        if (idx.isValid())
+            emit imageActivated(idx.data(FilmstripModel::PathRole).toString());
+    });
+    // 快速拖动：之前排队的请求已滚出视野，清掉后由新的可见行重新请求
+    connect(horizontalScrollBar(), &QScrollBar::valueChanged, this, [this] {
+        if (model_)
+            model_->cancelPending();
+    });
+}
+
+void Filmstrip::setFilmstripModel(FilmstripModel* model) {
+    model_ = model;
+    setModel(model);
+}
+
+void Filmstrip::setCurrentPath(const QString& imagePath) {
+    if (!model_)
+        return;
+    const int row = model_->rowOf(imagePath);
+    if (row < 0)
+        return;
+    const QModelIndex idx = model_->index(row);
+    setCurrentIndex(idx);
+    scrollTo(idx, QAbstractItemView::PositionAtCenter);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <QAbstractListModel>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QListView>
+#include <QSet>
+#include <QStringList>
+
+class DatasetIndex;
+class ThumbnailCache;
+
+namespace ui {
+
+// 胶片条模型：行就是 DatasetIndex 的图片（有序），随 indexChanged 增量增删。
+// 只有视图真正取 data() 的行（即可见行）才会去请求缩略图 / 检查标注状态
+class FilmstripModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    enum Roles { PathRole = Qt::UserRole + 1, LabelStatusRole };
+    enum LabelStatus { Unlabeled = 0, Labeled = 1, Empty = 2 }; // Empty：有标注文件但没有装甲板
+
+    explicit FilmstripModel(ThumbnailCache* cache, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = {}) const override;
+    QVariant data(const QModelIndex& index, int role) const override;
+    int rowOf(const QString& imagePath) const; // 不存在返回 -1
+
+public slots:
+    void resetFrom(const DatasetIndex& index);
+    void applyChanges(const QStringList& added, const QStringList& removed);
+    void setLabelStatus(const QString& imagePath, bool labeled);
+    void cancelPending(); // 快速滚动：丢掉已滚出视野的排队请求
+
+private slots:
+    void onThumbnail(const QString& imagePath, const QImage& thumb);
+
+private:
+    static int labelStatusOf(const QString& imagePath);
+
+    ThumbnailCache* cache_ = nullptr;
+    QStringList paths_;                                 // 有序，与 DatasetIndex 一致
+    mutable QCache<QString, QImage> thumbs_;            // 内存 LRU，代价按 KiB 计
+    mutable QHash<QString, qint8> status_;              // 懒惰计算的标注状态
+    QSet<QString> failed_;                              // 解码失败的图片不再重试
+};
+
+// 胶片条视图：横向单行图标模式，固定项尺寸 + 分批布局，十万张也只布局可见部分
+class Filmstrip : public QListView {
+    Q_OBJECT
+public:
+    explicit Filmstrip(QWidget* parent = nullptr);
+    void setFilmstripModel(FilmstripModel* model);
+
+public slots:
+    void setCurrentPath(const QString& imagePath); // 跟随 FileService 的当前图片
+
+signals:
+    void imageActivated(const QString& imagePath);
+
+private:
+    FilmstripModel* model_ = nullptr;
+};
+
+} // namespace ui
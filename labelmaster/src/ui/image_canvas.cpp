@@ -2,8 +2,13 @@
 #include "../util/bridge.hpp"
 #include "controller/settings.hpp"
 #include "info_dialog.h"
+#include "logger/core.hpp"
 #include "mainwindow.hpp"
+#include "service/tiled_image.hpp"
+#include "util/image_adjust.hpp"
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QFontMetrics>
 #include <QFile>
 #include <QInputDialog>
 #include <QJsonArray>
@@ -20,6 +25,7 @@
 #include <QtMath>
 #include <algorithm>
 #include <array>
+#include <cmath>
 #include <opencv2/core.hpp>
 #include <opencv2/core/mat.hpp>
 #include <opencv2/imgproc.hpp>
@@ -41,6 +47,7 @@
 #include <qtmetamacros.h>
 #include <qvariant.h>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 // ---------- JSON 工具 ----------
@@ -81,6 +88,15 @@ ImageCanvas::ImageCanvas(QWidget* parent)
 
     qRegisterMetaType<Armor>("ImageCanvas::Armor");
     qRegisterMetaType<QVector<Armor>>("QVector<ImageCanvas::Armor>");
+    qRegisterMetaType<Frame>("Frame");
+    adjustPool_.setMaxThreadCount(1);
+    perfLog_ = controller::AppSettings::instance().perfLog();
+}
+
+ImageCanvas::~ImageCanvas() {
+    ++adjustGen_;
+    adjustPool_.clear();
+    adjustPool_.waitForDone();
 }
 
 /* ===== 图像 & 视图 ===== */
@@ -89,14 +105,58 @@ bool ImageCanvas::loadImage(const QString& path) {
     QImage tmp(path);
     if (tmp.isNull())
         return false;
-    setImage(tmp);
-    imgPath_ = path;
+    setFrame(Frame(tmp, path));
+    return true;
+}
+
+void ImageCanvas::setImage(const QImage& img) { setFrame(Frame(img)); }
+
+void ImageCanvas::setFrame(const Frame& frame) {
+    tiled_.reset();
+    adoptFrame(frame, false);
+}
+
+void ImageCanvas::setPreviewFrame(const Frame& preview) {
+    tiled_.reset();
+    adoptFrame(preview, true);
+}
+
+void ImageCanvas::setTiledFrame(const Frame& overview) {
+    tiled_ = std::make_unique<TiledImage>(overview.path(), overview.fullSize());
+    connect(tiled_.get(), &TiledImage::tileReady, this, qOverload<>(&QWidget::update));
+    adoptFrame(overview, false);
+}
+
+void ImageCanvas::adoptFrame(const Frame& frame, bool preview) {
+    frame_       = frame;
+    img_         = frame.image(); // 与 frame_ 共享像素，不复制
+    imgSize_     = frame.fullSize();
+    previewOnly_ = preview;
+    imgPath_     = frame.path();
+    resetImageState();
+}
+
+bool ImageCanvas::upgradeFrame(const Frame& full) {
+    if (!previewOnly_ || full.size() != imgSize_)
+        return false; // 已切到别的图，或尺寸对不上
+    frame_       = full;
+    img_         = full.image();
+    previewOnly_ = false;
+    if (histEqOn_)
+        refreshAdjustments(); // 原图结果出来前继续显示调整过的预览
+    if (std::exchange(detectPending_, false))
+        requestDetect();
+    update();
     return true;
 }
 
-void ImageCanvas::setImage(const QImage& img) {
-    raw_img = img_ = img;
-    imgPath_.clear();
+void ImageCanvas::resetImageState() {
+    detectPending_ = false;
+    histEqOn_      = false;
+    ++adjustGen_;
+    adjusted_      = Frame();
+    adjustPreview_ = QImage();
+    masks_.clear();
 
     // 切图即清空标注
     clearDetections();
@@ -107,8 +167,8 @@ void ImageCanvas::setImage(const QImage& img) {
     hoverHandle_   = -1;
     dragRectImg_   = QRect();
 
-    if (!img_.isNull() && modelInputSize_.isValid() && modelInputSize_ == img_.size()) {
-        roiImg_ = QRect(QPoint(0, 0), img_.size());
+    if (!img_.isNull() && modelInputSize_.isValid() && modelInputSize_ == imgSize_) {
+        roiImg_ = QRect(QPoint(0, 0), imgSize_);
         emit roiChanged(roiImg_);
         emit roiCommitted(roiImg_);
     } else {
@@ -120,8 +180,8 @@ void ImageCanvas::setImage(const QImage& img) {
 
 void ImageCanvas::setModelInputSize(const QSize& s) {
     modelInputSize_ = s.isValid() ? s : QSize();
-    if (!img_.isNull() && modelInputSize_.isValid() && modelInputSize_ == img_.size()) {
-        roiImg_ = QRect(QPoint(0, 0), img_.size());
+    if (!img_.isNull() && modelInputSize_.isValid() && modelInputSize_ == imgSize_) {
+        roiImg_ = QRect(QPoint(0, 0), imgSize_);
         emit roiChanged(roiImg_);
         emit roiCommitted(roiImg_);
         update();
@@ -142,10 +202,36 @@ void ImageCanvas::clearRoi() {
     update();
 }
 
-QImage ImageCanvas::cropRoi() const {
-    if (img_.isNull() || roiImg_.isNull())
+Frame ImageCanvas::cropRoi() const {
+    if (img_.isNull() || previewOnly_ || roiImg_.isNull())
         return {};
-    return img_.copy(clampRectToImage(roiImg_));
+    const QRect r = clampRectToImage(roiImg_);
+    // 普通图：共享缓冲区的子帧；分块模式：只解码 ROI 这一块原图
+    const Frame crop = tiled_ ? Frame(tiled_->region(r), imgPath_) : detectSource().cropped(r);
+    return withMasks(crop, r.topLeft());
+}
+
+const Frame& ImageCanvas::detectSource() const {
+    // 与屏幕上看到的一致：开着调整时用调整结果
+    if (!adjusted_.isNull() && img_.cacheKey() == adjusted_.image().cacheKey())
+        return adjusted_;
+    return frame_;
+}
+
+Frame ImageCanvas::withMasks(const Frame& f, const QPoint& origin) const {
+    const QRect area(origin, f.size());
+    QVector<QRect> hits;
+    for (const QRect& m : masks_)
+        if (m.intersects(area))
+            hits.push_back(m.translated(-origin));
+    if (hits.isEmpty())
+        return f; // 没有 Mask 落在里面：原样共享
+    QImage img = f.image().copy();
+    QPainter p(&img);
+    for (const QRect& m : hits)
+        p.fillRect(m, Qt::black);
+    p.end();
+    return Frame(img, f.path());
 }
 
 void ImageCanvas::resetView() {
@@ -156,17 +242,25 @@ void ImageCanvas::resetView() {
 
 /* ===== 检测请求 ===== */
 void ImageCanvas::requestDetect() {
-    const QImage crop = cropRoi();
+    if (previewOnly_) {
+        detectPending_ = true; // 检测必须在原图上做，等升级后再发
+        return;
+    }
+    const Frame crop = cropRoi();
     if (!crop.isNull())
         emit detectRequested(crop);
-    else
-        emit detectRequested(img_);
+    else if (tiled_) {
+        LOGW("超大图检测：未框选 ROI");
+        emit status(tr("超大图请先框选 ROI 再检测"), 3000); // 概览分辨率不够，整图又太大
+    } else
+        emit detectRequested(withMasks(detectSource(), {0, 0}));
 }
 
 /* ===== 外部读写 ===== */
 void ImageCanvas::setDetections(const QVector<Armor>& dets) {
     qDebug() << "setDetections: " << dets.size();
     dets_ = dets;
+    invalidateHitIndex();
     if (dets_.isEmpty()) {
         qDebug() << "setDetections: empty";
         selectedIndex_ = -1;
@@ -179,8 +273,18 @@ void ImageCanvas::setDetections(const QVector<Armor>& dets) {
     emit detectionSelected(selectedIndex_);
     update();
 }
+void ImageCanvas::applyDetections(const QVector<Armor>& dets) {
+    setDetections(dets);
+    notifyEdited();
+}
+void ImageCanvas::applyDetectionsFor(const QVector<Armor>& dets, const QString& imagePath) {
+    if (!imagePath.isEmpty() && imagePath != imgPath_)
+        return; // 已切到别的图片，过期的检测结果直接丢弃
+    applyDetections(dets);
+}
 void ImageCanvas::clearDetections() {
     dets_.clear();
+    invalidateHitIndex();
     selectedIndex_ = -1;
     hoverIndex_    = -1;
     emit detectionSelected(-1);
@@ -190,21 +294,26 @@ void ImageCanvas::clearDetections() {
 void ImageCanvas::addDetection(const Armor& a0) {
     Armor a = a0;
     dets_.append(a);
+    invalidateHitIndex();
     const int idx = dets_.size() - 1;
     emit detectionUpdated(idx, dets_.back());
+    notifyEdited();
     update();
 }
 void ImageCanvas::updateDetection(int index, const Armor& a0) {
     if (index < 0 || index >= dets_.size())
         return;
     dets_[index] = a0;
+    invalidateHitIndex();
     emit detectionUpdated(index, dets_[index]);
+    notifyEdited();
     update();
 }
 void ImageCanvas::removeDetection(int index) {
     if (index < 0 || index >= dets_.size())
         return;
     dets_.removeAt(index);
+    invalidateHitIndex();
     emit detectionRemoved(index);
 
     if (dets_.isEmpty()) {
@@ -223,6 +332,7 @@ void ImageCanvas::removeDetection(int index) {
     }
     emit detectionSelected(selectedIndex_);
     emit detectionHovered(hoverIndex_);
+    notifyEdited();
     update();
 }
 
@@ -240,6 +350,7 @@ bool ImageCanvas::setSelectedClass(const QString& cls) {
         return false;
     dets_[selectedIndex_].cls = cls.isEmpty() ? QStringLiteral("unknown") : cls;
     emit detectionUpdated(selectedIndex_, dets_[selectedIndex_]);
+    notifyEdited();
     update();
     return true;
 }
@@ -249,6 +360,7 @@ bool ImageCanvas::setSelectedInfo(const QString& cls, const QString& color) {
     dets_[selectedIndex_].color = color.isEmpty() ? "Gray" : color;
     dets_[selectedIndex_].cls   = cls.isEmpty() ? QStringLiteral("unknown") : cls;
     emit detectionUpdated(selectedIndex_, dets_[selectedIndex_]);
+    notifyEdited();
     update();
     return true;
 }
@@ -256,7 +368,10 @@ bool ImageCanvas::setSelectedInfo(const QString& cls, const QString& color) {
 /* ===== 导入/导出 ===== */
 
 /* ===== 绘制 ===== */
-void ImageCanvas::paintEvent(QPaintEvent*) {
+void ImageCanvas::paintEvent(QPaintEvent* e) {
+    QElapsedTimer timer;
+    timer.start();
+    paintRegion_ = e->region();
     QPainter p(this);
     p.fillRect(rect(), Qt::black);
     if (img_.isNull())
@@ -264,13 +379,94 @@ void ImageCanvas::paintEvent(QPaintEvent*) {
 
     const QRectF R = imageRectOnWidget();
     p.setRenderHint(QPainter::SmoothPixmapTransform, true);
-    p.drawImage(R, img_);
+    if (tiled_)
+        drawTiles(p, R);
+    else
+        drawZoomed(p, R);
+    drawMasks(p);
 
     drawDetections(p);
     drawRoi(p);
     drawSvg(p, dets_);
     drawDragRect(p);                      // <<< 新增：拖框时的虚线矩形
     drawCrosshair(p);                     // 十字准心
+
+    const qint64 ns = timer.nsecsElapsed();
+    auto& st        = paintStats_;
+    ++st.frames;
+    st.totalNs += ns;
+    st.maxNs = std::max(st.maxNs, ns);
+    if (perfLog_ && st.frames >= kPaintStatsWindow) {
+        qDebug().noquote() << QString("paint: %1 次，平均 %2 ms，最大 %3 ms，缓存重建 %4 次")
+                                  .arg(st.frames)
+                                  .arg(st.totalNs / 1e6 / st.frames, 0, 'f', 2)
+                                  .arg(st.maxNs / 1e6, 0, 'f', 2)
+                                  .arg(st.rebuilds);
+        st = {};
+    }
+}
+
+void ImageCanvas::drawZoomed(QPainter& p, const QRectF& R) {
+    const double dpr    = devicePixelRatioF();
+    const QPoint origin = (R.topLeft() * dpr).toPoint(); // 对齐到物理像素，贴图时不再重采样
+    const QSize scaled  = (R.size() * dpr).toSize();
+    if (scaled.isEmpty())
+        return;
+    const QRect whole(QPoint(0, 0), scaled);
+    const QSize vp      = (QSizeF(size()) * dpr).toSize();
+    const QRect visible = QRect(-origin, vp).intersected(whole);
+    if (visible.isEmpty())
+        return;
+
+    // 只有缩放、窗口尺寸、像素变化或平移出缓存窗口才重建；其余重绘（平移、准心、悬停）都是一次贴图
+    const QImage& shown = shownImage();
+    if (zoomCache_.isNull() || zoomCacheKey_ != shown.cacheKey() || zoomCacheScaled_ != scaled
+        || !zoomCacheWindow_.contains(visible)) {
+        // 放大很多时整图缩放后的位图会极大：只缓存视野外扩一屏的窗口
+        const QRect window =
+            visible.adjusted(-vp.width(), -vp.height(), vp.width(), vp.height()).intersected(whole);
+        zoomCache_       = renderZoomWindow(scaled, window);
+        zoomCacheKey_    = shown.cacheKey();
+        zoomCacheScaled_ = scaled;
+        zoomCacheWindow_ = window;
+        ++paintStats_.rebuilds;
+    }
+    p.drawPixmap(QPointF(origin + zoomCacheWindow_.topLeft()) / dpr, zoomCache_);
+}
+
+QPixmap ImageCanvas::renderZoomWindow(const QSize& scaled, const QRect& window) {
+    const QImage& src = mipFor(double(scaled.width()) / shownImage().width());
+    QImage out(window.size(), QImage::Format_RGB32);
+    out.fill(Qt::black);
+    QPainter q(&out);
+    q.setRenderHint(QPainter::SmoothPixmapTransform, true);
+    // 目标矩形是整图，画家按设备裁剪：只有窗口内的像素会被重采样
+    q.drawImage(QRectF(-window.x(), -window.y(), scaled.width(), scaled.height()), src);
+    q.end();
+    QPixmap pm = QPixmap::fromImage(std::move(out));
+    pm.setDevicePixelRatio(devicePixelRatioF());
+    return pm;
+}
+
+const QImage& ImageCanvas::mipFor(double factor) {
+    const QImage& base = shownImage();
+    if (mipKey_ != base.cacheKey()) {
+        mips_.clear();
+        mipKey_ = base.cacheKey();
+    }
+    // 双线性只看 2×2 邻域，一步缩小到一半以下会走样：从最接近的 1/2^k 层取样
+    const QImage* best = &base;
+    for (int level = 0; factor < 0.5; ++level, factor *= 2) {
+        if (level == mips_.size()) {
+            const QImage& prev = level == 0 ? base : mips_[level - 1];
+            if (prev.width() < 2 || prev.height() < 2)
+                break;
+            QImage half = prev.scaled(prev.size() / 2, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            mips_.push_back(std::move(half));
+        }
+        best = &mips_[level];
+    }
+    return *best;
 }
 
 void ImageCanvas::drawDragRect(QPainter& p) const {
@@ -290,18 +486,58 @@ void ImageCanvas::drawDragRect(QPainter& p) const {
     p.drawRect(rw);
     p.restore();
 }
+void ImageCanvas::drawTiles(QPainter& p, const QRectF& R) {
+    // 概览兜底：块还没解出来的地方也不会是黑的
+    drawZoomed(p, R);
+    const double dpr = devicePixelRatioF();
+    if (img_.width() >= R.width() * dpr)
+        return; // 概览的分辨率已经够用
+    const QRectF vis = R.intersected(QRectF(rect()));
+    if (vis.isEmpty())
+        return;
+
+    const int level = tiled_->levelFor(R.width() * dpr / imgSize_.width());
+    const int d     = 1 << level;
+    const int span  = TiledImage::kTileSize * d; // 一块覆盖的原图像素
+    const QPointF a = widgetToImage(vis.topLeft()), b = widgetToImage(vis.bottomRight());
+    const int tx0 = int(a.x()) / span, ty0 = int(a.y()) / span;
+    const int tx1 = int(b.x()) / span, ty1 = int(b.y()) / span;
+
+    // 从视野中心向外请求：先出来的是用户正盯着的地方
+    QVector<QPoint> order;
+    for (int ty = ty0; ty <= ty1; ++ty)
+        for (int tx = tx0; tx <= tx1; ++tx)
+            order.push_back({tx, ty});
+    const QPointF c((tx0 + tx1) / 2.0, (ty0 + ty1) / 2.0);
+    std::sort(order.begin(), order.end(), [&c](const QPoint& u, const QPoint& v) {
+        return std::hypot(u.x() - c.x(), u.y() - c.y()) < std::hypot(v.x() - c.x(), v.y() - c.y());
+    });
+
+    tiled_->cancelPending(); // 上一帧视野里排队的块已经不需要了
+    const double sx = R.width() / imgSize_.width(), sy = R.height() / imgSize_.height();
+    for (const QPoint& t : order) {
+        QImage tile;
+        if (!tiled_->tile(level, t.x(), t.y(), tile))
+            continue;
+        const QRect lr = tiled_->tileRect(level, t.x(), t.y());
+        p.drawImage(
+            QRectF(R.x() + lr.x() * d * sx, R.y() + lr.y() * d * sy, lr.width() * d * sx,
+                   lr.height() * d * sy),
+            tile);
+    }
+}
+
+void ImageCanvas::drawMasks(QPainter& p) const {
+    for (const QRect& m : masks_)
+        p.fillRect(
+            QRectF(imageToWidget(m.topLeft()), imageToWidget(m.bottomRight() + QPoint(1, 1))),
+            Qt::black);
+}
+
 void ImageCanvas::drawMask(const QRect& rect) {
-    QPainter p;
-    p.begin(&img_);
-    QPen pen;
-    pen.setColor(QColorConstants::Black);
-    pen.setWidth(1);
-    p.setPen(pen);
-    QBrush brush;
-    brush.setColor(QColorConstants::Black);
-    brush.setStyle(Qt::SolidPattern);
-    p.setBrush(brush);
-    p.drawRect(rect);
+    // 只记原图坐标：绘制时叠加、送检时才落到像素上，解码出来的帧保持不变
+    masks_.push_back(rect);
+    update();
 }
 
 void ImageCanvas::drawDetections(QPainter& p) const {
@@ -326,11 +562,15 @@ void ImageCanvas::drawDetections(QPainter& p) const {
         return QColor(0, 200, 255);
     };
 
+    QFont f = p.font();
+    f.setPointSizeF(f.pointSizeF() + 1);
+    p.setFont(f);
+
     for (int i = 0; i < dets_.size(); ++i) {
-        const auto& d = dets_[i];
-        QPolygonF poly;
-        poly << imageToWidget(d.p0) << imageToWidget(d.p1) << imageToWidget(d.p2)
-             << imageToWidget(d.p3);
+        const auto& d        = dets_[i];
+        const QPolygonF& poly = polyW(i);
+        if (!paintRegion_.intersects(detectionDamageW(i)))
+            continue; // 不在脏区内：局部重绘时跳过
 
         const bool isSel   = (i == selectedIndex_);
         const bool isHover = (i == hoverIndex_);
@@ -356,9 +596,6 @@ void ImageCanvas::drawDetections(QPainter& p) const {
         // 文本（描边 + 主色）
         const QPointF tl   = poly.boundingRect().topLeft();
         const QString text = QString("%1%2").arg(d.color).arg(d.cls);
-        QFont f            = p.font();
-        f.setPointSizeF(f.pointSizeF() + 1);
-        p.setFont(f);
         p.setPen(QPen(Qt::black, 4));         // 外描边
         p.drawText(tl + QPointF(2, -2), text);
         p.setPen(QPen(base.lighter(120), 1)); // 主色文字
@@ -368,11 +605,7 @@ void ImageCanvas::drawDetections(QPainter& p) const {
         if (isSel) {
             p.setPen(Qt::NoPen);
             for (int k = 0; k < 4; ++k) {
-                const QPointF w = imageToWidget(
-                    k == 0   ? d.p0
-                    : k == 1 ? d.p1
-                    : k == 2 ? d.p2
-                             : d.p3);
+                const QPointF w = poly[k];
                 const bool hot = (k == hoverHandle_ || k == dragHandle_);
                 QColor c       = hot ? base.lighter(120) : base;
                 p.setBrush(c);
@@ -425,34 +658,104 @@ void ImageCanvas::drawCrosshair(QPainter& p) const {
     p.drawLine(QPoint(int(R.left()), mousePosW_.y()), QPoint(int(R.right()), mousePosW_.y()));
     p.restore();
 }
-// 直方图均衡化
+QRegion ImageCanvas::crosshairDamageW() const {
+    if (!mouseInside_ || img_.isNull())
+        return {};
+    const QRect R = imageRectOnWidget().toAlignedRect();
+    if (!R.contains(mousePosW_))
+        return {};
+    QRegion r(QRect(mousePosW_.x() - 1, R.top(), 3, R.height()));
+    r += QRect(R.left(), mousePosW_.y() - 1, R.width(), 3);
+    return r;
+}
+
+QRect ImageCanvas::dragRectDamageW() const {
+    if (!(draggingRect_ && !dragRectImg_.isNull()))
+        return {};
+    return QRect(
+               imageToWidget(dragRectImg_.topLeft()).toPoint(),
+               imageToWidget(dragRectImg_.bottomRight()).toPoint())
+        .normalized()
+        .adjusted(-3, -3, 3, 3);
+}
+
+QRect ImageCanvas::detectionDamageW(int index) const {
+    if (index < 0 || index >= dets_.size())
+        return {};
+    const auto& d = dets_[index];
+    QRectF r      = polyW(index).boundingRect();
+
+    // 文字画在包围盒左上角上方（与 drawDetections 同字号，含 4px 描边）
+    QFont f = font();
+    f.setPointSizeF(f.pointSizeF() + 1);
+    const QFontMetrics fm(f);
+    const QString text = QString("%1%2").arg(d.color).arg(d.cls);
+    r |= QRectF(r.left(), r.top() - fm.height() - 6, fm.horizontalAdvance(text) + 10, fm.height() + 8);
+    r |= svgQuadW(d).boundingRect();
+
+    const int m = kHandleRadius_ + 4; // 角点圆 + 3px 轮廓 + 抗锯齿
+    return r.toAlignedRect().adjusted(-m, -m, m, m).intersected(rect());
+}
+
+// 显示调整（伽马 / 曝光 / 增益 / CLAHE）
 void ImageCanvas::histEqualize() {
-    cv::Mat res = qimageToMat(raw_img);
-    std::vector<cv::Mat> channels;
-    // 像素值
-    //  res.convertTo(res, -1, 2.2, 50);
-    // 直方图均衡化
-    //  cv::cvtColor(res, res, cv::COLOR_BGR2YCrCb);
-    //  cv::split(res, channels);
-    //  cv::equalizeHist(channels[0], channels[0]);
-    //  cv::merge(channels, res);
-    //  cv::cvtColor(res, res, cv::COLOR_YCrCb2RGB);
-    // 伽马矫正
-    auto createGammaLookUpTable = [](double gamma) {
-        cv::Mat lookUpTable(1, 256, CV_8U);
-        uchar* p = lookUpTable.ptr();
-        for (int i = 0; i < 256; ++i) {
-            // I_out = 255 * (I_in / 255)^gamma
-            p[i] = cv::saturate_cast<uchar>(pow(i / 255.0, gamma) * 255.0);
+    histEqOn_ = !histEqOn_;
+    refreshAdjustments();
+}
+
+void ImageCanvas::refreshAdjustments() {
+    const auto& st = controller::AppSettings::instance();
+    util::Adjustments adj;
+    adj.gamma     = st.adjustGamma();
+    adj.exposure  = st.adjustExposure();
+    adj.gain      = {st.adjustGainR(), st.adjustGainG(), st.adjustGainB()};
+    adj.claheClip = st.adjustClahe();
+    if (tiled_)
+        tiled_->setAdjustments(histEqOn_ ? std::optional(adj) : std::nullopt);
+
+    const quint64 gen = ++adjustGen_;
+    if (!histEqOn_ || frame_.isNull()) {
+        adjustPreview_ = QImage();
+        img_           = frame_.image(); // 关：原始像素一直在手里，不用算
+        update();
+        return;
+    }
+    const quint64 key = frame_.id();
+    if (!adjusted_.isNull() && adjustedFor_ == key && adjustedWith_ == adj) {
+        adjustPreview_ = QImage();
+        img_           = adjusted_.image();
+        update();
+        return;
+    }
+
+    // 升级/改参数时旧的调整结果仍可先顶着显示，免得闪回原始亮度
+    adjustPreview_ = adjusted_.image();
+    const QSize view = (imageRectOnWidget().size() * devicePixelRatioF()).toSize();
+    adjustPool_.clear();
+    adjustPool_.start([this, src = frame_, view, adj, key, gen] {
+        if (!view.isEmpty() && view.width() * 4 < src.size().width() * 3) {
+            // 先按视图分辨率出一张：像素数通常只有原图的零头，几毫秒就能换上
+            const QImage small = util::applyAdjustments(
+                src.image().scaled(view, Qt::KeepAspectRatio, Qt::SmoothTransformation), adj);
+            QMetaObject::invokeMethod(this, [this, small, gen] {
+                if (gen != adjustGen_)
+                    return;
+                adjustPreview_ = small;
+                update();
+            });
         }
-        return lookUpTable;
-    };
-    double gamma        = 0.4;
-    cv::Mat lookUpTable = createGammaLookUpTable(gamma);
-    // 使用 LUT 函数进行伽马校正，并将结果存储在 res 中
-    LUT(res, lookUpTable, res);
-    cv::cvtColor(res, res, cv::COLOR_BGR2RGB);
-    img_ = QImage(res.data, res.cols, res.rows, res.step, QImage::Format_RGB888).copy();
+        const Frame full(util::applyAdjustments(src.image(), adj), src.path(), src.fullSize());
+        QMetaObject::invokeMethod(this, [this, full, adj, key, gen] {
+            if (gen != adjustGen_ || key != frame_.id())
+                return;
+            adjusted_      = full;
+            adjustedFor_   = key;
+            adjustedWith_  = adj;
+            adjustPreview_ = QImage();
+            img_           = full.image();
+            update();
+        });
+    });
     update();
 }
 /* ===== 交互 ===== */
@@ -543,11 +846,13 @@ void ImageCanvas::createNewDetection() { // 画框
     currentClass_ = "";
     currentColor_ = "";
     dets_.append(a);
+    invalidateHitIndex();
     emit annotationCommitted(a);
     emit detectionUpdated(dets_.size() - 1, a);
     selectedIndex_ = dets_.size() - 1;
     emit detectionSelected(selectedIndex_);
     dragRectImg_ = QRect();
+    notifyEdited();
     update();
 }
 void ImageCanvas::mouseReleaseEvent(QMouseEvent* e) {
@@ -573,6 +878,7 @@ void ImageCanvas::mouseReleaseEvent(QMouseEvent* e) {
             dragHandle_ = -1;
             if (selectedIndex_ >= 0 && selectedIndex_ < dets_.size()) {
                 emit detectionUpdated(selectedIndex_, dets_[selectedIndex_]);
+                notifyEdited(); // 拖动结束才记一次脏
             }
             update();
             return;
@@ -587,8 +893,10 @@ void ImageCanvas::mouseReleaseEvent(QMouseEvent* e) {
 }
 
 void ImageCanvas::mouseMoveEvent(QMouseEvent* e) {
-    mousePosW_   = e->pos();
-    mouseInside_ = rect().contains(mousePosW_);
+    // 只重绘变化的部分：旧/新十字线、受影响的装甲板（含文字、角点、图标）、拖框
+    QRegion dirty = crosshairDamageW();
+    mousePosW_    = e->pos();
+    mouseInside_  = rect().contains(mousePosW_);
     // 拖动图片
     if (panning_) {
         const QPoint d = e->pos() - lastMousePos_;
@@ -599,14 +907,16 @@ void ImageCanvas::mouseMoveEvent(QMouseEvent* e) {
     }
     // 绘制辅助框
     if (draggingRect_) {
+        dirty += dragRectDamageW();
         QPoint a     = widgetToImage(dragRectStartW_).toPoint();
         QPoint b     = widgetToImage(e->pos()).toPoint();
         dragRectImg_ = QRect(a, b).normalized();
-        update();
+        update(dirty + dragRectDamageW() + crosshairDamageW());
         return;
     }
     // 拖动角点
     if (dragHandle_ >= 0 && selectedIndex_ >= 0 && selectedIndex_ < dets_.size()) {
+        dirty += detectionDamageW(selectedIndex_);
         auto& A                = dets_[selectedIndex_];
         const QPointF pi       = widgetToImage(e->pos());
         const auto ensureBound = [](int index) {
@@ -641,27 +951,33 @@ void ImageCanvas::mouseMoveEvent(QMouseEvent* e) {
             QPointF anotherPos = getPosByIndex(diagonP1) + getPosByIndex(diagonP2) - pi;
             setPosByIndex(another, anotherPos);
         }
+        invalidateHitIndex();
         // 不在移动中重排，避免把当前拖拽句柄“换角”
         emit detectionUpdated(selectedIndex_, A);
-        update();
+        update(dirty + detectionDamageW(selectedIndex_) + crosshairDamageW());
         return;
     }
 
     // 仅选中时更新悬停角点
+    const int oldHandle = hoverHandle_;
     if (selectedIndex_ >= 0 && selectedIndex_ < dets_.size()) {
         hoverHandle_ = hitHandleOnSelected(e->pos());
     } else {
         hoverHandle_ = -1;
     }
+    if (hoverHandle_ != oldHandle)
+        dirty += detectionDamageW(selectedIndex_);
 
     // 悬停命中（最后）
     const int hitNow = hitDetectionStrict(e->pos());
     if (hitNow != hoverIndex_) {
+        dirty += detectionDamageW(hoverIndex_);
+        dirty += detectionDamageW(hitNow);
         hoverIndex_ = hitNow;
         emit detectionHovered(hoverIndex_);
     }
 
-    update(); // 始终刷新（十字线/轻微移动也更新）
+    update(dirty + crosshairDamageW()); // 十字线每次都动，其余只在变化时带上
 }
 // 编辑颜色和类别
 void ImageCanvas::mouseDoubleClickEvent(QMouseEvent* e) {
@@ -710,6 +1026,7 @@ void ImageCanvas::leaveEvent(QEvent*) {
 
 void ImageCanvas::resizeEvent(QResizeEvent* e) {
     QWidget::resizeEvent(e);
+    emit viewportResized(size() * devicePixelRatioF());
     updateFitRect();
     update();
 }
@@ -721,7 +1038,7 @@ void ImageCanvas::updateFitRect() {
         return;
     }
     const QSizeF W = size();
-    QSizeF sc      = img_.size();
+    QSizeF sc      = imgSize_;
     sc.scale(W, Qt::KeepAspectRatio);
     const QPointF off((W.width() - sc.width()) / 2.0, (W.height() - sc.height()) / 2.0);
     fitRect_ = QRectF(off, sc);
@@ -739,17 +1056,17 @@ QPointF ImageCanvas::widgetToImage(const QPointF& p) const {
     const QRectF R = imageRectOnWidget();
     if (img_.isNull() || R.isEmpty())
         return {};
-    const double sx = img_.width() / R.width(), sy = img_.height() / R.height();
+    const double sx = imgSize_.width() / R.width(), sy = imgSize_.height() / R.height();
     QPointF pi((p.x() - R.x()) * sx, (p.y() - R.y()) * sy);
-    pi.setX(std::clamp(pi.x(), 0.0, double(img_.width() - 1)));
-    pi.setY(std::clamp(pi.y(), 0.0, double(img_.height() - 1)));
+    pi.setX(std::clamp(pi.x(), 0.0, double(imgSize_.width() - 1)));
+    pi.setY(std::clamp(pi.y(), 0.0, double(imgSize_.height() - 1)));
     return pi;
 }
 QPointF ImageCanvas::imageToWidget(const QPointF& p) const {
     const QRectF R = imageRectOnWidget();
     if (img_.isNull() || R.isEmpty())
         return {};
-    const double sx = R.width() / img_.width(), sy = R.height() / img_.height();
+    const double sx = R.width() / imgSize_.width(), sy = R.height() / imgSize_.height();
     return QPointF(R.x() + p.x() * sx, R.y() + p.y() * sy);
 }
 QRect ImageCanvas::widgetRectToImageRect(const QRect& rw) const {
@@ -761,17 +1078,16 @@ QRect ImageCanvas::widgetRectToImageRect(const QRect& rw) const {
 QRect ImageCanvas::clampRectToImage(const QRect& r) const {
     if (img_.isNull())
         return {};
-    return r.intersected(QRect(0, 0, img_.width(), img_.height()));
+    return r.intersected(QRect(QPoint(0, 0), imgSize_));
 }
 
 // 仅在“选中目标”上测试角点命中
 int ImageCanvas::hitHandleOnSelected(const QPoint& wpos) const {
     if (selectedIndex_ < 0 || selectedIndex_ >= dets_.size())
         return -1;
-    const auto& A = dets_[selectedIndex_];
-    const std::array<QPointF, 4> pts{A.p0, A.p1, A.p2, A.p3};
+    const QPolygonF& poly = polyW(selectedIndex_);
     for (int i = 0; i < 4; ++i) {
-        if (QLineF(imageToWidget(pts[i]), wpos).length() <= kHandleRadius_ * 1.6)
+        if (QLineF(poly[i], wpos).length() <= kHandleRadius_ * 1.6)
             return i;
     }
     return -1;
@@ -780,17 +1096,74 @@ int ImageCanvas::hitHandleOnSelected(const QPoint& wpos) const {
 int ImageCanvas::hitDetectionStrict(const QPoint& wpos) const {
     if (dets_.isEmpty())
         return -1;
+    ensureHitIndex();
+    const QPointF ip = widgetToImage(wpos);
+    const int cx     = int(std::floor((ip.x() - hit_.origin.x()) / hit_.cell));
+    const int cy     = int(std::floor((ip.y() - hit_.origin.y()) / hit_.cell));
+    if (cx < 0 || cy < 0 || cx >= hit_.cols || cy >= hit_.rows)
+        return -1;
     const QPointF w = wpos;
-    for (int i = dets_.size() - 1; i >= 0; --i) { // 逆序：前景优先
-        const auto& d = dets_[i];
-        QPolygonF poly;
-        poly << imageToWidget(d.p0) << imageToWidget(d.p1) << imageToWidget(d.p2)
-             << imageToWidget(d.p3);
-        if (pointInsidePolyW(poly, w))
-            return i;
+    const auto& cand = hit_.cells[cy * hit_.cols + cx];
+    for (auto it = cand.crbegin(); it != cand.crend(); ++it) { // 逆序：前景优先
+        if (hit_.bounds[*it].contains(ip) && pointInsidePolyW(polyW(*it), w))
+            return *it;
     }
     return -1;
 }
+
+// ---------- 命中索引 ----------
+void ImageCanvas::ensureHitIndex() const {
+    if (!hit_.dirty)
+        return;
+    hit_.dirty = false;
+    hit_.bounds.resize(dets_.size());
+    QRectF all(QPointF(0, 0), QSizeF(imgSize_));
+    for (int i = 0; i < dets_.size(); ++i) {
+        const auto& d  = dets_[i];
+        hit_.bounds[i] = QPolygonF{d.p0, d.p1, d.p2, d.p3}.boundingRect();
+        all |= hit_.bounds[i];
+    }
+    // 每格平均约一个标注；格子数封顶，避免极端尺寸下网格过大
+    const double area = std::max(1.0, all.width() * all.height());
+    hit_.cell   = std::max(kHitMinCell, std::sqrt(area / std::max<qsizetype>(1, dets_.size())));
+    hit_.origin = all.topLeft();
+    hit_.cols   = std::clamp(int(std::ceil(all.width() / hit_.cell)), 1, kHitMaxCells);
+    hit_.rows   = std::clamp(int(std::ceil(all.height() / hit_.cell)), 1, kHitMaxCells);
+    hit_.cell   = std::max({hit_.cell, all.width() / hit_.cols, all.height() / hit_.rows});
+    hit_.cells.assign(size_t(hit_.cols) * hit_.rows, {});
+    for (int i = 0; i < dets_.size(); ++i) {
+        const QRectF& b = hit_.bounds[i];
+        const int x0    = std::clamp(int((b.left() - hit_.origin.x()) / hit_.cell), 0, hit_.cols - 1);
+        const int x1    = std::clamp(int((b.right() - hit_.origin.x()) / hit_.cell), 0, hit_.cols - 1);
+        const int y0    = std::clamp(int((b.top() - hit_.origin.y()) / hit_.cell), 0, hit_.rows - 1);
+        const int y1    = std::clamp(int((b.bottom() - hit_.origin.y()) / hit_.cell), 0, hit_.rows - 1);
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+                hit_.cells[size_t(y) * hit_.cols + x].push_back(i); // 下标升序
+    }
+}
+
+const QPolygonF& ImageCanvas::polyW(int index) const {
+    // 视图（缩放/平移/适配）变了整体作废；标注变了由 invalidateHitIndex 作废
+    const QRectF view = imageRectOnWidget();
+    if (view != polysView_ || polysW_.size() != size_t(dets_.size())) {
+        polysView_ = view;
+        polysW_.assign(size_t(dets_.size()), QPolygonF());
+    }
+    QPolygonF& poly = polysW_[size_t(index)];
+    if (poly.isEmpty()) {
+        const auto& d = dets_[index];
+        poly = QPolygonF{imageToWidget(d.p0), imageToWidget(d.p1), imageToWidget(d.p2),
+                         imageToWidget(d.p3)};
+    }
+    return poly;
+}
+
+void ImageCanvas::invalidateHitIndex() {
+    hit_.dirty = true;
+    polysW_.clear();
+}
+
 bool ImageCanvas::pointInsidePolyW(const QPolygonF& polyW, const QPointF& w) const {
     return polyW.containsPoint(w, Qt::WindingFill);
 }
@@ -879,87 +1252,88 @@ static inline void splitClass(const QString& cls, QString& color, QString& type)
     type  = s.mid(1);            // "1","2","Bs","Bb",...
 }
 
+namespace {
+// 图标外框（viewBox）与横向贯穿的“锚点带”（SVG 坐标）：锚点带四角对齐装甲板 p0..p3
+struct SvgFrame {
+    QSizeF viewBox;
+    double anchorTop, anchorBottom;
+};
+constexpr SvgFrame kBigFrame{{871., 478.}, 140.61, 347.39};
+constexpr SvgFrame kSmallFrame{{557., 516.}, 143.26, 372.74};
+constexpr int kSvgMinRaster = 32;   // 栅格化边长下限 / 上限（像素）
+constexpr int kSvgMaxRaster = 2048;
+constexpr int kSvgMaxRasters = 32;  // 缓存的 (类型, 档位) 组合上限
+} // namespace
+
+QPolygonF ImageCanvas::svgQuadW(const Armor& a) const {
+    // 以锚点带为 [0,1]×[0,1] 时 viewBox 的上下沿
+    const SvgFrame& fr  = isBigType(a.cls) ? kBigFrame : kSmallFrame;
+    const double band   = fr.anchorBottom - fr.anchorTop;
+    const double top    = -fr.anchorTop / band;
+    const double bottom = (fr.viewBox.height() - fr.anchorTop) / band;
+    const QPolygonF unit{QPointF(0, 0), QPointF(0, 1), QPointF(1, 1), QPointF(1, 0)};
+    const QPolygonF dst{imageToWidget(a.p0), imageToWidget(a.p1), imageToWidget(a.p2),
+                        imageToWidget(a.p3)};
+    QTransform T;
+    if (!QTransform::quadToQuad(unit, dst, T))
+        return dst;
+    return T.map(QPolygonF{QPointF(0, top), QPointF(0, bottom), QPointF(1, bottom), QPointF(1, top)});
+}
+
+const QImage& ImageCanvas::svgRaster(const QString& type, int edge) const {
+    // 按 2 的幂分档：缩放变化不到一倍时沿用旧栅格，只有大幅缩放才重新栅格化
+    int bucket = kSvgMinRaster;
+    while (bucket < edge && bucket < kSvgMaxRaster)
+        bucket *= 2;
+    const QString key = QString("%1@%2").arg(type).arg(bucket);
+    auto it           = svgRasters_.constFind(key);
+    if (it != svgRasters_.cend())
+        return it.value();
+    if (svgRasters_.size() >= kSvgMaxRasters)
+        svgRasters_.clear(); // 档位很少：满了整体重来即可
+
+    QImage img;
+    if (QSvgRenderer* renderer = svgCache_.value(type); renderer && renderer->isValid()) {
+        const QSizeF vb = (isBigType(type) ? kBigFrame : kSmallFrame).viewBox;
+        const QSize size = (vb * (bucket / std::max(vb.width(), vb.height()))).toSize();
+        img = QImage(size, QImage::Format_ARGB32_Premultiplied);
+        img.fill(Qt::transparent);
+        QPainter q(&img);
+        q.setRenderHint(QPainter::Antialiasing, true);
+        renderer->render(&q, QRectF(img.rect())); // viewBox 拉伸铺满，与锚点换算一致
+    } else {
+        qWarning() << "SVG not found for type" << type;
+    }
+    return svgRasters_.insert(key, img).value();
+}
+
 void ImageCanvas::drawSvg(QPainter& p, const QVector<Armor>& armors) const {
     if (armors.isEmpty())
         return;
 
     p.save();
-
-    // ---- 1) 预备：两套 SVG 外框四角（viewBox）和两套“锚点”（全是 SVG 坐标，顺序 TL, BL, BR, TR）
-    QPolygonF big_svg_quad, small_svg_quad;
-    big_svg_quad << QPointF(0., 0.) << QPointF(0., 478.) << QPointF(871., 478.)
-                 << QPointF(871., 0.);
-    small_svg_quad << QPointF(0., 0.) << QPointF(0., 516.) << QPointF(557., 516.)
-                   << QPointF(557., 0.);
-
-    QPolygonF big_anchors, small_anchors; // TL, BL, BR, TR（单位：SVG）
-    big_anchors << QPointF(0., 140.61) << QPointF(0., 347.39) << QPointF(871., 347.39)
-                << QPointF(871., 140.61);
-    small_anchors << QPointF(0., 143.26) << QPointF(0., 372.74) << QPointF(557., 372.74)
-                  << QPointF(557., 143.26);
-
-    // 画布（控件）四角（顺序也用 TL, BL, BR, TR）
-    QPolygonF painter_quad;
-    painter_quad << QPointF(0., 0.) << QPointF(0., height()) << QPointF(width(), height())
-                 << QPointF(width(), 0.);
-
-    // 先把 SVG 外框四角 -> 画布四角，得到“把 SVG 坐标投到画布坐标”的仿射/投影
-    QTransform big_svg2painter, small_svg2painter;
-    QTransform::quadToQuad(big_svg_quad, painter_quad, big_svg2painter);
-    QTransform::quadToQuad(small_svg_quad, painter_quad, small_svg2painter);
-
-    // 把“SVG 的锚点”变到画布坐标（作为 quadToQuad 的 src）
-    const QPolygonF big_src_on_painter   = big_svg2painter.map(big_anchors);
-    const QPolygonF small_src_on_painter = small_svg2painter.map(small_anchors);
-
+    p.setRenderHint(QPainter::SmoothPixmapTransform, true);
+    const QTransform base = p.transform();
+    const double dpr      = devicePixelRatioF();
     for (const auto& a : armors) {
-        // —— 解析类别：取颜色 & 图案类型（用类型去找 svg）
-        QString color, type;
-        color = a.color;
-        type  = a.cls;
-        // splitClass(a.cls, color, type);
-        // qDebug() << "color=" << color << "type=" << type;
-
-        // 找到对应的 QSvgRenderer（建议你的 svgCache_ 用“类型名”做 key，比如
-        // "1","2","Bb","Bs","S","O"...）
-        auto it = svgCache_.find(type);
-        if (it == svgCache_.end() || it.value() == nullptr) {
-            qWarning() << "SVG not found for type" << type;
+        // 类别即图案类型（用来找 svg）；Armor 顺序 p0=TL, p1=BL, p2=BR, p3=TR
+        const QPolygonF quad = svgQuadW(a);
+        const QRectF bounds  = quad.boundingRect();
+        if (!paintRegion_.intersects(bounds.toAlignedRect()))
             continue;
-        }
-        QSvgRenderer* renderer = it.value();
-        if (!renderer->isValid())
+        const QImage& icon = svgRaster(a.cls, int(std::ceil(std::max(bounds.width(), bounds.height()) * dpr)));
+        if (icon.isNull())
             continue;
 
-        // —— 目标四点（画布坐标）；注意 Armor 的顺序：p0=TL, p1=BL, p2=BR, p3=TR
-        QPolygonF dst;
-        dst << imageToWidget(a.p0)  // TL
-            << imageToWidget(a.p1)  // BL
-            << imageToWidget(a.p2)  // BR
-            << imageToWidget(a.p3); // TR
-
-        // 选择 big/small 的“源四点”（同样是 TL, BL, BR, TR；已在画布坐标）
-        const QPolygonF& src = isBigType(type) ? big_src_on_painter : small_src_on_painter;
-
-        // —— 求单应 & 渲染
+        // 栅格四角 → 外框四角的单应；贴图代替逐帧解析/细分矢量路径
+        const double w = icon.width(), h = icon.height();
         QTransform H;
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        if (!QTransform::quadToQuad(src, dst, H))
+        if (!QTransform::quadToQuad(
+                QPolygonF{QPointF(0, 0), QPointF(0, h), QPointF(w, h), QPointF(w, 0)}, quad, H))
             continue;
-#else
-        if (!QTransform::quadToQuad(src, dst, H))
-            continue;
-#endif
-        p.save();
-        p.setRenderHint(QPainter::Antialiasing, true);
-        p.setTransform(H, true);
-        renderer->render(&p); // SVG 将按“锚点→目标四点”透视过去
-        p.restore();
-
-        // （可选）根据 color 设置边框主色等，你可以在别处画：B/R/G/P → 蓝/红/灰/紫
-        // 例如：if (color=="B") pen = blue; ...
+        p.setTransform(H * base);
+        p.drawImage(QPointF(0, 0), icon);
     }
-
     p.restore();
 }
 
@@ -1,11 +1,18 @@
 #pragma once
+#include "frame.hpp"
 #include "types.hpp"
+#include "util/image_adjust.hpp"
 #include <QImage>
 #include <QLabel>
+#include <QPixmap>
 #include <QPolygonF>
 #include <QRect>
+#include <QRegion>
 #include <QString>
+#include <QThreadPool>
 #include <QVector>
+#include <memory>
+#include <vector>
 #include <qimage.h>
 #include <qobject.h>
 #include <qvariant.h>
@@ -15,6 +22,7 @@ class QKeyEvent;
 class QMouseEvent;
 class QWheelEvent;
 class QSvgRenderer;
+class TiledImage;
 
 class ImageCanvas : public QLabel {
     Q_OBJECT
@@ -22,23 +30,44 @@ public:
     enum class RoiMode { Free, FixedToModelSize };
 
     explicit ImageCanvas(QWidget* parent = nullptr);
+    ~ImageCanvas() override;
 
     // 图像与 ROI
     bool loadImage(const QString& path);
     void setImage(const QImage& img);
+    void setFrame(const Frame& frame);
+    // 渐进显示：先给缩小解码的预览（frame.fullSize() 为原图尺寸，坐标系始终按原图），
+    // 原图解码完成后 upgradeFrame() 原地替换像素，不动标注与视图
+    void setPreviewFrame(const Frame& preview);
+    bool upgradeFrame(const Frame& full);
+    bool isPreview() const { return previewOnly_; }
+    // 超大图：overview 作为兜底底图，视野内按当前缩放层级分块解码（坐标系仍是原图）
+    void setTiledFrame(const Frame& overview);
+    bool isTiled() const { return bool(tiled_); }
+    QSize imageSize() const { return imgSize_; } // 原图尺寸（标注坐标系）
     const QImage& currentImage() const { return img_; }
+    const Frame& frame() const { return frame_; } // 未做调整的解码帧（预览阶段为预览像素）
     QString currentImagePath() const { return imgPath_; }
     void setModelInputSize(const QSize& s);
     void setRoiMode(RoiMode m);
     RoiMode roiMode() const { return roiMode_; }
     QRect roi() const { return roiImg_; }
     void clearRoi();
-    QImage cropRoi() const;
+    Frame cropRoi() const; // 与原帧共享缓冲区；有 Mask 落在里面时才复制
 
     // 视图
     void resetView();
     double scaleFactor() const { return scale_; }
 
+    // 绘制耗时统计：始终累计；开启 debug/perfLog 时每 kPaintStatsWindow 次重绘输出一次并清零
+    struct PaintStats {
+        int frames       = 0;
+        int rebuilds     = 0; // 缩放缓存重建次数
+        qint64 totalNs   = 0;
+        qint64 maxNs     = 0;
+    };
+    const PaintStats& paintStats() const { return paintStats_; }
+
 public slots:
     // 检测请求
     void requestDetect();
@@ -46,6 +75,9 @@ public slots:
 
     // 检测结果显示/外部读写
     void setDetections(const QVector<Armor>& dets);  // 覆盖全部
+    void applyDetections(const QVector<Armor>& dets); // 覆盖全部并视为一次编辑（检测结果）
+    // 检测器回来的结果：imagePath 与当前图片不同（请求后已翻页）时丢弃
+    void applyDetectionsFor(const QVector<Armor>& dets, const QString& imagePath);
     void clearDetections();
     void createNewDetection();                       // 新建一个Detction
     void addDetection(const Armor& a);               // (新建之后调用)追加一个
@@ -59,16 +91,17 @@ public slots:
     bool setSelectedClass(const QString& cls);                        // 改“选中框”的 cls
     bool setSelectedIndex(int idx);                                   // -1 取消选中
     int selectedIndex() const { return selectedIndex_; }
+    const QVector<Armor>& detections() const { return dets_; }
     // 更新颜色和类型
     void ProcessInfoChanged(const QString& EditedClass, const QString& Color, bool isCurrent);
-    void histEqualize();
+    void histEqualize(); // H：开关显示调整（参数见设置 view/adjust/*）
 signals:
     // ROI
     void roiChanged(const QRect& roiImg);
     void roiCommitted(const QRect& roiImg);
 
     // 检测请求
-    void detectRequested(const QImage& image);
+    void detectRequested(const Frame& frame);
 
     // 新框提交（松手即提交）
     void annotationCommitted(const Armor&);
@@ -81,6 +114,12 @@ signals:
 
     // 批量发布（供外部保存）
     void annotationsPublished(const QVector<Armor>& armors);
+    // 任意一次标注编辑后发出当前全部标注（供自动保存记脏）
+    void annotationsEdited(const QVector<Armor>& armors);
+    // 画布物理像素尺寸变化（预览解码按此选择目标尺寸）
+    void viewportResized(const QSize& devicePixels);
+    // 给用户看的提示（状态栏）
+    void status(const QString& msg, int ms);
 
 protected:
     // 绘制与交互
@@ -99,6 +138,11 @@ private:
     int hitHandleOnSelected(const QPoint& wpos) const; // 命中当前“选中目标”的角点
     int hitDetectionStrict(const QPoint& wpos) const;  // 严格在框内才算命中
     bool pointInsidePolyW(const QPolygonF& polyW, const QPointF& w) const;
+    // 命中索引：原图坐标均匀网格（标注变化时重建）+ 按视图缓存的控件坐标多边形
+    void ensureHitIndex() const;
+    const QPolygonF& polyW(int index) const;
+    void invalidateHitIndex(); // 标注几何变化后调用
+    void notifyEdited() { emit annotationsEdited(dets_); }
     // 编辑颜色和类别
     void promptEditSelectedInfo(bool isCurrent = false);
     void updateFitRect();
@@ -114,8 +158,19 @@ private:
     void drawDetections(QPainter& p) const; // 高亮选中/悬停 + 选中显示角点
     void drawDragRect(QPainter& p) const;   // 拖框预览
     void drawSvg(QPainter& p, const QVector<Armor>& armors) const;
+    // 局部重绘：各元素在控件上占据的范围（含描边、文字、角点、图标）
+    QRect detectionDamageW(int index) const;
+    QPolygonF svgQuadW(const Armor& a) const; // 图标 viewBox 投到控件上的四边形
+    const QImage& svgRaster(const QString& type, int edge) const; // 图标按屏幕尺寸分档栅格化
+    QRegion crosshairDamageW() const;
+    QRect dragRectDamageW() const;
     // 绘制Mask
     void drawMask(const QRect& recgt);
+    void drawMasks(QPainter& p) const;
+    void drawTiles(QPainter& p, const QRectF& R); // 分块模式：概览兜底 + 可见块
+    void drawZoomed(QPainter& p, const QRectF& R); // 底图：走缩放缓存，平移只贴图
+    QPixmap renderZoomWindow(const QSize& scaled, const QRect& window);
+    const QImage& mipFor(double factor);           // 缩小倍数超过 2 时取对应的 1/2^k 层
 
     // ROI 交互
     void beginFreeRoi(const QPoint& wpos);
@@ -123,14 +178,43 @@ private:
     void endFreeRoi();
     void placeFixedRoiAt(const QPoint& wpos);
     void setupSvg();
-    // 直方图均衡化
+    void resetImageState(); // 切图：清空标注/交互状态并重置视图
+    void adoptFrame(const Frame& frame, bool preview);
+    const Frame& detectSource() const; // 送检的像素：开着调整时为调整结果
+    Frame withMasks(const Frame& f, const QPoint& origin) const; // origin：f 左上角的原图坐标
+    // 按 histEqOn_ 刷新 img_：结果缓存命中即时生效，否则后台先出视图分辨率、再出原图
+    void refreshAdjustments();
+    const QImage& shownImage() const { return adjustPreview_.isNull() ? img_ : adjustPreview_; }
 
 private:
     // 图像
-    QImage raw_img;
-    // 处理后图像
+    Frame frame_; // 解码帧：像素只存这一份，未做调整时 img_ 与它共享
+    // 处理后图像（预览阶段分辨率低于 imgSize_）
     QImage img_;
     QString imgPath_;
+    QSize imgSize_;             // 原图尺寸：所有几何换算都以它为准
+    bool previewOnly_  = false; // 当前 img_ 只是预览
+    bool detectPending_ = false; // 预览阶段请求的检测，升级后补发
+    bool histEqOn_     = false; // 本张图开着显示调整，升级后重做
+    Frame adjusted_;              // frame_ 调整后的结果（再按 H 打开时直接用）
+    quint64 adjustedFor_ = 0;     // adjusted_ 对应的 frame_.id()
+    util::Adjustments adjustedWith_;
+    QImage adjustPreview_;        // 原图结果到达前显示的视图分辨率结果
+    QThreadPool adjustPool_;
+    quint64 adjustGen_ = 0;       // 切图/开关时递增，旧结果作废
+    QVector<QRect> masks_;        // Mask（原图坐标）：绘制时叠加，送检时落到像素上
+    std::unique_ptr<TiledImage> tiled_; // 分块模式的像素来源（img_ 只是概览）
+
+    // 缩放缓存：img_ 按当前缩放重采样好的一块窗口（视野外扩一屏），物理像素
+    QPixmap zoomCache_;
+    qint64 zoomCacheKey_ = 0; // 对应 img_.cacheKey()，像素被改过（均衡化、Mask、升级）即失效
+    QSize zoomCacheScaled_;   // 整图缩放后的物理尺寸
+    QRect zoomCacheWindow_;   // 缓存覆盖的范围（缩放后整图坐标）
+    QVector<QImage> mips_;    // img_ 的 1/2、1/4 … 层，按需生成
+    qint64 mipKey_ = 0;
+    PaintStats paintStats_;
+    bool perfLog_ = false; // AppSettings::perfLog，构造时读一次
+    QRegion paintRegion_; // 本次重绘的脏区（十字准心是细长的十字，外接矩形几乎是整图，不能用）
 
     // 视图
     double scale_ = 1.0;
@@ -166,11 +250,28 @@ private:
 
     QString currentClass_;
     QString currentColor_;
+    // 命中索引
+    struct HitIndex {
+        bool dirty = true;
+        QPointF origin;               // 网格左上角（原图坐标）
+        double cell = 1;              // 格子边长（原图像素）
+        int cols = 0, rows = 0;
+        std::vector<std::vector<int>> cells; // 每格内与之相交的标注下标（升序）
+        QVector<QRectF> bounds;       // 各标注包围盒（原图坐标）
+    };
+    mutable HitIndex hit_;
+    mutable std::vector<QPolygonF> polysW_; // 控件坐标四边形，空表示未算
+    mutable QRectF polysView_;              // polysW_ 对应的 imageRectOnWidget()
+
     QHash<QString, QSvgRenderer*> svgCache_;
+    mutable QHash<QString, QImage> svgRasters_; // "类型@边长" → 预乘 alpha 栅格
     // Mask
 
     // 参数
     const double kMinScale_  = 0.2;
     const double kMaxScale_  = 8.0;
     const int kHandleRadius_ = 6; // 角点渲染半径（像素，屏幕坐标）
+    static constexpr int kPaintStatsWindow = 300;
+    static constexpr double kHitMinCell = 16; // 网格最小格子（原图像素）
+    static constexpr int kHitMaxCells   = 256; // 每个方向最多格子数
 };
@@ -4,6 +4,7 @@
 #include <QAction>
 #include <QApplication>
 #include <QDateTime>
+#include <QDockWidget>
 #include <QHeaderView>
 #include <QImage>
 #include <QItemSelectionModel>
@@ -13,12 +14,17 @@
 #include <QMimeData>
 #include <QPixmap>
 #include <QPlainTextEdit>
+#include <QProgressBar>
+#include <QStatusBar>
+#include <QToolButton>
 #include <QStringListModel>
 #include <QTreeView>
 #include <QUrl>
+#include <algorithm>
 #include <qaction.h>
 #include <qmenu.h>
 
+#include "ui/filmstrip.hpp"
 #include "ui/image_canvas.hpp"
 
 using ui::MainWindow;
@@ -66,14 +72,49 @@ MainWindow::MainWindow(QWidget* parent)
     // 智能标注
     connect(this, &MainWindow::sigSmartAnnotateRequested, ui_->label, &ImageCanvas::requestDetect);
 
+    // 后台导入进度（默认隐藏）
+    progressBar_ = new QProgressBar(this);
+    progressBar_->setMaximumWidth(220);
+    progressBar_->setTextVisible(true);
+    progressBar_->hide();
+    progressCancel_ = new QToolButton(this);
+    progressCancel_->setText(tr("取消"));
+    progressCancel_->hide();
+    statusBar()->addPermanentWidget(progressBar_);
+    statusBar()->addPermanentWidget(progressCancel_);
+    connect(progressCancel_, &QToolButton::clicked, this, &MainWindow::sigTaskCancelRequested);
+
+    // 底部胶片条：模型由外部注入（依赖 FileService 的索引与缩略图缓存）
+    filmstrip_ = new Filmstrip(this);
+    auto* dock = new QDockWidget(tr("胶片条"), this);
+    dock->setObjectName("filmstripDock");
+    dock->setAllowedAreas(Qt::TopDockWidgetArea | Qt::BottomDockWidgetArea);
+    dock->setWidget(filmstrip_);
+    filmstrip_->setMinimumHeight(120);
+    addDockWidget(Qt::BottomDockWidgetArea, dock);
+    if (ui_->menuEdit)
+        ui_->menuEdit->addAction(dock->toggleViewAction());
+
     statusBar()->showMessage(tr("Ready"), 1200);
 }
 
 MainWindow::~MainWindow() = default;
 
 /* ---------------- 外部输入（更新 UI） ---------------- */
-void MainWindow::showImage(const QImage& img) {
-    ui_->label->setImage(img);
+void MainWindow::showImage(const Frame& frame) {
+    ui_->label->setFrame(frame);
+    ui_->label->setAlignment(Qt::AlignCenter);
+}
+
+void MainWindow::showPreview(const Frame& preview) {
+    ui_->label->setPreviewFrame(preview);
+    ui_->label->setAlignment(Qt::AlignCenter);
+}
+
+void MainWindow::upgradeImage(const Frame& full) { ui_->label->upgradeFrame(full); }
+
+void MainWindow::showTiled(const Frame& overview) {
+    ui_->label->setTiledFrame(overview);
     ui_->label->setAlignment(Qt::AlignCenter);
 }
 
@@ -137,6 +178,16 @@ void MainWindow::setRoot(const QModelIndex& idx) {
     emit sigTreeRootChanged(idx);
 }
 
+void MainWindow::setTaskProgress(int done, int total) {
+    const bool on = total >= 0;
+    progressBar_->setVisible(on);
+    progressCancel_->setVisible(on);
+    if (!on)
+        return;
+    progressBar_->setRange(0, std::max(total, 1));
+    progressBar_->setValue(done);
+}
+
 void MainWindow::setStatus(const QString& msg, int ms) { statusBar()->showMessage(msg, ms); }
 
 void MainWindow::setBusy(bool on) {
@@ -297,17 +348,29 @@ void MainWindow::setupActions() {
     ensureAction(ui_->actionHistEq, QKeySequence(Qt::Key_H), tr("Histogram Equalize (H)"));
     ensureAction(ui_->actionDelete, QKeySequence::Delete, tr("Delete"));
     ensureAction(ui_->actionSmart, QKeySequence(Qt::Key_Space), tr("Smart Annotate (Space)"));
+    ensureAction(ui_->actionPropagate, QKeySequence(Qt::Key_P), tr("Propagate to Next (P)"));
     ensureAction(ui_->actionSettings, {}, tr("Settings"));
 
     connect(ui_->actionOpen, &QAction::triggered, this, &MainWindow::sigOpenFolderRequested);
+    connect(ui_->actionOpenVideo, &QAction::triggered, this, &MainWindow::sigOpenVideoRequested);
     connect(ui_->actionSave, &QAction::triggered, this, &MainWindow::sigSaveRequested);
     connect(ui_->actionPrev, &QAction::triggered, this, &MainWindow::sigPrevRequested);
     connect(ui_->actionNext, &QAction::triggered, this, &MainWindow::sigNextRequested);
     connect(ui_->actionHistEq, &QAction::triggered, this, &MainWindow::sigHistEqRequested);
     connect(ui_->actionDelete, &QAction::triggered, this, &MainWindow::sigDeleteRequested);
     connect(ui_->actionSmart, &QAction::triggered, this, &MainWindow::sigSmartAnnotateRequested);
+    connect(ui_->actionPropagate, &QAction::triggered, this, &MainWindow::sigPropagateRequested);
     connect(ui_->actionSettings, &QAction::triggered, this, &MainWindow::sigSettingsRequested);
+    connect(ui_->actionStats, &QAction::triggered, this, &MainWindow::sigStatsRequested);
+    connect(
+        ui_->actionFindDuplicates, &QAction::triggered, this,
+        &MainWindow::sigFindDuplicatesRequested);
+    connect(ui_->actionQueryLabels, &QAction::triggered, this, &MainWindow::sigQueryLabelsRequested);
+    connect(ui_->actionPreAnnotate, &QAction::triggered, this, &MainWindow::sigPreAnnotateRequested);
+    connect(
+        ui_->actionSkipDuplicates, &QAction::toggled, this, &MainWindow::sigSkipDuplicatesToggled);
     connect(ui_->menuImport, &QMenu::triggered, this, &MainWindow::sigImportFolderRequested);
+    connect(ui_->menuExport, &QMenu::triggered, this, &MainWindow::sigExportRequested);
 }
 
 void MainWindow::wireButtonsToActions() {
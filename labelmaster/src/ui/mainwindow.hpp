@@ -14,10 +14,14 @@ class QDragEnterEvent;
 class QDropEvent;
 class QCloseEvent;
 class QStringListModel;
+class QProgressBar;
+class QToolButton;
 QT_END_NAMESPACE
 
 namespace ui {
 
+class Filmstrip;
+
 class MainWindow final : public QMainWindow {
     Q_OBJECT
 public:
@@ -28,18 +32,28 @@ public:
     void enableDragDrop(bool on = true);
     void setLogTimestampEnabled(bool on = true);
     auto ui() { return ui_.get(); }
+    Filmstrip* filmstrip() const { return filmstrip_; }
 
 signals:
     // —— 用户输出（语义化）——
     void sigOpenFolderRequested();
+    void sigOpenVideoRequested();
     void sigImportFolderRequested(const QAction* action);
+    void sigExportRequested(const QAction* action);
+    void sigTaskCancelRequested();
     void sigSaveRequested();
     void sigPrevRequested();
     void sigNextRequested();
     void sigHistEqRequested();
     void sigDeleteRequested();
     void sigSmartAnnotateRequested();
+    void sigPropagateRequested();
     void sigSettingsRequested();
+    void sigStatsRequested();
+    void sigFindDuplicatesRequested();
+    void sigQueryLabelsRequested();
+    void sigPreAnnotateRequested();
+    void sigSkipDuplicatesToggled(bool on);
     void sigFileActivated(const QModelIndex&);
     void sigDroppedPaths(const QStringList&);
     void sigKeyCommand(const QString&);
@@ -52,7 +66,10 @@ signals:
 
 public slots:
     // —— 外部输入（更新 UI）——
-    void showImage(const QImage& img);
+    void showImage(const Frame& frame);
+    void showPreview(const Frame& preview);
+    void upgradeImage(const Frame& full);
+    void showTiled(const Frame& overview);
     void appendLog(const QString& line);
     void setFileModel(QAbstractItemModel* model);
     void setCurrentIndex(const QModelIndex& idx);
@@ -60,6 +77,7 @@ public slots:
     void setBusy(bool on);
     void setUiEnabled(bool on);
     void setRoot(const QModelIndex& idx);
+    void setTaskProgress(int done, int total); // total < 0 隐藏进度条
 
     // —— 类别列表 —— 
     void setClassList(const QStringList& names);
@@ -84,6 +102,13 @@ private:
     // 类别
     QStringListModel* clsModel_ = nullptr;
     QString           currentClass_;
+
+    // 状态栏：后台任务进度
+    QProgressBar* progressBar_   = nullptr;
+    QToolButton* progressCancel_ = nullptr;
+
+    // 底部胶片条（停靠窗口）
+    Filmstrip* filmstrip_ = nullptr;
 };
 
 } // namespace ui
@@ -0,0 +1,35 @@
+#include "ui/stats_dialog.hpp"
+#include <QFontDatabase>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QScrollBar>
+#include <QVBoxLayout>
+
+using namespace ui;
+
+StatsDialog::StatsDialog(QWidget* parent)
+    : QDialog(parent) {
+    setWindowTitle(tr("数据集统计"));
+    resize(640, 560);
+
+    title_ = new QLabel(this);
+    text_  = new QPlainTextEdit(this);
+    text_->setReadOnly(true);
+    text_->setLineWrapMode(QPlainTextEdit::NoWrap);
+    text_->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont)); // 表格按列对齐
+
+    auto* layout = new QVBoxLayout(this);
+    layout->addWidget(title_);
+    layout->addWidget(text_);
+}
+
+void StatsDialog::setSnapshot(const DatasetStatsSnapshot& snapshot) {
+    // 保持滚动位置：增量更新频繁，跳回顶部会很烦
+    const int pos = text_->verticalScrollBar()->value();
+    text_->setPlainText(snapshot.toText());
+    text_->verticalScrollBar()->setValue(pos);
+}
+
+void StatsDialog::setRoot(const QString& root) {
+    title_->setText(root.isEmpty() ? tr("未打开数据集") : root);
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "service/dataset_stats.hpp"
+#include <QDialog>
+
+class QLabel;
+class QPlainTextEdit;
+
+namespace ui {
+
+// 数据集统计面板：只显示 DatasetStats 推送的快照，不做任何扫描
+class StatsDialog : public QDialog {
+    Q_OBJECT
+public:
+    explicit StatsDialog(QWidget* parent = nullptr);
+
+public slots:
+    void setSnapshot(const DatasetStatsSnapshot& snapshot);
+    void setRoot(const QString& root);
+
+private:
+    QLabel* title_        = nullptr;
+    QPlainTextEdit* text_ = nullptr;
+};
+
+} // namespace ui
@@ -0,0 +1,98 @@
+#pragma once
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace util {
+
+// 落盘策略：None 只依赖 rename 的原子性；File 额外 fsync 数据；FileAndDir 连目录项一起 fsync
+enum class FsyncPolicy : unsigned char { None = 0, File = 1, FileAndDir = 2 };
+
+inline FsyncPolicy fsyncPolicyFromInt(int v) {
+    switch (v) {
+    case 1: return FsyncPolicy::File;
+    case 2: return FsyncPolicy::FileAndDir;
+    default: return FsyncPolicy::None;
+    }
+}
+
+// 先写同目录下的临时文件，再 rename 覆盖目标：任何时刻目标要么是旧内容，要么是完整新内容
+inline bool writeFileAtomic(
+    const QString& path, const char* data, size_t size, FsyncPolicy policy = FsyncPolicy::None,
+    QString* error = nullptr) {
+    static std::atomic<unsigned> seq{0};
+
+    auto fail = [&](const char* what) {
+        if (error)
+            *error = QString("%1: %2").arg(what, QString::fromLocal8Bit(std::strerror(errno)));
+        return false;
+    };
+
+    const QByteArray dst = QFile::encodeName(path);
+    const QByteArray tmp = dst + ".tmp." + QByteArray::number(qint64(::getpid())) + '.'
+                         + QByteArray::number(seq.fetch_add(1, std::memory_order_relaxed));
+
+    const int fd = ::open(tmp.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return fail("open");
+
+    size_t off = 0;
+    while (off < size) {
+        const ssize_t n = ::write(fd, data + off, size - off);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            const int saved = errno;
+            ::close(fd);
+            ::unlink(tmp.constData());
+            errno = saved;
+            return fail("write");
+        }
+        off += size_t(n);
+    }
+
+    if (policy != FsyncPolicy::None && ::fsync(fd) != 0) {
+        const int saved = errno;
+        ::close(fd);
+        ::unlink(tmp.constData());
+        errno = saved;
+        return fail("fsync");
+    }
+    if (::close(fd) != 0) {
+        ::unlink(tmp.constData());
+        return fail("close");
+    }
+
+    if (::rename(tmp.constData(), dst.constData()) != 0) {
+        const int saved = errno;
+        ::unlink(tmp.constData());
+        errno = saved;
+        return fail("rename");
+    }
+
+    if (policy == FsyncPolicy::FileAndDir) {
+        const QByteArray dir = QFile::encodeName(QFileInfo(path).absolutePath());
+        const int dfd        = ::open(dir.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dfd >= 0) {
+            ::fsync(dfd);
+            ::close(dfd);
+        }
+    }
+    return true;
+}
+
+inline bool writeFileAtomic(
+    const QString& path, const QByteArray& bytes, FsyncPolicy policy = FsyncPolicy::None,
+    QString* error = nullptr) {
+    return writeFileAtomic(path, bytes.constData(), size_t(bytes.size()), policy, error);
+}
+
+} // namespace util
@@ -0,0 +1,72 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+inline int hammingDistance(std::uint64_t a, std::uint64_t b) { return std::popcount(a ^ b); }
+
+// 64 位哈希的 BK 树（汉明距离）：半径查询只访问 |d(node) - d(child)| <= r 的子树
+// 节点存在连续数组里，value 是调用方的编号（如图片序号）
+class BkTree {
+public:
+    void reserve(std::size_t n) { nodes_.reserve(n); }
+    std::size_t size() const { return nodes_.size(); }
+
+    void insert(std::uint64_t key, int value) {
+        const int id = int(nodes_.size());
+        nodes_.push_back({key, value, {}});
+        if (id == 0)
+            return;
+        int cur = 0;
+        for (;;) {
+            const int d = hammingDistance(key, nodes_[cur].key);
+            int next    = -1;
+            for (const auto& [dist, child] : nodes_[cur].children)
+                if (dist == d) {
+                    next = child;
+                    break;
+                }
+            if (next < 0) {
+                nodes_[cur].children.push_back({std::uint8_t(d), id});
+                return;
+            }
+            cur = next;
+        }
+    }
+
+    // 找到距离最近且 <= radius 的节点，返回 {value, 距离}；没有时 value = -1
+    std::pair<int, int> nearest(std::uint64_t key, int radius) const {
+        std::pair<int, int> best{-1, radius + 1};
+        if (nodes_.empty())
+            return best;
+        std::vector<int> stack{0};
+        while (!stack.empty()) {
+            const Node& n = nodes_[stack.back()];
+            stack.pop_back();
+            const int d = hammingDistance(key, n.key);
+            if (d < best.second)
+                best = {n.value, d};
+            const int r = std::min(radius, best.second - 1); // 已有更近的结果时收紧
+            for (const auto& [dist, child] : n.children)
+                if (dist >= d - r && dist <= d + r)
+                    stack.push_back(child);
+        }
+        if (best.first < 0)
+            best.second = -1;
+        return best;
+    }
+
+private:
+    struct Node {
+        std::uint64_t key;
+        int value;
+        std::vector<std::pair<std::uint8_t, int>> children; // (到本节点的距离, 子节点)
+    };
+    std::vector<Node> nodes_;
+};
+
+} // namespace util
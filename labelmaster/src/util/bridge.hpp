@@ -1,33 +1,115 @@
 #pragma once
 #include <opencv2/imgproc.hpp>
 #include <QImage>
+#include <QtGlobal>
 
-inline cv::Mat qimageToMat(const QImage& img, cv::ColorConversionCodes convertCode = cv::COLOR_RGB2BGR) {
+#include <cstdint>
+
+namespace util {
+
+// 像素在内存中的字节顺序（与 QImage::Format 的“名字”不同：RGB32/ARGB32 在小端上是 B,G,R,A）
+enum class PixelOrder : unsigned char { Unsupported, Gray, RGB, BGR, RGBA, BGRA };
+
+// 本线程经桥接产生的整帧拷贝字节数（包括格式转换），用于统计每次检测的拷贝量
+inline thread_local std::uint64_t bridgeBytesCopied = 0;
+
+inline PixelOrder pixelOrderOf(QImage::Format f) {
+    switch (f) {
+    case QImage::Format_Grayscale8: return PixelOrder::Gray;
+    case QImage::Format_RGB888: return PixelOrder::RGB;
+    case QImage::Format_BGR888: return PixelOrder::BGR;
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888: return PixelOrder::RGBA;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32: return PixelOrder::BGRA;
+#endif
+    default: return PixelOrder::Unsupported;
+    }
+}
+
+// QImage 的只读 Mat 视图：owner 是一份浅拷贝，只要视图还在像素就不会被释放或改写。
+// mat 不可写——缓冲区可能与别的 QImage 共享；需要改像素请先 clone
+struct ImageView {
+    QImage owner;
+    cv::Mat mat;
+    PixelOrder order = PixelOrder::Unsupported;
+    bool empty() const { return mat.empty(); }
+};
+
+inline ImageView viewOf(const QImage& img) {
+    ImageView v;
+    if (img.isNull())
+        return v;
+    v.order = pixelOrderOf(img.format());
+    if (v.order == PixelOrder::Unsupported) {
+        // 少见格式（索引色、16 位等）：只能转一次
+        v.owner = img.convertToFormat(QImage::Format_RGB888);
+        v.order = PixelOrder::RGB;
+        bridgeBytesCopied += std::uint64_t(v.owner.sizeInBytes());
+    } else {
+        v.owner = img; // 浅拷贝，不复制像素
+    }
+    const int type = v.order == PixelOrder::Gray                                     ? CV_8UC1
+                   : (v.order == PixelOrder::RGB || v.order == PixelOrder::BGR) ? CV_8UC3
+                                                                                     : CV_8UC4;
+    // constBits() 不会触发 detach
+    v.mat = cv::Mat(v.owner.height(), v.owner.width(), type, const_cast<uchar*>(v.owner.constBits()),
+                    size_t(v.owner.bytesPerLine()));
+    return v;
+}
+
+// from → 3 通道（BGR 或 RGB）所需的 cvtColor 代码，-1 表示无需转换
+inline int cvtCodeTo3(PixelOrder from, bool wantRgb) {
+    switch (from) {
+    case PixelOrder::Gray: return cv::COLOR_GRAY2BGR; // 灰度三通道相同，顺序无所谓
+    case PixelOrder::RGB: return wantRgb ? -1 : cv::COLOR_RGB2BGR;
+    case PixelOrder::BGR: return wantRgb ? cv::COLOR_BGR2RGB : -1;
+    case PixelOrder::RGBA: return wantRgb ? cv::COLOR_RGBA2RGB : cv::COLOR_RGBA2BGR;
+    case PixelOrder::BGRA: return wantRgb ? cv::COLOR_BGRA2RGB : cv::COLOR_BGRA2BGR;
+    default: return -1;
+    }
+}
+
+} // namespace util
+
+// QImage → 独立的 BGR Mat：一次融合的通道重排直接写进目标（原先要三次整帧拷贝）
+inline cv::Mat qimageToMat(const QImage& img) {
     if (img.isNull()) return {};
-    QImage converted = img.convertToFormat(QImage::Format_RGB888);
-    cv::Mat mat(converted.height(), converted.width(), CV_8UC3,
-                const_cast<uchar*>(converted.bits()), converted.bytesPerLine());
-    cv::Mat bgr;
-    cv::cvtColor(mat, bgr, convertCode);
-    return bgr.clone();
+    const util::ImageView v = util::viewOf(img);
+    const int code          = util::cvtCodeTo3(v.order, false);
+    cv::Mat out;
+    if (code < 0)
+        out = v.mat.clone();
+    else
+        cv::cvtColor(v.mat, out, code);
+    util::bridgeBytesCopied += std::uint64_t(out.total() * out.elemSize());
+    return out;
 }
 
+// cv::Mat → QImage：能直接解释的布局零拷贝包一层（QImage 持有 Mat 的引用计数，析构时释放），
+// 否则一次转换写进新 Mat 再包。包好之后调用方不要再原地改写 m 的像素
 inline QImage matToQImage(const cv::Mat& m) {
     if (m.empty()) return {};
-    cv::Mat rgb;
-    if (m.type() == CV_8UC3) {
-        cv::cvtColor(m, rgb, cv::COLOR_BGR2RGB);
-        return QImage(rgb.data, rgb.cols, rgb.rows, rgb.step, QImage::Format_RGB888).copy();
-    } else if (m.type() == CV_8UC4) {
-        // 假定 BGRA
-        cv::cvtColor(m, rgb, cv::COLOR_BGRA2RGBA);
-        return QImage(rgb.data, rgb.cols, rgb.rows, rgb.step, QImage::Format_RGBA8888).copy();
-    } else if (m.type() == CV_8UC1) {
-        return QImage(m.data, m.cols, m.rows, m.step, QImage::Format_Grayscale8).copy();
-    } {
-        cv::Mat tmp;
-        m.convertTo(tmp, CV_8UC3);
-        cv::cvtColor(tmp, rgb, cv::COLOR_BGR2RGB);
-        return QImage(rgb.data, rgb.cols, rgb.rows, rgb.step, QImage::Format_RGB888).copy();
+    cv::Mat src = m;
+    QImage::Format fmt;
+    switch (m.type()) {
+    case CV_8UC3: fmt = QImage::Format_BGR888; break;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    case CV_8UC4: fmt = QImage::Format_ARGB32; break; // BGRA 字节序
+#endif
+    case CV_8UC1: fmt = QImage::Format_Grayscale8; break;
+    default:
+        m.convertTo(src, CV_8UC3);
+        if (src.channels() != 3)
+            cv::cvtColor(src, src, src.channels() == 1 ? cv::COLOR_GRAY2BGR : cv::COLOR_BGRA2BGR);
+        util::bridgeBytesCopied += std::uint64_t(src.total() * src.elemSize());
+        fmt = QImage::Format_BGR888;
+        break;
     }
+    auto* keep = new cv::Mat(src); // 引用计数 +1，随 QImage 最后一份拷贝释放
+    // const 数据构造：任何写访问都会先深拷贝，不会改到 Mat 的共享缓冲区
+    return QImage(
+        static_cast<const uchar*>(keep->data), keep->cols, keep->rows, qsizetype(keep->step), fmt,
+        [](void* p) { delete static_cast<cv::Mat*>(p); }, keep);
 }
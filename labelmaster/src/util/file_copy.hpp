@@ -0,0 +1,91 @@
+#pragma once
+#include <QFile>
+#include <QString>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace util {
+
+// 内核内拷贝（copy_file_range），不经过用户态缓冲；不支持时退回 read/write
+inline bool copyFileFast(const QString& src, const QString& dst) {
+    const QByteArray s = QFile::encodeName(src);
+    const QByteArray d = QFile::encodeName(dst);
+    const int in       = ::open(s.constData(), O_RDONLY | O_CLOEXEC);
+    if (in < 0)
+        return false;
+    struct stat st{};
+    if (::fstat(in, &st) != 0) {
+        ::close(in);
+        return false;
+    }
+    const int out = ::open(d.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+
+    bool ok       = true;
+    off_t left    = st.st_size;
+    bool fallback = false;
+    while (left > 0) {
+        const ssize_t n = ::copy_file_range(in, nullptr, out, nullptr, size_t(left), 0);
+        if (n > 0) {
+            left -= n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP || errno == EINVAL))
+            fallback = true; // 跨文件系统/老内核
+        else if (n < 0)
+            ok = false;
+        break;
+    }
+    if (ok && fallback) {
+        char buf[1 << 16];
+        for (;;) {
+            const ssize_t r = ::read(in, buf, sizeof(buf));
+            if (r == 0)
+                break;
+            if (r < 0) {
+                if (errno == EINTR)
+                    continue;
+                ok = false;
+                break;
+            }
+            for (ssize_t off = 0; off < r;) {
+                const ssize_t w = ::write(out, buf + off, size_t(r - off));
+                if (w < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    ok = false;
+                    break;
+                }
+                off += w;
+            }
+            if (!ok)
+                break;
+        }
+    }
+    ::close(in);
+    if (::close(out) != 0)
+        ok = false;
+    if (!ok)
+        ::unlink(d.constData());
+    return ok;
+}
+
+// 优先硬链接（零拷贝），跨文件系统时退回 copyFileFast；目标已存在则先删除
+inline bool linkOrCopyFile(const QString& src, const QString& dst, bool allowLink = true) {
+    const QByteArray s = QFile::encodeName(src);
+    const QByteArray d = QFile::encodeName(dst);
+    ::unlink(d.constData());
+    if (allowLink && ::link(s.constData(), d.constData()) == 0)
+        return true;
+    return copyFileFast(src, dst);
+}
+
+} // namespace util
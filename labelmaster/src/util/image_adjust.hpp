@@ -0,0 +1,68 @@
+#pragma once
+#include <QImage>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace util {
+
+// 可组合的显示调整：CLAHE（只作用于亮度）→ 曝光 → 通道增益 → 伽马。
+// 后三级都是逐通道的逐像素映射，合成一张 3 通道 256 项的表，一次 cv::LUT 完成（SIMD + 多线程）
+struct Adjustments {
+    double gamma     = 1.0;                // 输出 = 输入^gamma（<1 提亮暗部）
+    double exposure  = 0.0;                // EV：乘 2^exposure
+    std::array<double, 3> gain{1.0, 1.0, 1.0}; // R / G / B
+    double claheClip = 0.0;                // >0 时做 CLAHE，clipLimit
+
+    bool operator==(const Adjustments&) const = default;
+};
+
+// 合成后的表（CV_8UC3，1×256，通道顺序 R, G, B）；同一线程内参数不变时复用
+inline const cv::Mat& fusedLut(const Adjustments& a) {
+    thread_local Adjustments key;
+    thread_local cv::Mat lut;
+    if (!lut.empty() && key == a)
+        return lut;
+    key = a;
+    lut.create(1, 256, CV_8UC3);
+    const double ev = std::exp2(a.exposure);
+    for (int i = 0; i < 256; ++i) {
+        cv::Vec3b& v = lut.at<cv::Vec3b>(i);
+        for (int c = 0; c < 3; ++c) {
+            const double x = std::clamp(i / 255.0 * ev * a.gain[size_t(c)], 0.0, 1.0);
+            v[c]           = cv::saturate_cast<uchar>(std::pow(x, a.gamma) * 255.0);
+        }
+    }
+    return lut;
+}
+
+// 返回新图（RGB888），src 不变
+inline QImage applyAdjustments(const QImage& src, const Adjustments& a) {
+    if (src.isNull())
+        return {};
+    const QImage rgb = src.convertToFormat(QImage::Format_RGB888); // 已是 RGB888 时不复制
+    cv::Mat in(rgb.height(), rgb.width(), CV_8UC3, const_cast<uchar*>(rgb.constBits()),
+               rgb.bytesPerLine());
+    cv::Mat equalized;
+    if (a.claheClip > 0) {
+        cv::Mat lab;
+        cv::cvtColor(in, lab, cv::COLOR_RGB2Lab);
+        std::vector<cv::Mat> ch;
+        cv::split(lab, ch);
+        thread_local cv::Ptr<cv::CLAHE> clahe = cv::createCLAHE();
+        clahe->setClipLimit(a.claheClip);
+        clahe->apply(ch[0], ch[0]);
+        cv::merge(ch, lab);
+        cv::cvtColor(lab, equalized, cv::COLOR_Lab2RGB);
+        in = equalized;
+    }
+    QImage out(rgb.size(), QImage::Format_RGB888);
+    cv::Mat dst(out.height(), out.width(), CV_8UC3, out.bits(), out.bytesPerLine());
+    cv::LUT(in, fusedLut(a), dst); // 直接写进 QImage 的缓冲区
+    return out;
+}
+
+} // namespace util
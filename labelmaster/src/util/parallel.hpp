@@ -0,0 +1,53 @@
+#pragma once
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+
+namespace util {
+
+// 工作线程数：不超过线程池上限，也不超过块数
+inline int parallelWorkers(const QThreadPool& pool, qsizetype n, qsizetype grain) {
+    grain = std::max<qsizetype>(1, grain);
+    return int(std::clamp<qsizetype>((n + grain - 1) / grain, 1, std::max(1, pool.maxThreadCount())));
+}
+
+// 把 [0, n) 按 grain 动态分块交给线程池，阻塞到全部完成。
+// fn 可以是 fn(i) 或 fn(worker, i)：worker ∈ [0, parallelWorkers())，便于做无锁的分片累加。
+// cancel 置位后尚未领取的块直接跳过。不要在同一个 pool 的任务里调用（会占满线程死锁）。
+template <class Fn>
+void parallelFor(
+    QThreadPool& pool, qsizetype n, qsizetype grain, Fn&& fn,
+    const std::atomic_bool* cancel = nullptr) {
+    if (n <= 0)
+        return;
+    grain             = std::max<qsizetype>(1, grain);
+    const int workers = parallelWorkers(pool, n, grain);
+    std::atomic<qsizetype> next{0};
+    QSemaphore done;
+
+    for (int w = 0; w < workers; ++w) {
+        pool.start([&, w] {
+            for (;;) {
+                if (cancel && cancel->load(std::memory_order_relaxed))
+                    break;
+                const qsizetype b = next.fetch_add(grain, std::memory_order_relaxed);
+                if (b >= n)
+                    break;
+                const qsizetype e = std::min(n, b + grain);
+                for (qsizetype i = b; i < e; ++i) {
+                    if constexpr (std::is_invocable_v<Fn&, int, qsizetype>)
+                        fn(w, i);
+                    else
+                        fn(i);
+                }
+            }
+            done.release();
+        });
+    }
+    done.acquire(workers);
+}
+
+} // namespace util
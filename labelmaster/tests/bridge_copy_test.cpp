@@ -0,0 +1,81 @@
+// ===============================
+// File: tests/bridge_copy_test.cpp
+// ===============================
+// QImage ↔ cv::Mat 桥接的拷贝量与耗时：对每种支持的格式断言
+// viewOf / qimageToMat / matToQImage 前后 util::bridgeBytesCopied 的增量，计时只打印供参考
+#include "util/bridge.hpp"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QImage>
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+
+namespace {
+int g_failures = 0;
+
+#define CHECK_EQ(actual, expected)                                                                 \
+    do {                                                                                           \
+        const auto a_ = (actual);                                                                  \
+        const auto e_ = (expected);                                                                \
+        if (a_ != e_) {                                                                            \
+            std::fprintf(stderr, "%s:%d: %s == %llu, expected %llu\n", __FILE__, __LINE__,         \
+                         #actual, (unsigned long long)a_, (unsigned long long)e_);                 \
+            ++g_failures;                                                                          \
+        }                                                                                          \
+    } while (0)
+
+// 运行 fn，返回它在本线程产生的桥接拷贝字节数，并打印耗时
+std::uint64_t measure(const char* name, const std::function<void()>& fn) {
+    const std::uint64_t before = util::bridgeBytesCopied;
+    QElapsedTimer t;
+    t.start();
+    fn();
+    const double ms           = t.nsecsElapsed() / 1e6;
+    const std::uint64_t bytes = util::bridgeBytesCopied - before;
+    std::printf("%-28s %10.2f ms  %12llu B\n", name, ms, (unsigned long long)bytes);
+    return bytes;
+}
+} // namespace
+
+int main() {
+    // 12 MP
+    constexpr int W = 4000, H = 3000;
+    constexpr std::uint64_t kFrame3 = std::uint64_t(W) * H * 3;
+
+    QImage rgb32(W, H, QImage::Format_RGB32);
+    rgb32.fill(Qt::darkCyan);
+    // 每种直接支持的格式：viewOf 零拷贝，qimageToMat 恰好一帧 BGR
+    for (const QImage::Format f :
+         {QImage::Format_RGB32, QImage::Format_ARGB32, QImage::Format_RGB888, QImage::Format_BGR888,
+          QImage::Format_RGBX8888, QImage::Format_RGBA8888, QImage::Format_Grayscale8}) {
+        const QImage img    = rgb32.convertToFormat(f);
+        const QByteArray fn = QByteArray::number(int(f));
+        CHECK_EQ(measure(("viewOf(fmt " + fn + ")").constData(), [&] { util::viewOf(img); }), 0u);
+        CHECK_EQ(measure(("qimageToMat(fmt " + fn + ")").constData(), [&] { qimageToMat(img); }), kFrame3);
+    }
+
+    // 少见格式：viewOf 恰好一次转换
+    const QImage mono = rgb32.convertToFormat(QImage::Format_Mono);
+    CHECK_EQ(measure("viewOf(Mono)", [&] { util::viewOf(mono); }), kFrame3);
+
+    // Mat → QImage：8 位布局直接包一层，其余一次转换
+    cv::Mat bgr(H, W, CV_8UC3, cv::Scalar(1, 2, 3));
+    cv::Mat bgra(H, W, CV_8UC4, cv::Scalar(1, 2, 3, 255));
+    cv::Mat gray8(H, W, CV_8UC1, cv::Scalar(7));
+    cv::Mat wide(H, W, CV_16UC3, cv::Scalar(1, 2, 3));
+    CHECK_EQ(measure("matToQImage(8UC3)", [&] { matToQImage(bgr); }), 0u);
+    CHECK_EQ(measure("matToQImage(8UC4)", [&] { matToQImage(bgra); }), 0u);
+    CHECK_EQ(measure("matToQImage(8UC1)", [&] { matToQImage(gray8); }), 0u);
+    CHECK_EQ(measure("matToQImage(16UC3)", [&] { matToQImage(wide); }), kFrame3);
+
+    // 零拷贝包装的 QImage 与 Mat 共享像素
+    const QImage wrapped = matToQImage(bgr);
+    CHECK_EQ(std::uintptr_t(wrapped.constBits()), std::uintptr_t(bgr.data));
+
+    if (g_failures)
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return g_failures ? 1 : 0;
+}